@@ -72,6 +72,7 @@ const defaultSidebar = [
           { text: "AST Nodes", link: "/c-reference/nodes" },
           { text: "Enums", link: "/c-reference/enums" },
           { text: "Enum Values", link: "/c-reference/enum-values" },
+          { text: "Serialization", link: "/c-reference/serialization" },
         ],
       },
       {
@@ -1,4 +1,5 @@
 #include <ruby.h>
+#include <ruby/thread.h>
 
 #include "error_helpers.h"
 #include "extension.h"
@@ -7,6 +8,8 @@
 
 #include "../../src/include/analyze.h"
 
+#include <string.h>
+
 VALUE mHerb;
 VALUE cPosition;
 VALUE cLocation;
@@ -15,106 +18,408 @@ VALUE cToken;
 VALUE cResult;
 VALUE cLexResult;
 VALUE cParseResult;
+VALUE cLineIndex;
+VALUE cTokenStream;
 
-static VALUE Herb_lex(VALUE self, VALUE source) {
-  char* string = (char*) check_string(source);
+// The C work of a method that runs without the GVL. `function` must not touch Ruby objects.
+typedef struct NOGVL_CALL_STRUCT {
+  void (*function)(struct NOGVL_CALL_STRUCT* call);
+  volatile bool interrupted; // set when Ruby interrupts the thread, see parse_call_interrupted()
+  bool done;                 // whether `function` ran to the end without being interrupted
+} nogvl_call_T;
+
+static void* nogvl_call_run(void* data) {
+  nogvl_call_T* call = (nogvl_call_T*) data;
+  call->function(call);
+
+  return NULL;
+}
+
+static void nogvl_call_unblock(void* data) {
+  ((nogvl_call_T*) data)->interrupted = true;
+}
 
-  hb_array_T* tokens = herb_lex(string);
+// Runs `call->function` with the GVL released, so other Ruby threads keep running while the
+// source is lexed or parsed. If Ruby interrupts the thread (Thread#raise, Timeout, a signal)
+// and the function stops early, the interrupt is handled right away; if that doesn't raise,
+// the function runs again with the GVL held.
+static void call_without_gvl(nogvl_call_T* call) {
+  rb_thread_call_without_gvl2(nogvl_call_run, call, nogvl_call_unblock, call);
 
-  VALUE result = create_lex_result(tokens, source);
+  if (call->done) { return; }
+
+  rb_thread_check_ints();
+
+  call->interrupted = false;
+  call->function(call);
+}
+
+// A frozen string with the bytes of `source`, or nil. Other threads may modify `source` while
+// the GVL is released, the frozen string keeps the original bytes. Callers keep it on the stack
+// with RB_GC_GUARD(), which also stops GC compaction from moving it.
+static VALUE pin_source(VALUE source) {
+  check_string(source);
+
+  return NIL_P(source) ? Qnil : rb_str_new_frozen(source);
+}
 
-  herb_free_tokens(&tokens);
+typedef struct {
+  nogvl_call_T base;
+  const char* source;
+  size_t length;
+  hb_array_T* tokens;
+} lex_call_T;
+
+static void lex_call_function(nogvl_call_T* base) {
+  lex_call_T* call = (lex_call_T*) base;
+
+  call->tokens = herb_lex_n(call->source, call->length);
+  base->done = true;
+}
+
+static VALUE lex_source(VALUE source) {
+  VALUE pinned = pin_source(source);
+  lex_call_T call = {
+    .base = { .function = lex_call_function },
+    .source = check_string(pinned),
+    .length = check_string_length(pinned),
+  };
+
+  call_without_gvl(&call.base);
+
+  VALUE result = create_lex_result(call.tokens, source);
+
+  herb_free_tokens(&call.tokens);
+  RB_GC_GUARD(pinned);
 
   return result;
 }
 
+static VALUE Herb_lex(VALUE self, VALUE source) {
+  return lex_source(source);
+}
+
 static VALUE Herb_lex_file(VALUE self, VALUE path) {
   char* file_path = (char*) check_string(path);
-  hb_array_T* tokens = herb_lex_file(file_path);
 
-  VALUE source_value = read_file_to_ruby_string(file_path);
-  VALUE result = create_lex_result(tokens, source_value);
+  return lex_source(read_file_to_ruby_string(file_path));
+}
 
-  herb_free_tokens(&tokens);
+// Cancel callback of the parses below, so an interrupted thread stops parsing early.
+static bool parse_call_interrupted(void* data) {
+  return ((nogvl_call_T*) data)->interrupted;
+}
+
+typedef struct {
+  nogvl_call_T base;
+  const char* source;
+  size_t length;
+  parser_options_T options;
+  AST_DOCUMENT_NODE_T* document;
+} parse_call_T;
+
+static void parse_call_function(nogvl_call_T* base) {
+  parse_call_T* call = (parse_call_T*) base;
+
+  parser_options_T options = call->options;
+  options.cancel = parse_call_interrupted;
+  options.cancel_data = base;
+
+  AST_DOCUMENT_NODE_T* document = herb_parse_n(call->source, call->length, &options);
+  herb_analyze_parse_tree_cancellable_n(document, call->source, call->length, options.cancel, options.cancel_data);
+
+  if (document->cancelled) {
+    ast_node_free((AST_NODE_T*) document);
+    return;
+  }
+
+  call->document = document;
+  base->done = true;
+}
+
+static VALUE parse_source(VALUE source, parser_options_T options) {
+  VALUE pinned = pin_source(source);
+  VALUE document = document_wrapper_new(pinned);
+  parse_call_T call = {
+    .base = { .function = parse_call_function },
+    .source = check_string(pinned),
+    .length = check_string_length(pinned),
+    .options = options,
+  };
+
+  call_without_gvl(&call.base);
+  document_wrapper_set(document, call.document);
+
+  VALUE result = create_parse_result(document, source);
+  RB_GC_GUARD(document);
 
   return result;
 }
 
-static VALUE Herb_parse(int argc, VALUE* argv, VALUE self) {
-  VALUE source, options;
-  rb_scan_args(argc, argv, "1:", &source, &options);
+static VALUE lookup_option(VALUE options, const char* name) {
+  if (NIL_P(options)) { return Qnil; }
 
-  char* string = (char*) check_string(source);
+  VALUE value = rb_hash_lookup(options, rb_utf8_str_new_cstr(name));
+  if (NIL_P(value)) { value = rb_hash_lookup(options, ID2SYM(rb_intern(name))); }
 
-  parser_options_T* parser_options = NULL;
-  parser_options_T opts = { 0 };
+  return value;
+}
 
-  if (!NIL_P(options)) {
-    VALUE track_whitespace = rb_hash_lookup(options, rb_utf8_str_new_cstr("track_whitespace"));
-    if (NIL_P(track_whitespace)) { track_whitespace = rb_hash_lookup(options, ID2SYM(rb_intern("track_whitespace"))); }
+static parser_options_T read_parser_options(VALUE options) {
+  // The AST is freed as a whole once its Ruby nodes are garbage collected, so it can live in an arena.
+  parser_options_T opts = { .track_whitespace = false, .use_arena = true };
 
-    if (!NIL_P(track_whitespace) && RTEST(track_whitespace)) {
-      opts.track_whitespace = true;
-      parser_options = &opts;
-    }
+  VALUE track_whitespace = lookup_option(options, "track_whitespace");
+  if (!NIL_P(track_whitespace) && RTEST(track_whitespace)) { opts.track_whitespace = true; }
+
+  return opts;
+}
+
+// The `threads:` option of the batch methods, 0 (one per processor) if not given.
+static size_t read_thread_count(VALUE options) {
+  VALUE threads = lookup_option(options, "threads");
+
+  return NIL_P(threads) ? 0 : NUM2SIZET(threads);
+}
+
+// Copies the strings of `sources` into one buffer, which stays put while the GVL is released. Copying
+// is cheap next to parsing, and unlike the Ruby strings the copy can neither be modified by other
+// threads nor moved by GC compaction. Both buffers are released with ALLOCV_END() or by the GC.
+static herb_source_T* read_batch_sources(
+  VALUE sources,
+  long* count,
+  volatile VALUE* batch_buffer,
+  volatile VALUE* bytes_buffer
+) {
+  Check_Type(sources, T_ARRAY);
+
+  *count = RARRAY_LEN(sources);
+  size_t total_length = 0;
+
+  for (long i = 0; i < *count; i++) {
+    VALUE source = rb_ary_entry(sources, i);
+
+    Check_Type(source, T_STRING);
+    total_length += (size_t) RSTRING_LEN(source);
+  }
+
+  // Not ALLOCV(), which may allocate on this function's stack.
+  herb_source_T* batch = rb_alloc_tmp_buffer(batch_buffer, (long) ((*count + 1) * sizeof(herb_source_T)));
+  char* bytes = rb_alloc_tmp_buffer(bytes_buffer, (long) (total_length + 1));
+  size_t position = 0;
+
+  for (long i = 0; i < *count; i++) {
+    VALUE source = rb_ary_entry(sources, i);
+    size_t length = (size_t) RSTRING_LEN(source);
+
+    memcpy(bytes + position, RSTRING_PTR(source), length);
+    batch[i] = (herb_source_T) { .source = bytes + position, .length = length };
+    position += length;
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, parser_options);
+  return batch;
+}
 
-  herb_analyze_parse_tree(root, string);
+typedef struct {
+  nogvl_call_T base;
+  const herb_source_T* sources;
+  size_t count;
+  size_t threads;
+  hb_array_T** tokens;
+} lex_batch_call_T;
 
-  VALUE result = create_parse_result(root, source);
+static void lex_batch_call_function(nogvl_call_T* base) {
+  lex_batch_call_T* call = (lex_batch_call_T*) base;
 
-  ast_node_free((AST_NODE_T*) root);
+  herb_lex_batch(call->sources, call->count, call->threads, call->tokens);
+  base->done = true;
+}
 
-  return result;
+static VALUE Herb_lex_batch(int argc, VALUE* argv, VALUE self) {
+  VALUE sources, options;
+  rb_scan_args(argc, argv, "1:", &sources, &options);
+
+  size_t threads = read_thread_count(options);
+
+  long count;
+  volatile VALUE batch_buffer, bytes_buffer;
+  VALUE tokens_buffer;
+  herb_source_T* batch = read_batch_sources(sources, &count, &batch_buffer, &bytes_buffer);
+
+  lex_batch_call_T call = {
+    .base = { .function = lex_batch_call_function },
+    .sources = batch,
+    .count = (size_t) count,
+    .threads = threads,
+    .tokens = ALLOCV_N(hb_array_T*, tokens_buffer, count),
+  };
+
+  call_without_gvl(&call.base);
+
+  VALUE results = rb_ary_new_capa(count);
+
+  for (long i = 0; i < count; i++) {
+    rb_ary_push(results, create_lex_result(call.tokens[i], rb_ary_entry(sources, i)));
+    herb_free_tokens(&call.tokens[i]);
+  }
+
+  ALLOCV_END(tokens_buffer);
+  ALLOCV_END(bytes_buffer);
+  ALLOCV_END(batch_buffer);
+
+  return results;
 }
 
-static VALUE Herb_parse_file(VALUE self, VALUE path) {
-  char* file_path = (char*) check_string(path);
+typedef struct {
+  nogvl_call_T base;
+  const herb_source_T* sources;
+  size_t count;
+  size_t threads;
+  parser_options_T options;
+  AST_DOCUMENT_NODE_T** documents;
+} parse_batch_call_T;
 
-  VALUE source_value = read_file_to_ruby_string(file_path);
-  char* string = (char*) check_string(source_value);
+static void parse_batch_call_function(nogvl_call_T* base) {
+  parse_batch_call_T* call = (parse_batch_call_T*) base;
+
+  // Called from every worker thread, which is fine for a read of `interrupted`.
+  parser_options_T options = call->options;
+  options.cancel = parse_call_interrupted;
+  options.cancel_data = base;
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, NULL);
+  herb_parse_batch(call->sources, call->count, &options, call->threads, call->documents);
 
-  herb_analyze_parse_tree(root, string);
+  bool cancelled = false;
 
-  VALUE result = create_parse_result(root, source_value);
+  for (size_t i = 0; i < call->count; i++) {
+    if (call->documents[i]->cancelled) { cancelled = true; }
+  }
 
-  ast_node_free((AST_NODE_T*) root);
+  if (cancelled) {
+    for (size_t i = 0; i < call->count; i++) {
+      ast_node_free((AST_NODE_T*) call->documents[i]);
+    }
 
-  return result;
+    return;
+  }
+
+  base->done = true;
 }
 
-static VALUE Herb_extract_ruby(VALUE self, VALUE source) {
-  char* string = (char*) check_string(source);
-  hb_buffer_T output;
+static VALUE Herb_parse_batch(int argc, VALUE* argv, VALUE self) {
+  VALUE sources, options;
+  rb_scan_args(argc, argv, "1:", &sources, &options);
 
-  if (!hb_buffer_init(&output, strlen(string))) { return Qnil; }
+  parser_options_T opts = read_parser_options(options);
+  size_t threads = read_thread_count(options);
 
-  herb_extract_ruby_to_buffer(string, &output);
+  Check_Type(sources, T_ARRAY);
 
-  VALUE result = rb_utf8_str_new_cstr(output.value);
-  free(output.value);
+  long count = RARRAY_LEN(sources);
+  VALUE documents = rb_ary_new_capa(count);
+  VALUE batch_buffer, documents_buffer;
+  herb_source_T* batch = ALLOCV_N(herb_source_T, batch_buffer, count);
 
-  return result;
+  // Unlike lex_batch, the sources aren't copied: every document keeps the frozen string its
+  // tokens point into, which its wrapper pins from here on.
+  for (long i = 0; i < count; i++) {
+    VALUE source = rb_ary_entry(sources, i);
+    Check_Type(source, T_STRING);
+
+    VALUE pinned = rb_str_new_frozen(source);
+    rb_ary_push(documents, document_wrapper_new(pinned));
+    batch[i] = (herb_source_T) { .source = RSTRING_PTR(pinned), .length = (size_t) RSTRING_LEN(pinned) };
+  }
+
+  parse_batch_call_T call = {
+    .base = { .function = parse_batch_call_function },
+    .sources = batch,
+    .count = (size_t) count,
+    .threads = threads,
+    .options = opts,
+    .documents = ALLOCV_N(AST_DOCUMENT_NODE_T*, documents_buffer, count),
+  };
+
+  call_without_gvl(&call.base);
+
+  VALUE results = rb_ary_new_capa(count);
+
+  for (long i = 0; i < count; i++) {
+    VALUE document = rb_ary_entry(documents, i);
+
+    document_wrapper_set(document, call.documents[i]);
+    rb_ary_push(results, create_parse_result(document, rb_ary_entry(sources, i)));
+  }
+
+  ALLOCV_END(documents_buffer);
+  ALLOCV_END(batch_buffer);
+  RB_GC_GUARD(documents);
+
+  return results;
 }
 
-static VALUE Herb_extract_html(VALUE self, VALUE source) {
-  char* string = (char*) check_string(source);
+static VALUE Herb_parse(int argc, VALUE* argv, VALUE self) {
+  VALUE source, options;
+  rb_scan_args(argc, argv, "1:", &source, &options);
+
+  return parse_source(source, read_parser_options(options));
+}
+
+static VALUE Herb_parse_file(VALUE self, VALUE path) {
+  char* file_path = (char*) check_string(path);
+  VALUE source_value = read_file_to_ruby_string(file_path);
+
+  return parse_source(source_value, read_parser_options(Qnil));
+}
+
+typedef struct {
+  nogvl_call_T base;
+  const char* source;
+  size_t length;
+  herb_extract_language_T language;
   hb_buffer_T output;
+} extract_call_T;
+
+static void extract_call_function(nogvl_call_T* base) {
+  extract_call_T* call = (extract_call_T*) base;
+
+  if (call->language == HERB_EXTRACT_LANGUAGE_RUBY) {
+    herb_extract_ruby_to_buffer_n(call->source, call->length, &call->output);
+  } else {
+    herb_extract_html_to_buffer_n(call->source, call->length, &call->output);
+  }
+
+  base->done = true;
+}
+
+static VALUE extract_source(VALUE source, herb_extract_language_T language) {
+  VALUE pinned = pin_source(source);
+  extract_call_T call = {
+    .base = { .function = extract_call_function },
+    .source = check_string(pinned),
+    .length = check_string_length(pinned),
+    .language = language,
+  };
 
-  if (!hb_buffer_init(&output, strlen(string))) { return Qnil; }
+  if (!hb_buffer_init(&call.output, call.length)) { return Qnil; }
 
-  herb_extract_html_to_buffer(string, &output);
+  call_without_gvl(&call.base);
 
-  VALUE result = rb_utf8_str_new_cstr(output.value);
-  free(output.value);
+  VALUE result = rb_utf8_str_new(call.output.value, (long) call.output.length);
+  free(call.output.value);
+  RB_GC_GUARD(pinned);
 
   return result;
 }
 
+static VALUE Herb_extract_ruby(VALUE self, VALUE source) {
+  return extract_source(source, HERB_EXTRACT_LANGUAGE_RUBY);
+}
+
+static VALUE Herb_extract_html(VALUE self, VALUE source) {
+  return extract_source(source, HERB_EXTRACT_LANGUAGE_HTML);
+}
+
 static VALUE Herb_version(VALUE self) {
   VALUE gem_version = rb_const_get(self, rb_intern("VERSION"));
   VALUE libherb_version = rb_utf8_str_new_cstr(herb_version());
@@ -124,6 +429,220 @@ static VALUE Herb_version(VALUE self) {
   return rb_funcall(rb_mKernel, rb_intern("sprintf"), 4, format_string, gem_version, libprism_version, libherb_version);
 }
 
+typedef struct {
+  line_index_T* index;
+  VALUE source;
+} line_index_wrapper_T;
+
+static void line_index_wrapper_mark(void* data) {
+  rb_gc_mark(((line_index_wrapper_T*) data)->source);
+}
+
+static void line_index_wrapper_free(void* data) {
+  line_index_wrapper_T* wrapper = data;
+
+  line_index_free(&wrapper->index);
+  xfree(wrapper);
+}
+
+static size_t line_index_wrapper_size(const void* data) {
+  const line_index_wrapper_T* wrapper = data;
+  size_t size = sizeof(line_index_wrapper_T);
+
+  if (wrapper->index) { size += sizeof(line_index_T) + wrapper->index->line_count * sizeof(uint32_t); }
+
+  return size;
+}
+
+static const rb_data_type_t line_index_type = {
+  .wrap_struct_name = "Herb::LineIndex",
+  .function = {
+    .dmark = line_index_wrapper_mark,
+    .dfree = line_index_wrapper_free,
+    .dsize = line_index_wrapper_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static VALUE LineIndex_allocate(VALUE klass) {
+  line_index_wrapper_T* wrapper;
+  VALUE self = TypedData_Make_Struct(klass, line_index_wrapper_T, &line_index_type, wrapper);
+
+  wrapper->index = NULL;
+  wrapper->source = Qnil;
+
+  return self;
+}
+
+static line_index_T* LineIndex_get(VALUE self) {
+  line_index_wrapper_T* wrapper;
+  TypedData_Get_Struct(self, line_index_wrapper_T, &line_index_type, wrapper);
+
+  if (!wrapper->index) { rb_raise(rb_eRuntimeError, "Herb::LineIndex is not initialized"); }
+
+  return wrapper->index;
+}
+
+static VALUE LineIndex_initialize(VALUE self, VALUE source) {
+  line_index_wrapper_T* wrapper;
+  TypedData_Get_Struct(self, line_index_wrapper_T, &line_index_type, wrapper);
+
+  // The index points into the string's bytes, so keep a frozen copy alive with it.
+  VALUE frozen_source = rb_str_new_frozen(StringValue(source));
+
+  line_index_free(&wrapper->index);
+  wrapper->source = frozen_source;
+  wrapper->index = line_index_init(RSTRING_PTR(frozen_source), RSTRING_LEN(frozen_source));
+
+  return self;
+}
+
+static VALUE LineIndex_line_count(VALUE self) {
+  return UINT2NUM(line_index_line_count(LineIndex_get(self)));
+}
+
+static VALUE LineIndex_line_start(VALUE self, VALUE line) {
+  return UINT2NUM(line_index_line_start(LineIndex_get(self), NUM2UINT(line)));
+}
+
+static VALUE LineIndex_position_at(VALUE self, VALUE offset) {
+  return rb_position_from_c_struct(line_index_position(LineIndex_get(self), NUM2UINT(offset)));
+}
+
+static VALUE LineIndex_offset_at(VALUE self, VALUE line, VALUE column) {
+  position_T position = { .line = NUM2UINT(line), .column = NUM2UINT(column) };
+
+  return UINT2NUM(line_index_offset(LineIndex_get(self), position));
+}
+
+static VALUE LineIndex_utf16_position_at(VALUE self, VALUE offset) {
+  return rb_position_from_c_struct(line_index_utf16_position(LineIndex_get(self), NUM2UINT(offset)));
+}
+
+static VALUE LineIndex_offset_at_utf16(VALUE self, VALUE line, VALUE column) {
+  position_T position = { .line = NUM2UINT(line), .column = NUM2UINT(column) };
+
+  return UINT2NUM(line_index_offset_from_utf16(LineIndex_get(self), position));
+}
+
+typedef struct {
+  herb_token_stream_T stream;
+  VALUE source;
+} token_stream_wrapper_T;
+
+static void token_stream_wrapper_mark(void* data) {
+  rb_gc_mark(((token_stream_wrapper_T*) data)->source);
+}
+
+static void token_stream_wrapper_free(void* data) {
+  token_stream_wrapper_T* wrapper = data;
+
+  herb_token_stream_free(&wrapper->stream);
+  xfree(wrapper);
+}
+
+static size_t token_stream_wrapper_size(const void* data) {
+  const token_stream_wrapper_T* wrapper = data;
+  size_t size = sizeof(token_stream_wrapper_T) + wrapper->stream.size * (2 * sizeof(uint32_t) + sizeof(uint8_t));
+
+  if (wrapper->stream.line_index) {
+    size += sizeof(line_index_T) + wrapper->stream.line_index->line_count * sizeof(uint32_t);
+  }
+
+  return size;
+}
+
+static const rb_data_type_t token_stream_type = {
+  .wrap_struct_name = "Herb::TokenStream",
+  .function = {
+    .dmark = token_stream_wrapper_mark,
+    .dfree = token_stream_wrapper_free,
+    .dsize = token_stream_wrapper_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static VALUE TokenStream_allocate(VALUE klass) {
+  token_stream_wrapper_T* wrapper;
+  VALUE self = TypedData_Make_Struct(klass, token_stream_wrapper_T, &token_stream_type, wrapper);
+
+  wrapper->stream = (herb_token_stream_T) { 0 };
+  wrapper->source = Qnil;
+
+  return self;
+}
+
+static herb_token_stream_T* TokenStream_get(VALUE self, VALUE index, size_t* token) {
+  token_stream_wrapper_T* wrapper;
+  TypedData_Get_Struct(self, token_stream_wrapper_T, &token_stream_type, wrapper);
+
+  if (NIL_P(wrapper->source)) { rb_raise(rb_eRuntimeError, "Herb::TokenStream is not initialized"); }
+
+  if (token) {
+    long value = NUM2LONG(index);
+
+    if (value < 0 || (size_t) value >= wrapper->stream.size) {
+      rb_raise(rb_eIndexError, "index %ld outside of token stream (size %zu)", value, wrapper->stream.size);
+    }
+
+    *token = (size_t) value;
+  }
+
+  return &wrapper->stream;
+}
+
+static VALUE TokenStream_initialize(VALUE self, VALUE source) {
+  token_stream_wrapper_T* wrapper;
+  TypedData_Get_Struct(self, token_stream_wrapper_T, &token_stream_type, wrapper);
+
+  // The stream points into the string's bytes, so keep a frozen copy alive with it.
+  VALUE frozen_source = rb_str_new_frozen(StringValue(source));
+
+  herb_token_stream_free(&wrapper->stream);
+  wrapper->source = frozen_source;
+  herb_token_stream_init_n(&wrapper->stream, RSTRING_PTR(frozen_source), RSTRING_LEN(frozen_source));
+
+  return self;
+}
+
+static VALUE TokenStream_size(VALUE self) {
+  return SIZET2NUM(TokenStream_get(self, Qnil, NULL)->size);
+}
+
+static VALUE TokenStream_type(VALUE self, VALUE index) {
+  size_t token;
+  herb_token_stream_T* stream = TokenStream_get(self, index, &token);
+
+  return rb_token_type_from_c(herb_token_stream_type(stream, token));
+}
+
+static VALUE TokenStream_value(VALUE self, VALUE index) {
+  size_t token;
+  herb_token_stream_T* stream = TokenStream_get(self, index, &token);
+  hb_string_T value = herb_token_stream_value(stream, token);
+
+  return rb_utf8_str_new(value.data, value.length);
+}
+
+static VALUE TokenStream_range(VALUE self, VALUE index) {
+  size_t token;
+  herb_token_stream_T* stream = TokenStream_get(self, index, &token);
+
+  return rb_range_from_c_struct((range_T) { .from = stream->starts[token], .to = stream->ends[token] });
+}
+
+static VALUE TokenStream_location(VALUE self, VALUE index) {
+  size_t token;
+  herb_token_stream_T* stream = TokenStream_get(self, index, &token);
+
+  location_T location = {
+    .start = herb_token_stream_start(stream, token),
+    .end = herb_token_stream_end(stream, token),
+  };
+
+  return rb_location_from_c_struct(location);
+}
+
 void Init_herb(void) {
   mHerb = rb_define_module("Herb");
   cPosition = rb_define_class_under(mHerb, "Position", rb_cObject);
@@ -133,12 +652,37 @@ void Init_herb(void) {
   cResult = rb_define_class_under(mHerb, "Result", rb_cObject);
   cLexResult = rb_define_class_under(mHerb, "LexResult", cResult);
   cParseResult = rb_define_class_under(mHerb, "ParseResult", cResult);
+  cLineIndex = rb_define_class_under(mHerb, "LineIndex", rb_cObject);
+  cTokenStream = rb_define_class_under(mHerb, "TokenStream", rb_cObject);
+
+  init_token_types();
+  init_node_classes();
+  init_error_classes();
 
   rb_define_singleton_method(mHerb, "parse", Herb_parse, -1);
   rb_define_singleton_method(mHerb, "lex", Herb_lex, 1);
   rb_define_singleton_method(mHerb, "parse_file", Herb_parse_file, 1);
   rb_define_singleton_method(mHerb, "lex_file", Herb_lex_file, 1);
+  rb_define_singleton_method(mHerb, "parse_batch", Herb_parse_batch, -1);
+  rb_define_singleton_method(mHerb, "lex_batch", Herb_lex_batch, -1);
   rb_define_singleton_method(mHerb, "extract_ruby", Herb_extract_ruby, 1);
   rb_define_singleton_method(mHerb, "extract_html", Herb_extract_html, 1);
   rb_define_singleton_method(mHerb, "version", Herb_version, 0);
+
+  rb_define_alloc_func(cLineIndex, LineIndex_allocate);
+  rb_define_method(cLineIndex, "initialize", LineIndex_initialize, 1);
+  rb_define_method(cLineIndex, "line_count", LineIndex_line_count, 0);
+  rb_define_method(cLineIndex, "line_start", LineIndex_line_start, 1);
+  rb_define_method(cLineIndex, "position_at", LineIndex_position_at, 1);
+  rb_define_method(cLineIndex, "offset_at", LineIndex_offset_at, 2);
+  rb_define_method(cLineIndex, "utf16_position_at", LineIndex_utf16_position_at, 1);
+  rb_define_method(cLineIndex, "offset_at_utf16", LineIndex_offset_at_utf16, 2);
+
+  rb_define_alloc_func(cTokenStream, TokenStream_allocate);
+  rb_define_method(cTokenStream, "initialize", TokenStream_initialize, 1);
+  rb_define_method(cTokenStream, "size", TokenStream_size, 0);
+  rb_define_method(cTokenStream, "type", TokenStream_type, 1);
+  rb_define_method(cTokenStream, "value", TokenStream_value, 1);
+  rb_define_method(cTokenStream, "range", TokenStream_range, 1);
+  rb_define_method(cTokenStream, "location", TokenStream_location, 1);
 }
@@ -11,5 +11,7 @@ extern VALUE cToken;
 extern VALUE cResult;
 extern VALUE cLexResult;
 extern VALUE cParseResult;
+extern VALUE cLineIndex;
+extern VALUE cTokenStream;
 
 #endif
@@ -1,4 +1,5 @@
 #include <ruby.h>
+#include <ruby/encoding.h>
 
 #include "extension.h"
 #include "extension_helpers.h"
@@ -9,6 +10,7 @@
 #include "../../src/include/location.h"
 #include "../../src/include/position.h"
 #include "../../src/include/token.h"
+#include "../../src/include/util/hb_arena.h"
 
 const char* check_string(VALUE value) {
   if (NIL_P(value)) { return NULL; }
@@ -20,6 +22,36 @@ const char* check_string(VALUE value) {
   return RSTRING_PTR(value);
 }
 
+// Byte length of a value that passed check_string(). Ruby strings may contain NUL bytes, so the
+// C API is called with this length instead of relying on strlen().
+size_t check_string_length(VALUE value) {
+  if (NIL_P(value)) { return 0; }
+
+  return (size_t) RSTRING_LEN(value);
+}
+
+// A frozen, deduplicated UTF-8 string that is never garbage collected, for type names that are
+// handed out for every node, error and token.
+VALUE interned_string_cstr(const char* string) {
+  VALUE interned = rb_enc_interned_str_cstr(string, rb_utf8_encoding());
+  rb_gc_register_mark_object(interned);
+
+  return interned;
+}
+
+// Indexed by token_type_T, filled once by init_token_types().
+static VALUE token_types[TOKEN_EOF + 1];
+
+void init_token_types(void) {
+  for (int type = 0; type <= TOKEN_EOF; type++) {
+    token_types[type] = interned_string_cstr(token_type_to_string((token_type_T) type));
+  }
+}
+
+VALUE rb_token_type_from_c(token_type_T type) {
+  return token_types[type];
+}
+
 VALUE rb_position_from_c_struct(position_T position) {
   VALUE args[2];
   args[0] = UINT2NUM(position.line);
@@ -47,11 +79,11 @@ VALUE rb_range_from_c_struct(range_T range) {
 VALUE rb_token_from_c_struct(token_T* token) {
   if (!token) { return Qnil; }
 
-  VALUE value = token->value ? rb_utf8_str_new_cstr(token->value) : Qnil;
+  VALUE value = token->value.data ? rb_utf8_str_new(token->value.data, token->value.length) : Qnil;
 
   VALUE range = rb_range_from_c_struct(token->range);
   VALUE location = rb_location_from_c_struct(token->location);
-  VALUE type = rb_utf8_str_new_cstr(token_type_to_string(token->type));
+  VALUE type = rb_token_type_from_c(token->type);
 
   VALUE args[4] = { value, range, location, type };
 
@@ -73,8 +105,70 @@ VALUE create_lex_result(hb_array_T* tokens, VALUE source) {
   return rb_class_new_instance(4, args, cLexResult);
 }
 
-VALUE create_parse_result(AST_DOCUMENT_NODE_T* root, VALUE source) {
-  VALUE value = rb_node_from_c_struct((AST_NODE_T*) root);
+typedef struct {
+  AST_DOCUMENT_NODE_T* document;
+  VALUE source;
+} document_wrapper_T;
+
+// rb_gc_mark() instead of rb_gc_mark_movable(): token values point into the bytes of `source`.
+static void document_wrapper_mark(void* data) {
+  rb_gc_mark(((document_wrapper_T*) data)->source);
+}
+
+static void document_wrapper_free(void* data) {
+  document_wrapper_T* wrapper = data;
+
+  if (wrapper->document) { ast_node_free((AST_NODE_T*) wrapper->document); }
+  xfree(wrapper);
+}
+
+static size_t document_wrapper_size(const void* data) {
+  const document_wrapper_T* wrapper = data;
+  size_t size = sizeof(document_wrapper_T);
+
+  if (wrapper->document && wrapper->document->arena) { size += hb_arena_capacity(wrapper->document->arena); }
+
+  return size;
+}
+
+static const rb_data_type_t document_wrapper_type = {
+  .wrap_struct_name = "Herb::AST::Document",
+  .function = {
+    .dmark = document_wrapper_mark,
+    .dfree = document_wrapper_free,
+    .dsize = document_wrapper_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+/**
+ * Creates the object that owns a parsed document and the frozen `source` it was parsed from.
+ * The Ruby nodes of the document reference it, so the C tree is freed once the parse result
+ * and all of its nodes have been garbage collected. `source` is pinned from here on, so it can
+ * be parsed with the GVL released before the document is set.
+ */
+VALUE document_wrapper_new(VALUE source) {
+  document_wrapper_T* wrapper;
+  VALUE self = TypedData_Make_Struct(0, document_wrapper_T, &document_wrapper_type, wrapper);
+
+  wrapper->document = NULL;
+  wrapper->source = source;
+
+  return self;
+}
+
+void document_wrapper_set(VALUE self, AST_DOCUMENT_NODE_T* document) {
+  document_wrapper_T* wrapper;
+  TypedData_Get_Struct(self, document_wrapper_T, &document_wrapper_type, wrapper);
+
+  wrapper->document = document;
+}
+
+VALUE create_parse_result(VALUE document_wrapper, VALUE source) {
+  document_wrapper_T* wrapper;
+  TypedData_Get_Struct(document_wrapper, document_wrapper_T, &document_wrapper_type, wrapper);
+
+  VALUE value = rb_node_from_c_struct((AST_NODE_T*) wrapper->document, document_wrapper);
   VALUE warnings = rb_ary_new();
   VALUE errors = rb_ary_new();
 
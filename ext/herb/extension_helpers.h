@@ -10,15 +10,23 @@
 #include "../../src/include/token.h"
 
 const char* check_string(VALUE value);
+size_t check_string_length(VALUE value);
 VALUE read_file_to_ruby_string(const char* file_path);
+VALUE interned_string_cstr(const char* string);
+
+void init_token_types(void);
 
 VALUE rb_position_from_c_struct(position_T position);
 VALUE rb_location_from_c_struct(location_T location);
 
+VALUE rb_token_type_from_c(token_type_T type);
 VALUE rb_token_from_c_struct(token_T* token);
 VALUE rb_range_from_c_struct(range_T range);
 
 VALUE create_lex_result(hb_array_T* tokens, VALUE source);
-VALUE create_parse_result(AST_DOCUMENT_NODE_T* root, VALUE source);
+VALUE document_wrapper_new(VALUE source);
+void document_wrapper_set(VALUE wrapper, AST_DOCUMENT_NODE_T* document);
+
+VALUE create_parse_result(VALUE document_wrapper, VALUE source);
 
 #endif
@@ -10,6 +10,7 @@
 #include "../../src/include/range.h"
 #include "../../src/include/token.h"
 #include "../../src/include/util/hb_array.h"
+#include "../../src/include/util/hb_string.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,7 +49,9 @@ jobject CreateToken(JNIEnv* env, token_T* token) {
       env, tokenClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Lorg/herb/Location;Lorg/herb/Range;)V");
 
   jstring type = (*env)->NewStringUTF(env, token_type_to_string(token->type));
-  jstring value = (*env)->NewStringUTF(env, token->value);
+  char* token_value = hb_string_to_c_string_using_malloc(token->value);
+  jstring value = (*env)->NewStringUTF(env, token_value);
+  free(token_value);
   jobject location = CreateLocation(env, token->location);
   jobject range = CreateRange(env, token->range);
 
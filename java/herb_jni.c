@@ -3,8 +3,10 @@
 
 #include "../../src/include/analyze.h"
 #include "../../src/include/herb.h"
+#include "../../src/include/line_index.h"
 #include "../../src/include/util/hb_buffer.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -25,6 +27,7 @@ Java_org_herb_Herb_prismVersion(JNIEnv* env, jclass clazz) {
 JNIEXPORT jobject JNICALL
 Java_org_herb_Herb_parse(JNIEnv* env, jclass clazz, jstring source, jobject options) {
   const char* src = (*env)->GetStringUTFChars(env, source, 0);
+  size_t length = (size_t) (*env)->GetStringUTFLength(env, source);
 
   parser_options_T* parser_options = NULL;
   parser_options_T opts = { 0 };
@@ -44,8 +47,8 @@ Java_org_herb_Herb_parse(JNIEnv* env, jclass clazz, jstring source, jobject opti
     }
   }
 
-  AST_DOCUMENT_NODE_T* ast = herb_parse(src, parser_options);
-  herb_analyze_parse_tree(ast, src);
+  AST_DOCUMENT_NODE_T* ast = herb_parse_n(src, length, parser_options);
+  herb_analyze_parse_tree_n(ast, src, length);
 
   jobject result = CreateParseResult(env, ast, source);
 
@@ -58,8 +61,9 @@ Java_org_herb_Herb_parse(JNIEnv* env, jclass clazz, jstring source, jobject opti
 JNIEXPORT jobject JNICALL
 Java_org_herb_Herb_lex(JNIEnv* env, jclass clazz, jstring source) {
   const char* src = (*env)->GetStringUTFChars(env, source, 0);
+  size_t length = (size_t) (*env)->GetStringUTFLength(env, source);
 
-  hb_array_T* tokens = herb_lex(src);
+  hb_array_T* tokens = herb_lex_n(src, length);
 
   jobject result = CreateLexResult(env, tokens, source);
 
@@ -72,16 +76,17 @@ Java_org_herb_Herb_lex(JNIEnv* env, jclass clazz, jstring source) {
 JNIEXPORT jstring JNICALL
 Java_org_herb_Herb_extractRuby(JNIEnv* env, jclass clazz, jstring source) {
   const char* src = (*env)->GetStringUTFChars(env, source, 0);
+  size_t length = (size_t) (*env)->GetStringUTFLength(env, source);
 
   hb_buffer_T output;
 
-  if (!hb_buffer_init(&output, strlen(src))) {
+  if (!hb_buffer_init(&output, length)) {
     (*env)->ReleaseStringUTFChars(env, source, src);
 
     return NULL;
   }
 
-  herb_extract_ruby_to_buffer(src, &output);
+  herb_extract_ruby_to_buffer_n(src, length, &output);
 
   jstring result = (*env)->NewStringUTF(env, output.value);
 
@@ -94,16 +99,17 @@ Java_org_herb_Herb_extractRuby(JNIEnv* env, jclass clazz, jstring source) {
 JNIEXPORT jstring JNICALL
 Java_org_herb_Herb_extractHTML(JNIEnv* env, jclass clazz, jstring source) {
   const char* src = (*env)->GetStringUTFChars(env, source, 0);
+  size_t length = (size_t) (*env)->GetStringUTFLength(env, source);
 
   hb_buffer_T output;
 
-  if (!hb_buffer_init(&output, strlen(src))) {
+  if (!hb_buffer_init(&output, length)) {
     (*env)->ReleaseStringUTFChars(env, source, src);
 
     return NULL;
   }
 
-  herb_extract_html_to_buffer(src, &output);
+  herb_extract_html_to_buffer_n(src, length, &output);
 
   jstring result = (*env)->NewStringUTF(env, output.value);
 
@@ -112,3 +118,71 @@ Java_org_herb_Herb_extractHTML(JNIEnv* env, jclass clazz, jstring source) {
 
   return result;
 }
+
+typedef struct {
+  line_index_T* index;
+  char* source;
+} jni_line_index_T;
+
+static const line_index_T* line_index_from_handle(jlong handle) {
+  return ((jni_line_index_T*) (intptr_t) handle)->index;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_herb_LineIndex_create(JNIEnv* env, jclass clazz, jstring source) {
+  const char* src = (*env)->GetStringUTFChars(env, source, 0);
+  size_t length = strlen(src);
+
+  // The index points into the source bytes, so keep a copy alive with it.
+  jni_line_index_T* wrapper = malloc(sizeof(jni_line_index_T));
+  wrapper->source = malloc(length + 1);
+  memcpy(wrapper->source, src, length + 1);
+  wrapper->index = line_index_init(wrapper->source, length);
+
+  (*env)->ReleaseStringUTFChars(env, source, src);
+
+  return (jlong) (intptr_t) wrapper;
+}
+
+JNIEXPORT void JNICALL
+Java_org_herb_LineIndex_destroy(JNIEnv* env, jclass clazz, jlong handle) {
+  jni_line_index_T* wrapper = (jni_line_index_T*) (intptr_t) handle;
+
+  line_index_free(&wrapper->index);
+  free(wrapper->source);
+  free(wrapper);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_herb_LineIndex_lineCount(JNIEnv* env, jclass clazz, jlong handle) {
+  return (jint) line_index_line_count(line_index_from_handle(handle));
+}
+
+JNIEXPORT jint JNICALL
+Java_org_herb_LineIndex_lineStart(JNIEnv* env, jclass clazz, jlong handle, jint line) {
+  return (jint) line_index_line_start(line_index_from_handle(handle), (uint32_t) line);
+}
+
+JNIEXPORT jobject JNICALL
+Java_org_herb_LineIndex_positionAt(JNIEnv* env, jclass clazz, jlong handle, jint offset) {
+  return CreatePosition(env, line_index_position(line_index_from_handle(handle), (uint32_t) offset));
+}
+
+JNIEXPORT jint JNICALL
+Java_org_herb_LineIndex_offsetAt(JNIEnv* env, jclass clazz, jlong handle, jint line, jint column) {
+  position_T position = { .line = (uint32_t) line, .column = (uint32_t) column };
+
+  return (jint) line_index_offset(line_index_from_handle(handle), position);
+}
+
+JNIEXPORT jobject JNICALL
+Java_org_herb_LineIndex_utf16PositionAt(JNIEnv* env, jclass clazz, jlong handle, jint offset) {
+  return CreatePosition(env, line_index_utf16_position(line_index_from_handle(handle), (uint32_t) offset));
+}
+
+JNIEXPORT jint JNICALL
+Java_org_herb_LineIndex_offsetAtUtf16(JNIEnv* env, jclass clazz, jlong handle, jint line, jint column) {
+  position_T position = { .line = (uint32_t) line, .column = (uint32_t) column };
+
+  return (jint) line_index_offset_from_utf16(line_index_from_handle(handle), position);
+}
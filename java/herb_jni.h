@@ -14,6 +14,15 @@ JNIEXPORT jobject JNICALL Java_org_herb_Herb_lex(JNIEnv*, jclass, jstring);
 JNIEXPORT jstring JNICALL Java_org_herb_Herb_extractRuby(JNIEnv*, jclass, jstring);
 JNIEXPORT jstring JNICALL Java_org_herb_Herb_extractHTML(JNIEnv*, jclass, jstring);
 
+JNIEXPORT jlong JNICALL Java_org_herb_LineIndex_create(JNIEnv*, jclass, jstring);
+JNIEXPORT void JNICALL Java_org_herb_LineIndex_destroy(JNIEnv*, jclass, jlong);
+JNIEXPORT jint JNICALL Java_org_herb_LineIndex_lineCount(JNIEnv*, jclass, jlong);
+JNIEXPORT jint JNICALL Java_org_herb_LineIndex_lineStart(JNIEnv*, jclass, jlong, jint);
+JNIEXPORT jobject JNICALL Java_org_herb_LineIndex_positionAt(JNIEnv*, jclass, jlong, jint);
+JNIEXPORT jint JNICALL Java_org_herb_LineIndex_offsetAt(JNIEnv*, jclass, jlong, jint, jint);
+JNIEXPORT jobject JNICALL Java_org_herb_LineIndex_utf16PositionAt(JNIEnv*, jclass, jlong, jint);
+JNIEXPORT jint JNICALL Java_org_herb_LineIndex_offsetAtUtf16(JNIEnv*, jclass, jlong, jint, jint);
+
 #ifdef __cplusplus
 }
 #endif
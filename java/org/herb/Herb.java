@@ -14,6 +14,8 @@ public class Herb {
     }
   }
 
+  static void ensureLoaded() {}
+
   public static native String herbVersion();
   public static native String prismVersion();
   public static native ParseResult parse(String source, ParserOptions options);
@@ -0,0 +1,69 @@
+package org.herb;
+
+/**
+ * Converts between byte offsets and line/column positions of a source.
+ *
+ * Lines are 1-based and columns 0-based. The UTF-16 variants count columns in
+ * UTF-16 code units, like Java strings and the Language Server Protocol do.
+ * The native index is released by {@link #close()}.
+ */
+public class LineIndex implements AutoCloseable {
+  static {
+    Herb.ensureLoaded();
+  }
+
+  private long handle;
+
+  public LineIndex(String source) {
+    this.handle = create(source);
+  }
+
+  private static native long create(String source);
+  private static native void destroy(long handle);
+  private static native int lineCount(long handle);
+  private static native int lineStart(long handle, int line);
+  private static native Position positionAt(long handle, int offset);
+  private static native int offsetAt(long handle, int line, int column);
+  private static native Position utf16PositionAt(long handle, int offset);
+  private static native int offsetAtUtf16(long handle, int line, int column);
+
+  public int lineCount() {
+    return lineCount(ensureHandle());
+  }
+
+  public int lineStart(int line) {
+    return lineStart(ensureHandle(), line);
+  }
+
+  public Position positionAt(int offset) {
+    return positionAt(ensureHandle(), offset);
+  }
+
+  public int offsetAt(Position position) {
+    return offsetAt(ensureHandle(), position.getLine(), position.getColumn());
+  }
+
+  public Position utf16PositionAt(int offset) {
+    return utf16PositionAt(ensureHandle(), offset);
+  }
+
+  public int offsetAtUtf16(Position position) {
+    return offsetAtUtf16(ensureHandle(), position.getLine(), position.getColumn());
+  }
+
+  @Override
+  public void close() {
+    if (handle != 0) {
+      destroy(handle);
+      handle = 0;
+    }
+  }
+
+  private long ensureHandle() {
+    if (handle == 0) {
+      throw new IllegalStateException("LineIndex has been closed");
+    }
+
+    return handle;
+  }
+}
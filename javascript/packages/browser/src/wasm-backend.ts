@@ -2,6 +2,8 @@ import { name, version } from "../package.json"
 
 import { HerbBackend } from "@herb-tools/core"
 
+import type { LexResult, ParseResult, ParserOptions } from "@herb-tools/core"
+
 export class HerbBackendWASM extends HerbBackend {
   lexFile(): never {
     throw new Error("File system operations are not supported in the browser.")
@@ -11,6 +13,15 @@ export class HerbBackendWASM extends HerbBackend {
     throw new Error("File system operations are not supported in the browser.")
   }
 
+  // Without threads in the browser build these block like lex() and parse().
+  async lexAsync(source: string): Promise<LexResult> {
+    return this.lex(source)
+  }
+
+  async parseAsync(source: string, options?: ParserOptions): Promise<ParseResult> {
+    return this.parse(source, options)
+  }
+
   backendVersion(): string {
     return `${name}@${version}`
   }
@@ -1,17 +1,28 @@
 import type { SerializedParseResult } from "./parse-result.js"
 import type { SerializedLexResult } from "./lex-result.js"
-import type { ParserOptions } from "./parser-options.js"
+import type { BatchOptions, ParserOptions } from "./parser-options.js"
+import type { LibHerbLineIndex } from "./line-index.js"
+import type { LibHerbIncrementalParser } from "./incremental-parser.js"
 
 interface LibHerbBackendFunctions {
   lex: (source: string) => SerializedLexResult
   lexFile: (path: string) => SerializedLexResult
+  lexAsync: (source: string) => Promise<SerializedLexResult>
 
   parse: (source: string, options?: ParserOptions) => SerializedParseResult
+  parseSerialized: (source: string, options?: ParserOptions) => Uint8Array
+  parseAsync: (source: string, options?: ParserOptions) => Promise<Uint8Array>
   parseFile: (path: string) => SerializedParseResult
 
+  lexBatch: (sources: string[], options?: BatchOptions) => SerializedLexResult[]
+  parseBatch: (sources: string[], options?: BatchOptions) => SerializedParseResult[]
+
   extractRuby: (source: string) => string
   extractHTML: (source: string) => string
 
+  lineIndex: (source: string) => LibHerbLineIndex
+  incrementalParser: (options?: ParserOptions) => LibHerbIncrementalParser
+
   version: () => string
 }
 
@@ -19,11 +30,18 @@ export type BackendPromise = () => Promise<LibHerbBackend>
 
 const expectedFunctions = [
   "parse",
+  "parseSerialized",
+  "parseAsync",
   "lex",
+  "lexAsync",
   "parseFile",
   "lexFile",
+  "lexBatch",
+  "parseBatch",
   "extractRuby",
   "extractHTML",
+  "lineIndex",
+  "incrementalParser",
   "version",
 ] as const
 
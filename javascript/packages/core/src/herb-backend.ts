@@ -1,12 +1,15 @@
 import packageJSON from "../package.json" with { type: "json" }
 
 import { ensureString } from "./util.js"
+import { IncrementalParser } from "./incremental-parser.js"
+import { deserializeParseResult } from "./deserialize.js"
 import { LexResult } from "./lex-result.js"
+import { LineIndex } from "./line-index.js"
 import { ParseResult } from "./parse-result.js"
 import { DEFAULT_PARSER_OPTIONS } from "./parser-options.js"
 
 import type { LibHerbBackend, BackendPromise } from "./backend.js"
-import type { ParserOptions } from "./parser-options.js"
+import type { BatchOptions, ParserOptions } from "./parser-options.js"
 
 /**
  * The main Herb parser interface, providing methods to lex and parse input.
@@ -74,8 +77,10 @@ export abstract class HerbBackend {
     this.ensureBackend()
 
     const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+    const string = ensureString(source)
+    const serialized = this.backend.parseSerialized(string, mergedOptions)
 
-    return ParseResult.from(this.backend.parse(ensureString(source), mergedOptions))
+    return ParseResult.from(deserializeParseResult(serialized, string))
   }
 
   /**
@@ -90,6 +95,70 @@ export abstract class HerbBackend {
     return ParseResult.from(this.backend.parseFile(ensureString(path)))
   }
 
+  /**
+   * Lexes the given source string off the main thread, where the backend supports it.
+   * @param source - The source code to lex.
+   * @returns A promise of a `LexResult` instance.
+   * @throws Error if the backend is not loaded.
+   */
+  async lexAsync(source: string): Promise<LexResult> {
+    this.ensureBackend()
+
+    return LexResult.from(await this.backend.lexAsync(ensureString(source)))
+  }
+
+  /**
+   * Parses the given source string off the main thread, where the backend supports it,
+   * so many files can be parsed without blocking the event loop. A `timeout` counts
+   * from when the parse starts, not from when it was queued.
+   * @param source - The source code to parse.
+   * @param options - Optional parsing options.
+   * @returns A promise of a `ParseResult` instance.
+   * @throws Error if the backend is not loaded.
+   */
+  async parseAsync(source: string, options?: ParserOptions): Promise<ParseResult> {
+    this.ensureBackend()
+
+    const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+    const string = ensureString(source)
+    const serialized = await this.backend.parseAsync(string, mergedOptions)
+
+    return ParseResult.from(deserializeParseResult(serialized, string))
+  }
+
+  /**
+   * Lexes many sources at once, spread over native threads where the backend has them.
+   * @param sources - The source codes to lex.
+   * @param options - Optional batch options.
+   * @returns A `LexResult` instance for every source, in the same order.
+   * @throws Error if the backend is not loaded.
+   */
+  lexBatch(sources: string[], options?: BatchOptions): LexResult[] {
+    this.ensureBackend()
+
+    return this.backend
+      .lexBatch(sources.map(ensureString), options)
+      .map((result) => LexResult.from(result))
+  }
+
+  /**
+   * Parses many sources at once, spread over native threads where the backend has them.
+   * The results are the same as calling `parse()` on every source.
+   * @param sources - The source codes to parse.
+   * @param options - Optional parsing and batch options.
+   * @returns A `ParseResult` instance for every source, in the same order.
+   * @throws Error if the backend is not loaded.
+   */
+  parseBatch(sources: string[], options?: BatchOptions): ParseResult[] {
+    this.ensureBackend()
+
+    const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+
+    return this.backend
+      .parseBatch(sources.map(ensureString), mergedOptions)
+      .map((result) => ParseResult.from(result))
+  }
+
   /**
    * Extracts embedded Ruby code from the given source.
    * @param source - The source code to extract Ruby from.
@@ -114,6 +183,34 @@ export abstract class HerbBackend {
     return this.backend.extractHTML(ensureString(source))
   }
 
+  /**
+   * Builds a line index for converting between byte offsets and positions.
+   * @param source - The source code to index.
+   * @returns A `LineIndex` instance. Call `free()` on it when done.
+   * @throws Error if the backend is not loaded.
+   */
+  lineIndex(source: string): LineIndex {
+    this.ensureBackend()
+
+    return new LineIndex(this.backend.lineIndex(ensureString(source)))
+  }
+
+  /**
+   * Creates a parser for successive versions of one document, such as an open
+   * editor buffer. Each parse reuses the parts of the previous tree that the
+   * edit in between didn't touch.
+   * @param options - Optional parsing options, used for every version.
+   * @returns An `IncrementalParser` instance. Call `free()` on it when done.
+   * @throws Error if the backend is not loaded.
+   */
+  incrementalParser(options?: ParserOptions): IncrementalParser {
+    this.ensureBackend()
+
+    const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+
+    return new IncrementalParser(this.backend.incrementalParser(mergedOptions))
+  }
+
   /**
    * Gets the Herb version information, including the core and backend versions.
    * @returns A version string containing backend, core, and libherb versions.
@@ -0,0 +1,41 @@
+import { ParseResult } from "./parse-result.js"
+import { ensureString } from "./util.js"
+
+import type { SerializedParseResult } from "./parse-result.js"
+
+export interface LibHerbIncrementalParser {
+  parse: (source: string) => SerializedParseResult
+  free: () => void
+  delete?: () => void
+}
+
+/**
+ * Parses successive versions of one document. The native side keeps the tree of
+ * the previous version, works out which part of the source changed and parses
+ * only the top-level nodes around that edit again. The results are the same as
+ * `Herb.parse()` would return.
+ *
+ * Call `free()` when done with it; the WebAssembly backend can't release the
+ * native document on its own.
+ */
+export class IncrementalParser {
+  private readonly parser: LibHerbIncrementalParser
+
+  constructor(parser: LibHerbIncrementalParser) {
+    this.parser = parser
+  }
+
+  /**
+   * Parses the next version of the document.
+   * @param source - The complete source of the new version.
+   * @returns A `ParseResult` instance.
+   */
+  parse(source: string): ParseResult {
+    return ParseResult.from(this.parser.parse(ensureString(source)))
+  }
+
+  free(): void {
+    this.parser.free()
+    this.parser.delete?.()
+  }
+}
@@ -1,11 +1,14 @@
 export * from "./ast-utils.js"
 export * from "./backend.js"
+export * from "./deserialize.js"
 export * from "./diagnostic.js"
 export * from "./didyoumean.js"
 export * from "./errors.js"
 export * from "./herb-backend.js"
+export * from "./incremental-parser.js"
 export * from "./levenshtein.js"
 export * from "./lex-result.js"
+export * from "./line-index.js"
 export * from "./location.js"
 export * from "./node-type-guards.js"
 export * from "./nodes.js"
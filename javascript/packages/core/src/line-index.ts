@@ -0,0 +1,61 @@
+import { Position } from "./position.js"
+
+import type { SerializedPosition } from "./position.js"
+
+export interface LibHerbLineIndex {
+  lineCount: () => number
+  lineStart: (line: number) => number
+  positionAt: (offset: number) => SerializedPosition
+  offsetAt: (line: number, column: number) => number
+  utf16PositionAt: (offset: number) => SerializedPosition
+  offsetAtUtf16: (line: number, column: number) => number
+  free: () => void
+  delete?: () => void
+}
+
+/**
+ * Maps byte offsets in a source (as used by token and node ranges) to
+ * line/column positions and back, without rescanning the source per lookup.
+ *
+ * Lines are 1-based and columns 0-based. The `Utf16` variants count columns in
+ * UTF-16 code units, which is what editors and the Language Server Protocol use.
+ *
+ * Call `free()` when done with it; the WebAssembly backend can't release the
+ * native index on its own.
+ */
+export class LineIndex {
+  private readonly index: LibHerbLineIndex
+
+  constructor(index: LibHerbLineIndex) {
+    this.index = index
+  }
+
+  get lineCount(): number {
+    return this.index.lineCount()
+  }
+
+  lineStart(line: number): number {
+    return this.index.lineStart(line)
+  }
+
+  positionAt(offset: number): Position {
+    return Position.from(this.index.positionAt(offset))
+  }
+
+  offsetAt(position: Position | SerializedPosition): number {
+    return this.index.offsetAt(position.line, position.column)
+  }
+
+  utf16PositionAt(offset: number): Position {
+    return Position.from(this.index.utf16PositionAt(offset))
+  }
+
+  offsetAtUtf16(position: Position | SerializedPosition): number {
+    return this.index.offsetAtUtf16(position.line, position.column)
+  }
+
+  free(): void {
+    this.index.free()
+    this.index.delete?.()
+  }
+}
@@ -15,6 +15,7 @@ export type SerializedParseResult = {
   source: string
   warnings: SerializedHerbWarning[]
   errors: SerializedHerbError[]
+  cancelled?: boolean
 }
 
 /**
@@ -25,6 +26,9 @@ export class ParseResult extends Result {
   /** The document node generated from the source code. */
   readonly value: DocumentNode
 
+  /** Whether the parse stopped early because its `timeout` passed. */
+  readonly cancelled: boolean
+
   /**
    * Creates a `ParseResult` instance from a serialized result.
    * @param result - The serialized parse result containing the value and source.
@@ -36,6 +40,7 @@ export class ParseResult extends Result {
       result.source,
       result.warnings.map((warning) => HerbWarning.from(warning)),
       result.errors.map((error) => HerbError.from(error)),
+      result.cancelled ?? false,
     )
   }
 
@@ -45,15 +50,18 @@ export class ParseResult extends Result {
    * @param source - The source code that was parsed.
    * @param warnings - An array of warnings encountered during parsing.
    * @param errors - An array of errors encountered during parsing.
+   * @param cancelled - Whether the parse stopped early.
    */
   constructor(
     value: DocumentNode,
     source: string,
     warnings: HerbWarning[] = [],
     errors: HerbError[] = [],
+    cancelled: boolean = false,
   ) {
     super(source, warnings, errors)
     this.value = value
+    this.cancelled = cancelled
   }
 
   /**
@@ -1,5 +1,18 @@
 export interface ParserOptions {
   track_whitespace?: boolean
+  /**
+   * Milliseconds after which the parse stops early. The result then holds the tree
+   * parsed so far and has `cancelled` set.
+   */
+  timeout?: number
+}
+
+export interface BatchOptions extends ParserOptions {
+  /**
+   * Number of native threads to spread the sources over, one per processor by
+   * default. A `timeout` applies to the whole batch.
+   */
+  threads?: number
 }
 
 export const DEFAULT_PARSER_OPTIONS: ParserOptions = {
@@ -2,7 +2,19 @@ import { name, version } from "../package.json"
 
 import { HerbBackend } from "@herb-tools/core"
 
+import type { LexResult, ParseResult, ParserOptions } from "@herb-tools/core"
+
 export class HerbBackendNodeWASM extends HerbBackend {
+  // The WebAssembly module has no worker threads to hand the work to, so these run
+  // on the calling thread and return settled promises.
+  async lexAsync(source: string): Promise<LexResult> {
+    return this.lex(source)
+  }
+
+  async parseAsync(source: string, options?: ParserOptions): Promise<ParseResult> {
+    return this.parse(source, options)
+  }
+
   backendVersion(): string {
     return `${name}@${version}`
   }
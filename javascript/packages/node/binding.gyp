@@ -18,6 +18,7 @@
         "./extension/libherb/ast_node.c",
         "./extension/libherb/ast_nodes.c",
         "./extension/libherb/ast_pretty_print.c",
+        "./extension/libherb/ast_serialize.c",
         "./extension/libherb/element_source.c",
         "./extension/libherb/errors.c",
         "./extension/libherb/extract.c",
@@ -26,6 +27,7 @@
         "./extension/libherb/io.c",
         "./extension/libherb/lexer_peek_helpers.c",
         "./extension/libherb/lexer.c",
+        "./extension/libherb/line_index.c",
         "./extension/libherb/location.c",
         "./extension/libherb/parser_helpers.c",
         "./extension/libherb/parser_match_tags.c",
@@ -34,15 +36,20 @@
         "./extension/libherb/pretty_print.c",
         "./extension/libherb/prism_helpers.c",
         "./extension/libherb/range.c",
+        "./extension/libherb/reparse.c",
         "./extension/libherb/token_matchers.c",
         "./extension/libherb/token.c",
+        "./extension/libherb/token_stream.c",
         "./extension/libherb/utf8.c",
         "./extension/libherb/util.c",
         "./extension/libherb/util/hb_arena.c",
         "./extension/libherb/util/hb_array.c",
         "./extension/libherb/util/hb_buffer.c",
+        "./extension/libherb/util/hb_memory.c",
+        "./extension/libherb/util/hb_scan.c",
         "./extension/libherb/util/hb_string.c",
         "./extension/libherb/util/hb_system.c",
+        "./extension/libherb/util/hb_thread_pool.c",
         "./extension/libherb/visitor.c",
 
         # Prism main source files
@@ -18,8 +18,10 @@ extern "C" {
 #include "error_helpers.h"
 #include "nodes.h"
 
-char* CheckString(napi_env env, napi_value value) {
-  size_t length;
+// Copies a JS string into a malloc'd UTF-8 buffer. JS strings may contain NUL characters, so
+// `length` receives the byte length to pass to the `_n` functions of the C API.
+char* CheckString(napi_env env, napi_value value, size_t* length) {
+  size_t byte_length;
   size_t copied;
   napi_valuetype type;
 
@@ -29,14 +31,16 @@ char* CheckString(napi_env env, napi_value value) {
     return nullptr;
   }
 
-  napi_get_value_string_utf8(env, value, nullptr, 0, &length);
-  char* result = (char*) malloc(length + 1);
+  napi_get_value_string_utf8(env, value, nullptr, 0, &byte_length);
+  char* result = (char*) malloc(byte_length + 1);
   if (!result) {
     napi_throw_error(env, nullptr, "Memory allocation failed");
     return nullptr;
   }
 
-  napi_get_value_string_utf8(env, value, result, length + 1, &copied);
+  napi_get_value_string_utf8(env, value, result, byte_length + 1, &copied);
+  if (length) { *length = copied; }
+
   return result;
 }
 
@@ -105,7 +109,7 @@ napi_value CreateToken(napi_env env, token_T* token) {
   napi_create_object(env, &result);
 
   // Value
-  napi_value value = token->value ? CreateString(env, token->value) : nullptr;
+  napi_value value = token->value.data ? CreateStringFromHbString(env, token->value) : nullptr;
   if (value) {
     napi_set_named_property(env, result, "value", value);
   } else {
@@ -185,10 +189,14 @@ napi_value CreateParseResult(napi_env env, AST_DOCUMENT_NODE_T* root, napi_value
     napi_get_null(env, &ast_value);
   }
 
+  napi_value cancelled;
+  napi_get_boolean(env, root != nullptr && root->cancelled, &cancelled);
+
   napi_set_named_property(env, result, "value", ast_value);
   napi_set_named_property(env, result, "source", source);
   napi_set_named_property(env, result, "warnings", warnings_array);
   napi_set_named_property(env, result, "errors", errors_array);
+  napi_set_named_property(env, result, "cancelled", cancelled);
 
   return result;
 }
@@ -9,7 +9,7 @@ extern "C" {
 #include "../extension/libherb/include/util/hb_string.h"
 }
 
-char* CheckString(napi_env env, napi_value value);
+char* CheckString(napi_env env, napi_value value, size_t* length = nullptr);
 napi_value CreateString(napi_env env, const char* str);
 napi_value CreateStringFromHbString(napi_env env, hb_string_T string);
 napi_value ReadFileToString(napi_env env, const char* file_path);
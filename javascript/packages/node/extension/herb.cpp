@@ -2,8 +2,11 @@ extern "C" {
 #include "../extension/libherb/include/analyze.h"
 #include "../extension/libherb/include/ast_nodes.h"
 #include "../extension/libherb/include/herb.h"
+#include "../extension/libherb/include/line_index.h"
 #include "../extension/libherb/include/location.h"
 #include "../extension/libherb/include/range.h"
+#include "../extension/libherb/include/reparse.h"
+#include "../extension/libherb/include/ast_serialize.h"
 #include "../extension/libherb/include/token.h"
 #include "../extension/libherb/include/util/hb_array.h"
 #include "../extension/libherb/include/util/hb_buffer.h"
@@ -13,10 +16,12 @@ extern "C" {
 #include "extension_helpers.h"
 #include "nodes.h"
 
+#include <chrono>
 #include <node_api.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 napi_value Herb_lex(napi_env env, napi_callback_info info) {
   size_t argc = 1;
@@ -28,10 +33,11 @@ napi_value Herb_lex(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
-  hb_array_T* tokens = herb_lex(string);
+  hb_array_T* tokens = herb_lex_n(string, length);
   napi_value result = CreateLexResult(env, tokens, args[0]);
 
   herb_free_tokens(&tokens);
@@ -63,6 +69,75 @@ napi_value Herb_lex_file(napi_env env, napi_callback_info info) {
   return result;
 }
 
+static void FreeBatchSources(std::vector<herb_source_T>* sources) {
+  for (const herb_source_T& source : *sources) {
+    free((void*) source.source);
+  }
+
+  sources->clear();
+}
+
+// Cancel callback for the `timeout` option, `data` is the deadline.
+static bool ParseDeadlinePassed(void* data) {
+  return std::chrono::steady_clock::now() >= *static_cast<std::chrono::steady_clock::time_point*>(data);
+}
+
+// Reads the `ParserOptions` object `value` into `options`. `timeout_ms` is negative without a `timeout`.
+// Returns whether an option differs from the defaults.
+static bool ReadParserOptions(napi_env env, napi_value value, parser_options_T* options, double* timeout_ms) {
+  *timeout_ms = -1;
+
+  napi_valuetype valuetype;
+  napi_typeof(env, value, &valuetype);
+  if (valuetype != napi_object) { return false; }
+
+  bool changed = false;
+  bool has_prop;
+  napi_has_named_property(env, value, "track_whitespace", &has_prop);
+
+  if (has_prop) {
+    napi_value track_whitespace_prop;
+    napi_get_named_property(env, value, "track_whitespace", &track_whitespace_prop);
+    bool track_whitespace_value;
+    napi_get_value_bool(env, track_whitespace_prop, &track_whitespace_value);
+
+    if (track_whitespace_value) {
+      options->track_whitespace = true;
+      changed = true;
+    }
+  }
+
+  napi_has_named_property(env, value, "timeout", &has_prop);
+
+  if (has_prop) {
+    napi_value timeout_prop;
+    napi_get_named_property(env, value, "timeout", &timeout_prop);
+
+    if (napi_get_value_double(env, timeout_prop, timeout_ms) == napi_ok && *timeout_ms >= 0) {
+      changed = true;
+    } else {
+      *timeout_ms = -1;
+    }
+  }
+
+  return changed;
+}
+
+// Points `options` at `deadline`, `timeout_ms` from now.
+static void StartParseDeadline(
+  parser_options_T* options,
+  double timeout_ms,
+  std::chrono::steady_clock::time_point* deadline
+) {
+  *deadline = std::chrono::steady_clock::now()
+    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double, std::milli>(timeout_ms)
+    );
+
+  options->cancel = ParseDeadlinePassed;
+  options->cancel_data = deadline;
+}
+
 napi_value Herb_parse(napi_env env, napi_callback_info info) {
   size_t argc = 2;
   napi_value args[2];
@@ -73,36 +148,23 @@ napi_value Herb_parse(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   parser_options_T* parser_options = nullptr;
   parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
 
-  if (argc >= 2) {
-    napi_valuetype valuetype;
-    napi_typeof(env, args[1], &valuetype);
-
-    if (valuetype == napi_object) {
-      napi_value track_whitespace_prop;
-      bool has_prop;
-      napi_has_named_property(env, args[1], "track_whitespace", &has_prop);
-
-      if (has_prop) {
-        napi_get_named_property(env, args[1], "track_whitespace", &track_whitespace_prop);
-        bool track_whitespace_value;
-        napi_get_value_bool(env, track_whitespace_prop, &track_whitespace_value);
-
-        if (track_whitespace_value) {
-          opts.track_whitespace = true;
-          parser_options = &opts;
-        }
-      }
-    }
+  if (argc >= 2 && ReadParserOptions(env, args[1], &opts, &timeout_ms)) {
+    if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+    parser_options = &opts;
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, parser_options);
-  herb_analyze_parse_tree(root, string);
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(string, length, parser_options);
+  herb_analyze_parse_tree_cancellable_n(root, string, length, opts.cancel, opts.cancel_data);
   napi_value result = CreateParseResult(env, root, args[0]);
 
   ast_node_free((AST_NODE_T *) root);
@@ -111,6 +173,317 @@ napi_value Herb_parse(napi_env env, napi_callback_info info) {
   return result;
 }
 
+// Like Herb_parse, but returns the document as a Buffer in the format of herb_serialize(),
+// which is decoded on the JavaScript side instead of creating every object through N-API.
+napi_value Herb_parse_serialized(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  parser_options_T* parser_options = nullptr;
+  parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
+
+  if (argc >= 2 && ReadParserOptions(env, args[1], &opts, &timeout_ms)) {
+    if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+    parser_options = &opts;
+  }
+
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(string, length, parser_options);
+  herb_analyze_parse_tree_cancellable_n(root, string, length, opts.cancel, opts.cancel_data);
+
+  hb_buffer_T output;
+
+  if (!hb_buffer_init(&output, length)) {
+    ast_node_free((AST_NODE_T *) root);
+    free(string);
+    napi_throw_error(env, nullptr, "Failed to initialize buffer");
+    return nullptr;
+  }
+
+  herb_serialize(root, &output);
+
+  napi_value result;
+  napi_create_buffer_copy(env, hb_buffer_length(&output), hb_buffer_value(&output), nullptr, &result);
+
+  free(output.value);
+  ast_node_free((AST_NODE_T *) root);
+  free(string);
+
+  return result;
+}
+
+// Copies the strings of the array `value` into `sources`. Returns false, with a pending exception
+// and nothing left to free, if `value` isn't an array of strings.
+static bool ReadBatchSources(napi_env env, napi_value value, std::vector<herb_source_T>* sources) {
+  bool is_array;
+  napi_is_array(env, value, &is_array);
+
+  if (!is_array) {
+    napi_throw_type_error(env, nullptr, "Array of strings expected");
+    return false;
+  }
+
+  uint32_t count;
+  napi_get_array_length(env, value, &count);
+  sources->reserve(count);
+
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value element;
+    napi_get_element(env, value, i, &element);
+
+    size_t length;
+    char* string = CheckString(env, element, &length);
+
+    if (!string) {
+      FreeBatchSources(sources);
+      return false;
+    }
+
+    sources->push_back({ string, length });
+  }
+
+  return true;
+}
+
+// The `threads` option of the batch functions, 0 (one per processor) if not given.
+static size_t ReadThreadCount(napi_env env, napi_value value) {
+  napi_valuetype valuetype;
+  napi_typeof(env, value, &valuetype);
+  if (valuetype != napi_object) { return 0; }
+
+  bool has_prop;
+  napi_has_named_property(env, value, "threads", &has_prop);
+  if (!has_prop) { return 0; }
+
+  napi_value threads_prop;
+  napi_get_named_property(env, value, "threads", &threads_prop);
+
+  uint32_t threads;
+  if (napi_get_value_uint32(env, threads_prop, &threads) != napi_ok) { return 0; }
+
+  return threads;
+}
+
+napi_value Herb_lex_batch(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  std::vector<herb_source_T> sources;
+  if (!ReadBatchSources(env, args[0], &sources)) { return nullptr; }
+
+  size_t threads = argc >= 2 ? ReadThreadCount(env, args[1]) : 0;
+  std::vector<hb_array_T*> tokens(sources.size());
+
+  herb_lex_batch(sources.data(), sources.size(), threads, tokens.data());
+
+  napi_value results;
+  napi_create_array_with_length(env, sources.size(), &results);
+
+  for (uint32_t i = 0; i < sources.size(); i++) {
+    napi_value source;
+    napi_get_element(env, args[0], i, &source);
+
+    napi_set_element(env, results, i, CreateLexResult(env, tokens[i], source));
+    herb_free_tokens(&tokens[i]);
+  }
+
+  FreeBatchSources(&sources);
+
+  return results;
+}
+
+// Parses every string of the array in the first argument across a pool of native threads. A
+// `timeout` in the options is a deadline for the whole batch; files that aren't done by then
+// come back cancelled.
+napi_value Herb_parse_batch(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  std::vector<herb_source_T> sources;
+  if (!ReadBatchSources(env, args[0], &sources)) { return nullptr; }
+
+  parser_options_T* parser_options = nullptr;
+  parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
+  size_t threads = 0;
+
+  if (argc >= 2) {
+    threads = ReadThreadCount(env, args[1]);
+
+    if (ReadParserOptions(env, args[1], &opts, &timeout_ms)) {
+      if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+      parser_options = &opts;
+    }
+  }
+
+  std::vector<AST_DOCUMENT_NODE_T*> documents(sources.size());
+
+  herb_parse_batch(sources.data(), sources.size(), parser_options, threads, documents.data());
+
+  napi_value results;
+  napi_create_array_with_length(env, sources.size(), &results);
+
+  for (uint32_t i = 0; i < sources.size(); i++) {
+    napi_value source;
+    napi_get_element(env, args[0], i, &source);
+
+    napi_set_element(env, results, i, CreateParseResult(env, documents[i], source));
+    ast_node_free((AST_NODE_T *) documents[i]);
+  }
+
+  FreeBatchSources(&sources);
+
+  return results;
+}
+
+// One lexAsync() or parseAsync() call. Execute runs on the libuv thread pool and must not touch
+// the JavaScript heap; Complete runs on the main thread, settles the promise and frees the rest.
+struct AsyncWork {
+  napi_async_work work;
+  napi_deferred deferred;
+  bool lex;
+  char* source;
+  size_t length;
+  parser_options_T options;
+  bool has_options;
+  double timeout_ms;
+  std::chrono::steady_clock::time_point deadline;
+  hb_array_T* tokens;
+  hb_buffer_T output;
+  bool serialized;
+};
+
+static void AsyncWork_execute(napi_env env, void* data) {
+  AsyncWork* async = static_cast<AsyncWork*>(data);
+
+  if (async->lex) {
+    async->tokens = herb_lex_n(async->source, async->length);
+    return;
+  }
+
+  // The deadline starts once a pool thread picks up the work, time spent in the queue doesn't count.
+  if (async->timeout_ms >= 0) { StartParseDeadline(&async->options, async->timeout_ms, &async->deadline); }
+
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(async->source, async->length, async->has_options ? &async->options : nullptr);
+  herb_analyze_parse_tree_cancellable_n(
+    root, async->source, async->length, async->options.cancel, async->options.cancel_data
+  );
+
+  if (hb_buffer_init(&async->output, async->length)) {
+    herb_serialize(root, &async->output);
+    async->serialized = true;
+  }
+
+  ast_node_free((AST_NODE_T *) root);
+}
+
+static void AsyncWork_complete(napi_env env, napi_status status, void* data) {
+  AsyncWork* async = static_cast<AsyncWork*>(data);
+  napi_value result;
+
+  if (status != napi_ok) {
+    napi_value message;
+    napi_create_string_utf8(env, "Async work was cancelled", NAPI_AUTO_LENGTH, &message);
+    napi_create_error(env, nullptr, message, &result);
+    napi_reject_deferred(env, async->deferred, result);
+  } else if (async->lex) {
+    napi_value source;
+    napi_create_string_utf8(env, async->source, async->length, &source);
+
+    result = CreateLexResult(env, async->tokens, source);
+    napi_resolve_deferred(env, async->deferred, result);
+  } else if (async->serialized) {
+    napi_create_buffer_copy(env, hb_buffer_length(&async->output), hb_buffer_value(&async->output), nullptr, &result);
+    napi_resolve_deferred(env, async->deferred, result);
+  } else {
+    napi_value message;
+    napi_create_string_utf8(env, "Failed to initialize buffer", NAPI_AUTO_LENGTH, &message);
+    napi_create_error(env, nullptr, message, &result);
+    napi_reject_deferred(env, async->deferred, result);
+  }
+
+  if (async->tokens) { herb_free_tokens(&async->tokens); }
+  if (async->serialized) { free(async->output.value); }
+
+  napi_delete_async_work(env, async->work);
+  free(async->source);
+  delete async;
+}
+
+// Queues the work for the first argument on the libuv thread pool and returns its promise.
+static napi_value QueueAsyncWork(napi_env env, napi_callback_info info, bool lex, const char* name) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  AsyncWork* async = new AsyncWork();
+  async->lex = lex;
+  async->source = string;
+  async->length = length;
+  async->timeout_ms = -1;
+
+  if (!lex && argc >= 2) {
+    async->has_options = ReadParserOptions(env, args[1], &async->options, &async->timeout_ms);
+  }
+
+  napi_value promise;
+  napi_create_promise(env, &async->deferred, &promise);
+
+  napi_value resource_name;
+  napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resource_name);
+
+  napi_create_async_work(env, nullptr, resource_name, AsyncWork_execute, AsyncWork_complete, async, &async->work);
+  napi_queue_async_work(env, async->work);
+
+  return promise;
+}
+
+// Lexes the first argument on the libuv thread pool. Returns a promise of the same result as Herb_lex.
+napi_value Herb_lex_async(napi_env env, napi_callback_info info) {
+  return QueueAsyncWork(env, info, true, "herb:lexAsync");
+}
+
+// Parses the first argument on the libuv thread pool. Returns a promise of the same Buffer as
+// Herb_parse_serialized, so only copying the bytes out is left for the main thread.
+napi_value Herb_parse_async(napi_env env, napi_callback_info info) {
+  return QueueAsyncWork(env, info, false, "herb:parseAsync");
+}
+
 napi_value Herb_parse_file(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value args[1];
@@ -126,13 +499,14 @@ napi_value Herb_parse_file(napi_env env, napi_callback_info info) {
 
   napi_value source_value = ReadFileToString(env, file_path);
 
-  char* string = CheckString(env, source_value);
+  size_t length;
+  char* string = CheckString(env, source_value, &length);
   if (!string) {
     free(file_path);
     return nullptr;
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, nullptr);
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(string, length, nullptr);
   napi_value result = CreateParseResult(env, root, source_value);
 
   ast_node_free((AST_NODE_T *) root);
@@ -152,20 +526,21 @@ napi_value Herb_extract_ruby(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   hb_buffer_T output;
-  if (!hb_buffer_init(&output, strlen(string))) {
+  if (!hb_buffer_init(&output, length)) {
     free(string);
     napi_throw_error(env, nullptr, "Failed to initialize buffer");
     return nullptr;
   }
 
-  herb_extract_ruby_to_buffer(string, &output);
+  herb_extract_ruby_to_buffer_n(string, length, &output);
 
   napi_value result;
-  napi_create_string_utf8(env, output.value, NAPI_AUTO_LENGTH, &result);
+  napi_create_string_utf8(env, output.value, output.length, &result);
 
   free(output.value);
   free(string);
@@ -182,20 +557,21 @@ napi_value Herb_extract_html(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   hb_buffer_T output;
-  if (!hb_buffer_init(&output, strlen(string))) {
+  if (!hb_buffer_init(&output, length)) {
     free(string);
     napi_throw_error(env, nullptr, "Failed to initialize buffer");
     return nullptr;
   }
 
-  herb_extract_html_to_buffer(string, &output);
+  herb_extract_html_to_buffer_n(string, length, &output);
 
   napi_value result;
-  napi_create_string_utf8(env, output.value, NAPI_AUTO_LENGTH, &result);
+  napi_create_string_utf8(env, output.value, output.length, &result);
 
   free(output.value);
   free(string);
@@ -215,14 +591,354 @@ napi_value Herb_version(napi_env env, napi_callback_info info) {
   return result;
 }
 
+struct LineIndexWrapper {
+  line_index_T* index;
+  char* source;
+};
+
+static napi_ref line_index_constructor = nullptr;
+
+static void LineIndex_finalize(napi_env env, void* data, void* hint) {
+  LineIndexWrapper* wrapper = static_cast<LineIndexWrapper*>(data);
+
+  line_index_free(&wrapper->index);
+  free(wrapper->source);
+  delete wrapper;
+}
+
+static line_index_T* LineIndex_unwrap(napi_env env, napi_callback_info info, size_t* argc, napi_value* args) {
+  napi_value self;
+  napi_get_cb_info(env, info, argc, args, &self, nullptr);
+
+  LineIndexWrapper* wrapper = nullptr;
+  napi_unwrap(env, self, reinterpret_cast<void**>(&wrapper));
+
+  if (!wrapper || !wrapper->index) {
+    napi_throw_error(env, nullptr, "LineIndex has been freed");
+    return nullptr;
+  }
+
+  return wrapper->index;
+}
+
+static bool GetUint32Arguments(napi_env env, size_t argc, napi_value* args, size_t expected, uint32_t* values) {
+  if (argc < expected) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return false;
+  }
+
+  for (size_t i = 0; i < expected; i++) {
+    if (napi_get_value_uint32(env, args[i], &values[i]) != napi_ok) {
+      napi_throw_type_error(env, nullptr, "Argument must be a number");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+napi_value LineIndex_constructor(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value self;
+  napi_get_cb_info(env, info, &argc, args, &self, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  // The index points into the source bytes, so the wrapper keeps its own copy.
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  LineIndexWrapper* wrapper = new LineIndexWrapper { line_index_init(string, length), string };
+  napi_wrap(env, self, wrapper, LineIndex_finalize, nullptr, nullptr);
+
+  return self;
+}
+
+napi_value LineIndex_line_count(napi_env env, napi_callback_info info) {
+  size_t argc = 0;
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, nullptr);
+  if (!index) { return nullptr; }
+
+  napi_value result;
+  napi_create_uint32(env, line_index_line_count(index), &result);
+
+  return result;
+}
+
+napi_value LineIndex_line_start(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  uint32_t values[1];
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, args);
+  if (!index || !GetUint32Arguments(env, argc, args, 1, values)) { return nullptr; }
+
+  napi_value result;
+  napi_create_uint32(env, line_index_line_start(index, values[0]), &result);
+
+  return result;
+}
+
+napi_value LineIndex_position_at(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  uint32_t values[1];
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, args);
+  if (!index || !GetUint32Arguments(env, argc, args, 1, values)) { return nullptr; }
+
+  return CreatePosition(env, line_index_position(index, values[0]));
+}
+
+napi_value LineIndex_offset_at(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  uint32_t values[2];
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, args);
+  if (!index || !GetUint32Arguments(env, argc, args, 2, values)) { return nullptr; }
+
+  position_T position = { values[0], values[1] };
+
+  napi_value result;
+  napi_create_uint32(env, line_index_offset(index, position), &result);
+
+  return result;
+}
+
+napi_value LineIndex_utf16_position_at(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  uint32_t values[1];
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, args);
+  if (!index || !GetUint32Arguments(env, argc, args, 1, values)) { return nullptr; }
+
+  return CreatePosition(env, line_index_utf16_position(index, values[0]));
+}
+
+napi_value LineIndex_offset_at_utf16(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  uint32_t values[2];
+  line_index_T* index = LineIndex_unwrap(env, info, &argc, args);
+  if (!index || !GetUint32Arguments(env, argc, args, 2, values)) { return nullptr; }
+
+  position_T position = { values[0], values[1] };
+
+  napi_value result;
+  napi_create_uint32(env, line_index_offset_from_utf16(index, position), &result);
+
+  return result;
+}
+
+napi_value LineIndex_free(napi_env env, napi_callback_info info) {
+  napi_value self;
+  napi_get_cb_info(env, info, nullptr, nullptr, &self, nullptr);
+
+  LineIndexWrapper* wrapper = nullptr;
+  napi_unwrap(env, self, reinterpret_cast<void**>(&wrapper));
+
+  if (wrapper) {
+    line_index_free(&wrapper->index);
+    free(wrapper->source);
+    wrapper->source = nullptr;
+  }
+
+  return nullptr;
+}
+
+napi_value Herb_line_index(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  napi_value constructor;
+  napi_get_reference_value(env, line_index_constructor, &constructor);
+
+  napi_value result;
+  if (napi_new_instance(env, constructor, 1, args, &result) != napi_ok) { return nullptr; }
+
+  return result;
+}
+
+struct IncrementalParserWrapper {
+  AST_DOCUMENT_NODE_T* document;
+  char* source; // the tokens of `document` point into it
+  size_t length;
+  parser_options_T options;
+  double timeout_ms;
+};
+
+static napi_ref incremental_parser_constructor = nullptr;
+
+static void IncrementalParser_release(IncrementalParserWrapper* wrapper) {
+  ast_node_free((AST_NODE_T*) wrapper->document);
+  free(wrapper->source);
+
+  wrapper->document = nullptr;
+  wrapper->source = nullptr;
+  wrapper->length = 0;
+}
+
+static void IncrementalParser_finalize(napi_env env, void* data, void* hint) {
+  IncrementalParserWrapper* wrapper = static_cast<IncrementalParserWrapper*>(data);
+
+  IncrementalParser_release(wrapper);
+  delete wrapper;
+}
+
+napi_value IncrementalParser_constructor(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value self;
+  napi_get_cb_info(env, info, &argc, args, &self, nullptr);
+
+  IncrementalParserWrapper* wrapper = new IncrementalParserWrapper { nullptr, nullptr, 0, {0}, -1 };
+  if (argc >= 1) { ReadParserOptions(env, args[0], &wrapper->options, &wrapper->timeout_ms); }
+
+  napi_wrap(env, self, wrapper, IncrementalParser_finalize, nullptr, nullptr);
+
+  return self;
+}
+
+// Parses the next version of the document, reusing what the edit since the previous one left intact.
+napi_value IncrementalParser_parse(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value self;
+  napi_get_cb_info(env, info, &argc, args, &self, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  IncrementalParserWrapper* wrapper = nullptr;
+  napi_unwrap(env, self, reinterpret_cast<void**>(&wrapper));
+
+  if (!wrapper) {
+    napi_throw_error(env, nullptr, "IncrementalParser has been freed");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  parser_options_T options = wrapper->options;
+  std::chrono::steady_clock::time_point deadline;
+
+  if (wrapper->timeout_ms >= 0) { StartParseDeadline(&options, wrapper->timeout_ms, &deadline); }
+
+  if (wrapper->document == nullptr) {
+    wrapper->document = herb_parse_n(string, length, &options);
+    herb_analyze_parse_tree_cancellable_n(wrapper->document, string, length, options.cancel, options.cancel_data);
+  } else {
+    herb_edit_T edit = herb_edit_from_sources(wrapper->source, wrapper->length, string, length);
+
+    wrapper->document =
+      herb_reparse_n(wrapper->document, wrapper->source, wrapper->length, string, length, edit, &options);
+  }
+
+  free(wrapper->source);
+  wrapper->source = string;
+  wrapper->length = length;
+
+  return CreateParseResult(env, wrapper->document, args[0]);
+}
+
+napi_value IncrementalParser_free(napi_env env, napi_callback_info info) {
+  napi_value self;
+  size_t argc = 0;
+  napi_get_cb_info(env, info, &argc, nullptr, &self, nullptr);
+
+  // Removing the wrap makes later calls throw "has been freed" instead of starting over with a new document.
+  IncrementalParserWrapper* wrapper = nullptr;
+
+  if (napi_remove_wrap(env, self, reinterpret_cast<void**>(&wrapper)) == napi_ok && wrapper) {
+    IncrementalParser_finalize(env, wrapper, nullptr);
+  }
+
+  return nullptr;
+}
+
+napi_value Herb_incremental_parser(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  napi_value constructor;
+  napi_get_reference_value(env, incremental_parser_constructor, &constructor);
+
+  napi_value result;
+  if (napi_new_instance(env, constructor, argc, args, &result) != napi_ok) { return nullptr; }
+
+  return result;
+}
+
 napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor line_index_methods[] = {
+    { "lineCount", nullptr, LineIndex_line_count, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "lineStart", nullptr, LineIndex_line_start, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "positionAt", nullptr, LineIndex_position_at, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "offsetAt", nullptr, LineIndex_offset_at, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "utf16PositionAt", nullptr, LineIndex_utf16_position_at, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "offsetAtUtf16", nullptr, LineIndex_offset_at_utf16, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "free", nullptr, LineIndex_free, nullptr, nullptr, nullptr, napi_default, nullptr },
+  };
+
+  napi_value line_index_class;
+  napi_define_class(
+    env,
+    "LineIndex",
+    NAPI_AUTO_LENGTH,
+    LineIndex_constructor,
+    nullptr,
+    sizeof(line_index_methods) / sizeof(line_index_methods[0]),
+    line_index_methods,
+    &line_index_class
+  );
+  napi_create_reference(env, line_index_class, 1, &line_index_constructor);
+
+  napi_property_descriptor incremental_parser_methods[] = {
+    { "parse", nullptr, IncrementalParser_parse, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "free", nullptr, IncrementalParser_free, nullptr, nullptr, nullptr, napi_default, nullptr },
+  };
+
+  napi_value incremental_parser_class;
+  napi_define_class(
+    env,
+    "IncrementalParser",
+    NAPI_AUTO_LENGTH,
+    IncrementalParser_constructor,
+    nullptr,
+    sizeof(incremental_parser_methods) / sizeof(incremental_parser_methods[0]),
+    incremental_parser_methods,
+    &incremental_parser_class
+  );
+  napi_create_reference(env, incremental_parser_class, 1, &incremental_parser_constructor);
+
   napi_property_descriptor descriptors[] = {
     { "parse", nullptr, Herb_parse, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseSerialized", nullptr, Herb_parse_serialized, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseAsync", nullptr, Herb_parse_async, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "lex", nullptr, Herb_lex, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "parseFile", nullptr, Herb_parse_file, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "lexFile", nullptr, Herb_lex_file, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "lexAsync", nullptr, Herb_lex_async, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseBatch", nullptr, Herb_parse_batch, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "lexBatch", nullptr, Herb_lex_batch, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "extractRuby", nullptr, Herb_extract_ruby, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "extractHTML", nullptr, Herb_extract_html, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "lineIndex", nullptr, Herb_line_index, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "incrementalParser", nullptr, Herb_incremental_parser, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "version", nullptr, Herb_version, nullptr, nullptr, nullptr, napi_default, nullptr },
   };
 
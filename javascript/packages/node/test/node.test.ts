@@ -1,5 +1,5 @@
 import { describe, test, expect, beforeAll } from "vitest"
-import { Herb, HerbBackend } from "../src/index-esm.mjs"
+import { Herb, HerbBackend, SERIALIZATION_VERSION, deserializeParseResult } from "../src/index-esm.mjs"
 
 describe("@herb-tools/node", () => {
   beforeAll(async () => {
@@ -98,4 +98,103 @@ describe("@herb-tools/node", () => {
     expect(result.value.inspect()).toContain("@ WhitespaceNode")
     expect(result.value.inspect()).toContain('"   "')
   })
+
+  test("lineIndex() converts between byte offsets and UTF-16 positions", async () => {
+    const index = Herb.lineIndex("<p>é</p>\n<%= 😀 %>x")
+
+    expect(index.lineCount).toBe(2)
+    expect(index.lineStart(2)).toBe(10)
+    expect(index.positionAt(18).toHash()).toEqual({ line: 2, column: 8 })
+    expect(index.utf16PositionAt(18).toHash()).toEqual({ line: 2, column: 6 })
+    expect(index.offsetAtUtf16({ line: 2, column: 6 })).toBe(18)
+
+    index.free()
+  })
+
+  test("incrementalParser() returns the same tree as parse() after each edit", async () => {
+    const parser = Herb.incrementalParser()
+    const versions = [
+      "<div>a</div>\n<p><%= b %></p>\n<span>c</span>",
+      "<div>a</div>\n<p><%= long_name %></p>\n<span>c</span>",
+      "<div>a</div>\n<p><%= long_name %>\n</p>\n<span>é</span>",
+      "<div>a</div>\n<p><%= long_name %>\n</p>\n<span>é",
+      "<div>a</div>\n<span>é</span>",
+    ]
+
+    for (const source of versions) {
+      const result = parser.parse(source)
+
+      expect(result.value.inspect()).toEqual(Herb.parse(source).value.inspect())
+    }
+
+    parser.free()
+  })
+
+  test("incrementalParser() throws once it has been freed", async () => {
+    const parser = Herb.incrementalParser()
+
+    parser.parse("<div><%= a %></div>")
+    parser.free()
+
+    expect(() => parser.parse("<div><%= b %></div>")).toThrow("IncrementalParser has been freed")
+    expect(() => parser.free()).not.toThrow()
+  })
+
+  test("parseBatch() and lexBatch() return the same results as parse() and lex()", async () => {
+    const sources = [
+      "<div class='a'><%= title %></div>",
+      "<% if x %><p>yes</p><% end %>",
+      "<span>unclosed",
+      "",
+    ]
+
+    const parseResults = Herb.parseBatch(sources, { threads: 2 })
+    const lexResults = Herb.lexBatch(sources)
+
+    expect(parseResults).toHaveLength(sources.length)
+
+    sources.forEach((source, index) => {
+      expect(parseResults[index].value.inspect()).toEqual(Herb.parse(source).value.inspect())
+      expect(lexResults[index].value.inspect()).toEqual(Herb.lex(source).value.inspect())
+    })
+  })
+
+  test("parseSerialized() decodes to the same result as parse()", async () => {
+    const sources = [
+      "<div class='a'><%= title %></div>",
+      "<% if x %>\n  <p>yes</p>\n<% end %>",
+      "<span>unclosed <%= é %>",
+      "<div>\n  <p class=\"a\">text</p>\n</span>",
+      "",
+    ]
+
+    for (const source of sources) {
+      for (const options of [{}, { track_whitespace: true }]) {
+        const bytes = Herb.backend!.parseSerialized(source, options)
+
+        expect(new TextDecoder().decode(bytes.subarray(0, 4))).toBe("HERB")
+        expect(bytes[4]).toBe(SERIALIZATION_VERSION)
+        expect(deserializeParseResult(bytes, source)).toEqual(Herb.backend!.parse(source, options))
+      }
+    }
+  })
+
+  test("parseAsync() and lexAsync() return the same results as parse() and lex()", async () => {
+    const sources = [
+      "<div class='a'><%= title %></div>",
+      "<% if x %><p>yes</p><% end %>",
+      "<span>unclosed",
+      "",
+    ]
+
+    const parseResults = await Promise.all(sources.map((source) => Herb.parseAsync(source, { track_whitespace: true })))
+    const lexResults = await Promise.all(sources.map((source) => Herb.lexAsync(source)))
+
+    sources.forEach((source, index) => {
+      expect(parseResults[index].value.inspect()).toEqual(Herb.parse(source, { track_whitespace: true }).value.inspect())
+      expect(lexResults[index].value.inspect()).toEqual(Herb.lex(source).value.inspect())
+    })
+
+    await expect(Herb.parseAsync(42 as any)).rejects.toThrow()
+  })
 })
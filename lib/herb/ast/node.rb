@@ -3,10 +3,11 @@
 
 module Herb
   module AST
+    # Nodes returned by the parser are created empty and read their fields from the
+    # native tree on first access (see `load_native_fields` in the C extension), so
+    # parts of the tree that are never touched don't allocate any Ruby objects.
     class Node
       attr_reader :type #: String
-      attr_reader :location #: Location
-      attr_reader :errors #: Array[Herb::Errors::Error]
 
       #: (String, Location, Array[Herb::Errors::Error]) -> void
       def initialize(type, location, errors = [])
@@ -15,6 +16,18 @@ module Herb
         @errors = errors
       end
 
+      #: () -> Location
+      def location
+        load_native_fields unless @location
+        @location
+      end
+
+      #: () -> Array[Herb::Errors::Error]
+      def errors
+        load_native_fields unless @location
+        @errors
+      end
+
       #: () -> serialized_node
       def to_hash
         {
@@ -104,7 +117,7 @@ module Herb
 
       #: () -> Array[Herb::Errors::Error]
       def recursive_errors
-        errors + compact_child_nodes.flat_map(&:recursive_errors)
+        native_recursive_errors || (errors + compact_child_nodes.flat_map(&:recursive_errors))
       end
     end
   end
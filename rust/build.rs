@@ -78,6 +78,7 @@ fn main() {
   let bindings = bindgen::Builder::default()
     .header(include_dir.join("analyze.h").to_str().unwrap())
     .header(include_dir.join("herb.h").to_str().unwrap())
+    .header(include_dir.join("line_index.h").to_str().unwrap())
     .header(include_dir.join("ast_nodes.h").to_str().unwrap())
     .header(include_dir.join("errors.h").to_str().unwrap())
     .header(include_dir.join("element_source.h").to_str().unwrap())
@@ -91,6 +92,7 @@ fn main() {
     .allowlist_function("token_type_to_string")
     .allowlist_function("ast_node_free")
     .allowlist_function("element_source_to_string")
+    .allowlist_function("line_index_.*")
     .allowlist_type("AST_.*")
     .allowlist_type("ERROR_.*")
     .allowlist_type(".*_ERROR_T")
@@ -102,7 +104,10 @@ fn main() {
     .allowlist_type("token_T")
     .allowlist_type("position_T")
     .allowlist_type("location_T")
+    .allowlist_type("line_index_T")
+    .allowlist_type("herb_token_stream_T")
     .allowlist_type("herb_extract_language_T")
+    .allowlist_type("herb_source_T")
     .allowlist_var("AST_.*")
     .allowlist_var("ERROR_.*")
     .allowlist_var("ELEMENT_SOURCE_.*")
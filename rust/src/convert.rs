@@ -25,14 +25,15 @@ impl From<location_T> for Location {
 /// # Safety
 ///
 /// The caller must ensure that `token_ptr` is a valid, non-null pointer to a `token_T`
-/// and that the token's string fields (`value`, `token_type`) point to valid C strings.
+/// and that the token's `value` still points into the source it was lexed from.
 pub unsafe fn token_from_c(token_ptr: *const token_T) -> Token {
   let token = &*token_ptr;
 
-  let value = if token.value.is_null() {
+  let value = if token.value.data.is_null() {
     String::new()
   } else {
-    CStr::from_ptr(token.value).to_string_lossy().into_owned()
+    let slice = std::slice::from_raw_parts(token.value.data as *const u8, token.value.length as usize);
+    String::from_utf8_lossy(slice).into_owned()
   };
 
   let token_type = CStr::from_ptr(crate::ffi::token_type_to_string(token.type_))
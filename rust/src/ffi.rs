@@ -1,5 +1,10 @@
 pub use crate::bindings::{
   ast_node_free, element_source_to_string, hb_array_get, hb_array_size, hb_string_T,
-  herb_analyze_parse_tree, herb_extract, herb_free_tokens, herb_lex, herb_parse,
-  herb_prism_version, herb_version, token_type_to_string,
+  herb_analyze_parse_tree, herb_analyze_parse_tree_n, herb_extract, herb_extract_n,
+  herb_free_tokens, herb_lex, herb_lex_batch, herb_lex_n, herb_parse, herb_parse_batch,
+  herb_parse_n, herb_prism_version, herb_token_stream_T, herb_token_stream_end,
+  herb_token_stream_free, herb_token_stream_init_n, herb_token_stream_start,
+  herb_token_stream_type, herb_version, line_index_T, line_index_free, line_index_init,
+  line_index_line_count, line_index_line_start, line_index_offset, line_index_offset_from_utf16,
+  line_index_position, line_index_utf16_position, position_T, token_type_to_string,
 };
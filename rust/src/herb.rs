@@ -1,92 +1,148 @@
-use crate::bindings::{hb_array_T, token_T};
+use crate::bindings::{hb_array_T, herb_source_T, token_T, AST_DOCUMENT_NODE_T};
 use crate::convert::token_from_c;
 use crate::{LexResult, ParseResult};
-use std::ffi::CString;
+use std::os::raw::c_char;
 
 pub fn lex(source: &str) -> Result<LexResult, String> {
   unsafe {
-    let c_source = CString::new(source).map_err(|e| e.to_string())?;
-    let c_tokens = crate::ffi::herb_lex(c_source.as_ptr());
+    let c_tokens = crate::ffi::herb_lex_n(source.as_ptr() as *const c_char, source.len());
 
-    if c_tokens.is_null() {
-      return Err("Failed to lex source".to_string());
-    }
-
-    let array_size = crate::ffi::hb_array_size(c_tokens);
-    let mut tokens = Vec::with_capacity(array_size);
-
-    for index in 0..array_size {
-      let token_ptr = crate::ffi::hb_array_get(c_tokens, index) as *const token_T;
-
-      if !token_ptr.is_null() {
-        tokens.push(token_from_c(token_ptr));
-      }
-    }
-
-    let mut c_tokens_ptr = c_tokens;
-    crate::ffi::herb_free_tokens(&mut c_tokens_ptr as *mut *mut hb_array_T);
-
-    Ok(LexResult::new(tokens))
+    lex_result_from_c(c_tokens)
   }
 }
 
 pub fn parse(source: &str) -> Result<ParseResult, String> {
   unsafe {
-    let c_source = CString::new(source).map_err(|e| e.to_string())?;
-    let ast = crate::ffi::herb_parse(c_source.as_ptr(), std::ptr::null_mut());
+    let c_source = source.as_ptr() as *const c_char;
+    let ast = crate::ffi::herb_parse_n(c_source, source.len(), std::ptr::null_mut());
 
     if ast.is_null() {
       return Err("Failed to parse source".to_string());
     }
 
-    crate::ffi::herb_analyze_parse_tree(ast, c_source.as_ptr());
+    crate::ffi::herb_analyze_parse_tree_n(ast, c_source, source.len());
 
-    let document_node = crate::ast::convert_document_node(ast as *const std::ffi::c_void)
-      .ok_or_else(|| "Failed to convert AST".to_string())?;
+    parse_result_from_c(ast, source)
+  }
+}
 
-    let result = ParseResult::new(document_node, source.to_string(), Vec::new());
+/// Lexes every source on a pool of native threads, one per processor.
+/// The results are in the same order as `sources`.
+pub fn lex_batch(sources: &[&str]) -> Vec<Result<LexResult, String>> {
+  let batch = batch_sources(sources);
+  let mut c_tokens = vec![std::ptr::null_mut(); sources.len()];
 
-    crate::ffi::ast_node_free(ast as *mut crate::bindings::AST_NODE_T);
+  unsafe {
+    crate::ffi::herb_lex_batch(batch.as_ptr(), batch.len(), 0, c_tokens.as_mut_ptr());
 
-    Ok(result)
+    c_tokens
+      .into_iter()
+      .map(|tokens| lex_result_from_c(tokens))
+      .collect()
   }
 }
 
-pub fn extract_ruby(source: &str) -> Result<String, String> {
+/// Parses every source on a pool of native threads, one per processor.
+/// The results are the same as `parse` returns, in the same order as `sources`.
+pub fn parse_batch(sources: &[&str]) -> Vec<Result<ParseResult, String>> {
+  let batch = batch_sources(sources);
+  let mut asts = vec![std::ptr::null_mut(); sources.len()];
+
   unsafe {
-    let c_source = CString::new(source).map_err(|e| e.to_string())?;
-    let result = crate::ffi::herb_extract(
-      c_source.as_ptr(),
-      crate::bindings::HERB_EXTRACT_LANGUAGE_RUBY,
+    crate::ffi::herb_parse_batch(
+      batch.as_ptr(),
+      batch.len(),
+      std::ptr::null_mut(),
+      0,
+      asts.as_mut_ptr(),
     );
 
-    if result.is_null() {
-      return Ok(String::new());
-    }
+    asts
+      .into_iter()
+      .zip(sources)
+      .map(|(ast, source)| {
+        if ast.is_null() {
+          return Err("Failed to parse source".to_string());
+        }
+
+        parse_result_from_c(ast, source)
+      })
+      .collect()
+  }
+}
 
-    let c_str = std::ffi::CStr::from_ptr(result);
-    let rust_str = c_str.to_string_lossy().into_owned();
+fn batch_sources(sources: &[&str]) -> Vec<herb_source_T> {
+  sources
+    .iter()
+    .map(|source| herb_source_T {
+      source: source.as_ptr() as *const c_char,
+      length: source.len(),
+    })
+    .collect()
+}
 
-    libc::free(result as *mut std::ffi::c_void);
+/// Converts and frees the tokens returned by `herb_lex_n`.
+unsafe fn lex_result_from_c(c_tokens: *mut hb_array_T) -> Result<LexResult, String> {
+  if c_tokens.is_null() {
+    return Err("Failed to lex source".to_string());
+  }
 
-    Ok(rust_str)
+  let array_size = crate::ffi::hb_array_size(c_tokens);
+  let mut tokens = Vec::with_capacity(array_size);
+
+  for index in 0..array_size {
+    let token_ptr = crate::ffi::hb_array_get(c_tokens, index) as *const token_T;
+
+    if !token_ptr.is_null() {
+      tokens.push(token_from_c(token_ptr));
+    }
   }
+
+  let mut c_tokens_ptr = c_tokens;
+  crate::ffi::herb_free_tokens(&mut c_tokens_ptr as *mut *mut hb_array_T);
+
+  Ok(LexResult::new(tokens))
+}
+
+/// Converts and frees an analyzed document of `source`.
+unsafe fn parse_result_from_c(
+  ast: *mut AST_DOCUMENT_NODE_T,
+  source: &str,
+) -> Result<ParseResult, String> {
+  let document_node = crate::ast::convert_document_node(ast as *const std::ffi::c_void);
+
+  let result = document_node
+    .map(|document_node| ParseResult::new(document_node, source.to_string(), Vec::new()))
+    .ok_or_else(|| "Failed to convert AST".to_string());
+
+  crate::ffi::ast_node_free(ast as *mut crate::bindings::AST_NODE_T);
+
+  result
+}
+
+pub fn extract_ruby(source: &str) -> Result<String, String> {
+  extract(source, crate::bindings::HERB_EXTRACT_LANGUAGE_RUBY)
 }
 
 pub fn extract_html(source: &str) -> Result<String, String> {
+  extract(source, crate::bindings::HERB_EXTRACT_LANGUAGE_HTML)
+}
+
+fn extract(
+  source: &str,
+  language: crate::bindings::herb_extract_language_T,
+) -> Result<String, String> {
   unsafe {
-    let c_source = CString::new(source).map_err(|e| e.to_string())?;
-    let result = crate::ffi::herb_extract(
-      c_source.as_ptr(),
-      crate::bindings::HERB_EXTRACT_LANGUAGE_HTML,
-    );
+    let result =
+      crate::ffi::herb_extract_n(source.as_ptr() as *const c_char, source.len(), language);
 
     if result.is_null() {
       return Ok(String::new());
     }
 
-    let c_str = std::ffi::CStr::from_ptr(result);
-    let rust_str = c_str.to_string_lossy().into_owned();
+    // The extracted source keeps every byte offset, so it is exactly as long as the input.
+    let bytes = std::slice::from_raw_parts(result as *const u8, source.len());
+    let rust_str = String::from_utf8_lossy(bytes).into_owned();
 
     libc::free(result as *mut std::ffi::c_void);
 
@@ -5,21 +5,28 @@ pub mod errors;
 pub mod ffi;
 pub mod herb;
 pub mod lex_result;
+pub mod line_index;
 pub mod location;
 pub mod nodes;
 pub mod parse_result;
 pub mod position;
 pub mod range;
 pub mod token;
+pub mod token_stream;
 
 pub use errors::{AnyError, ErrorNode, ErrorType};
-pub use herb::{extract_html, extract_ruby, herb_version, lex, parse, prism_version, version};
+pub use herb::{
+  extract_html, extract_ruby, herb_version, lex, lex_batch, parse, parse_batch, prism_version,
+  version,
+};
 pub use lex_result::LexResult;
+pub use line_index::LineIndex;
 pub use location::Location;
 pub use nodes::{AnyNode, Node};
 pub use parse_result::ParseResult;
 pub use position::Position;
 pub use range::Range;
 pub use token::Token;
+pub use token_stream::TokenStream;
 
 pub const VERSION: &str = "0.8.2";
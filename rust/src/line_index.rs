@@ -0,0 +1,59 @@
+use crate::ffi::{line_index_T, position_T};
+use crate::Position;
+
+/// Converts between byte offsets and line/column positions of a source.
+///
+/// Lines are 1-based and columns 0-based. The `utf16` variants count columns in
+/// UTF-16 code units, as editors and the Language Server Protocol do.
+pub struct LineIndex {
+  index: *mut line_index_T,
+  // The C index points into these bytes, so they live (and stay put) as long as it does.
+  _source: Box<[u8]>,
+}
+
+impl LineIndex {
+  pub fn new(source: &str) -> Self {
+    let source: Box<[u8]> = source.as_bytes().into();
+    let index = unsafe { crate::ffi::line_index_init(source.as_ptr() as *const _, source.len()) };
+
+    Self { index, _source: source }
+  }
+
+  pub fn line_count(&self) -> u32 {
+    unsafe { crate::ffi::line_index_line_count(self.index) }
+  }
+
+  pub fn line_start(&self, line: u32) -> u32 {
+    unsafe { crate::ffi::line_index_line_start(self.index, line) }
+  }
+
+  pub fn position_at(&self, offset: u32) -> Position {
+    position_from_c(unsafe { crate::ffi::line_index_position(self.index, offset) })
+  }
+
+  pub fn offset_at(&self, position: Position) -> u32 {
+    unsafe { crate::ffi::line_index_offset(self.index, position_to_c(position)) }
+  }
+
+  pub fn utf16_position_at(&self, offset: u32) -> Position {
+    position_from_c(unsafe { crate::ffi::line_index_utf16_position(self.index, offset) })
+  }
+
+  pub fn offset_at_utf16(&self, position: Position) -> u32 {
+    unsafe { crate::ffi::line_index_offset_from_utf16(self.index, position_to_c(position)) }
+  }
+}
+
+impl Drop for LineIndex {
+  fn drop(&mut self) {
+    unsafe { crate::ffi::line_index_free(&mut self.index) }
+  }
+}
+
+fn position_from_c(position: position_T) -> Position {
+  Position::new(position.line, position.column)
+}
+
+fn position_to_c(position: Position) -> position_T {
+  position_T { line: position.line, column: position.column }
+}
@@ -0,0 +1,93 @@
+use crate::ffi::herb_token_stream_T;
+use crate::{Location, Range};
+use std::ffi::CStr;
+
+/// The tokens of a source in columnar form: the same tokens `lex` returns, without
+/// allocating a `Token` for each of them.
+///
+/// Positions are derived on demand and match `Token::location`.
+pub struct TokenStream {
+  stream: herb_token_stream_T,
+  // The C stream points into these bytes, so they live (and stay put) as long as it does.
+  _source: Box<[u8]>,
+}
+
+impl TokenStream {
+  pub fn new(source: &str) -> Self {
+    let source: Box<[u8]> = source.as_bytes().into();
+    let mut stream: herb_token_stream_T = unsafe { std::mem::zeroed() };
+
+    unsafe {
+      crate::ffi::herb_token_stream_init_n(&mut stream, source.as_ptr() as *const _, source.len())
+    };
+
+    Self {
+      stream,
+      _source: source,
+    }
+  }
+
+  pub fn len(&self) -> usize {
+    self.stream.size
+  }
+
+  pub fn is_empty(&self) -> bool {
+    self.stream.size == 0
+  }
+
+  pub fn token_type(&self, index: usize) -> String {
+    self.check_index(index);
+
+    unsafe {
+      let token_type = crate::ffi::herb_token_stream_type(&self.stream, index);
+
+      CStr::from_ptr(crate::ffi::token_type_to_string(token_type))
+        .to_string_lossy()
+        .into_owned()
+    }
+  }
+
+  /// The source text of the token, also for error tokens.
+  pub fn value(&self, index: usize) -> String {
+    let range = self.range(index);
+
+    String::from_utf8_lossy(&self._source[range.from..range.to]).into_owned()
+  }
+
+  pub fn range(&self, index: usize) -> Range {
+    self.check_index(index);
+
+    unsafe {
+      Range::new(
+        *self.stream.starts.add(index) as usize,
+        *self.stream.ends.add(index) as usize,
+      )
+    }
+  }
+
+  pub fn location(&mut self, index: usize) -> Location {
+    self.check_index(index);
+
+    unsafe {
+      let start = crate::ffi::herb_token_stream_start(&mut self.stream, index);
+      let end = crate::ffi::herb_token_stream_end(&mut self.stream, index);
+
+      Location::new(start.into(), end.into())
+    }
+  }
+
+  fn check_index(&self, index: usize) {
+    assert!(
+      index < self.stream.size,
+      "index {} outside of token stream (len {})",
+      index,
+      self.stream.size
+    );
+  }
+}
+
+impl Drop for TokenStream {
+  fn drop(&mut self) {
+    unsafe { crate::ffi::herb_token_stream_free(&mut self.stream) }
+  }
+}
@@ -0,0 +1,31 @@
+use herb::{lex, lex_batch, parse, parse_batch};
+
+const SOURCES: [&str; 4] = [
+  "<div class=\"a\"><%= title %></div>",
+  "<% if x %><p>yes</p><% else %><p>no</p><% end %>",
+  "<span>unclosed",
+  "",
+];
+
+#[test]
+fn test_parse_batch_matches_parse() {
+  let results = parse_batch(&SOURCES);
+
+  assert_eq!(results.len(), SOURCES.len());
+
+  for (source, result) in SOURCES.iter().zip(results) {
+    let expected = parse(source).unwrap();
+    let actual = result.unwrap();
+
+    assert_eq!(actual.inspect(), expected.inspect());
+  }
+}
+
+#[test]
+fn test_lex_batch_matches_lex() {
+  let results = lex_batch(&SOURCES);
+
+  for (source, result) in SOURCES.iter().zip(results) {
+    assert_eq!(result.unwrap().inspect(), lex(source).unwrap().inspect());
+  }
+}
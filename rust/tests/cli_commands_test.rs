@@ -22,6 +22,13 @@ fn test_extract_html() {
   assert_eq!(html, "<div>           </div>");
 }
 
+#[test]
+fn test_extract_with_nul_bytes() {
+  let source = "<p>a\0b</p><%= x\0 %>";
+  assert_eq!(extract_ruby(source).unwrap(), "              x\0  ;");
+  assert_eq!(extract_html(source).unwrap(), "<p>a\0b</p>         ");
+}
+
 #[test]
 fn test_extract_ruby_complex() {
   let source = r#"<div>
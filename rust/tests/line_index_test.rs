@@ -0,0 +1,28 @@
+use herb::{LineIndex, Position};
+
+#[test]
+fn test_line_count_and_starts() {
+  let index = LineIndex::new("a\nb\r\nc\rd");
+
+  assert_eq!(index.line_count(), 4);
+  assert_eq!(index.line_start(1), 0);
+  assert_eq!(index.line_start(2), 2);
+  assert_eq!(index.line_start(3), 5);
+  assert_eq!(index.line_start(4), 7);
+}
+
+#[test]
+fn test_byte_positions() {
+  let index = LineIndex::new("<div>\n  <%= foo %>\n</div>");
+
+  assert_eq!(index.position_at(10), Position::new(2, 4));
+  assert_eq!(index.offset_at(Position::new(2, 4)), 10);
+}
+
+#[test]
+fn test_utf16_positions() {
+  let index = LineIndex::new("é\n😀x");
+
+  assert_eq!(index.utf16_position_at(7), Position::new(2, 2));
+  assert_eq!(index.offset_at_utf16(Position::new(2, 2)), 7);
+}
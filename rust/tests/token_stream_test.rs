@@ -0,0 +1,41 @@
+use herb::{lex, TokenStream};
+
+#[test]
+fn test_matches_lex_on_crlf_and_multibyte_input() {
+  let sources = [
+    "<p>é</p>\r\n<% if é\r\n  x = 1\r\n%>\r\n<b>é</b>",
+    "<div title=\"é\r\né\">\r\n  é<%= é %>é\r\n</div>",
+    "<b>é</b>\r\n<% é\r\n é",
+  ];
+
+  for source in sources {
+    let tokens = lex(source).unwrap();
+    let mut stream = TokenStream::new(source);
+
+    assert_eq!(stream.len(), tokens.tokens().len());
+
+    for (index, token) in tokens.tokens().iter().enumerate() {
+      assert_eq!(stream.token_type(index), token.token_type);
+      assert_eq!(stream.range(index), token.range);
+      assert_eq!(stream.location(index), token.location);
+    }
+  }
+}
+
+#[test]
+fn test_value() {
+  let stream = TokenStream::new("<p>é</p>");
+
+  assert_eq!(stream.token_type(0), "TOKEN_HTML_TAG_START");
+  assert_eq!(stream.value(0), "<");
+  assert_eq!(stream.value(3), "é");
+  assert_eq!(stream.token_type(stream.len() - 1), "TOKEN_EOF");
+}
+
+#[test]
+#[should_panic]
+fn test_index_outside_of_stream() {
+  let stream = TokenStream::new("<p>");
+
+  stream.range(stream.len());
+}
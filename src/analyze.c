@@ -5,7 +5,9 @@
 #include "include/ast_nodes.h"
 #include "include/errors.h"
 #include "include/extract.h"
+#include "include/line_index.h"
 #include "include/location.h"
+#include "include/macros.h"
 #include "include/parser.h"
 #include "include/position.h"
 #include "include/pretty_print.h"
@@ -13,6 +15,8 @@
 #include "include/token_struct.h"
 #include "include/util.h"
 #include "include/util/hb_array.h"
+#include "include/util/hb_memory.h"
+#include "include/util/hb_mutex.h"
 #include "include/util/hb_string.h"
 #include "include/visitor.h"
 
@@ -22,56 +26,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-static analyzed_ruby_T* herb_analyze_ruby(hb_string_T source) {
-  analyzed_ruby_T* analyzed = init_analyzed_ruby(source);
-
-  pm_visit_node(analyzed->root, search_if_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_block_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_case_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_case_match_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_while_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_for_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_until_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_begin_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_unless_nodes, analyzed);
-
-  search_elsif_nodes(analyzed);
-  search_else_nodes(analyzed);
-  search_end_nodes(analyzed);
-  search_when_nodes(analyzed);
-  search_in_nodes(analyzed);
-  search_rescue_nodes(analyzed);
-  search_ensure_nodes(analyzed);
-  search_yield_nodes(analyzed->root, analyzed);
-  search_block_closing_nodes(analyzed);
-
-  return analyzed;
-}
-
-static bool analyze_erb_content(const AST_NODE_T* node, void* data) {
-  if (node->type == AST_ERB_CONTENT_NODE) {
-    AST_ERB_CONTENT_NODE_T* erb_content_node = (AST_ERB_CONTENT_NODE_T*) node;
-
-    const char* opening = erb_content_node->tag_opening->value;
-
-    if (strcmp(opening, "<%%") != 0 && strcmp(opening, "<%%=") != 0 && strcmp(opening, "<%#") != 0) {
-      analyzed_ruby_T* analyzed = herb_analyze_ruby(hb_string(erb_content_node->content->value));
-
-      erb_content_node->parsed = true;
-      erb_content_node->valid = analyzed->valid;
-      erb_content_node->analyzed_ruby = analyzed;
-    } else {
-      erb_content_node->parsed = false;
-      erb_content_node->valid = true;
-      erb_content_node->analyzed_ruby = NULL;
-    }
-  }
-
-  herb_visit_child_nodes(node, analyze_erb_content, data);
-
-  return false;
-}
-
 static size_t process_block_children(
   AST_NODE_T* node,
   hb_array_T* array,
@@ -231,8 +185,6 @@ static control_type_t detect_control_type(AST_ERB_CONTENT_NODE_T* erb_node) {
 
   if (ruby->valid) { return CONTROL_TYPE_UNKNOWN; }
 
-  pm_node_t* root = ruby->root;
-
   if (has_elsif_node(ruby)) { return CONTROL_TYPE_ELSIF; }
   if (has_else_node(ruby)) { return CONTROL_TYPE_ELSE; }
   if (has_end(ruby)) { return CONTROL_TYPE_END; }
@@ -242,7 +194,201 @@ static control_type_t detect_control_type(AST_ERB_CONTENT_NODE_T* erb_node) {
   if (has_ensure_node(ruby)) { return CONTROL_TYPE_ENSURE; }
   if (has_block_closing(ruby)) { return CONTROL_TYPE_BLOCK_CLOSE; }
 
-  return find_earliest_control_keyword(root, ruby->parser.start);
+  return ruby->earliest_control_type;
+}
+
+// Process-wide cache, opt-in through herb_analyze_cache_configure(). Every thread shares it,
+// including batch workers and threads the bindings parse on. The lock is held to look up or
+// store an entry, never while Prism parses.
+static hb_mutex_T process_cache_lock = HB_MUTEX_INITIALIZER;
+static analyzed_ruby_cache_T process_cache;
+static bool process_cache_enabled = false;
+
+// Lookups made by the calling thread, see herb_analyze_cache_stats().
+static thread_local analyze_cache_stats_T cache_stats = { .hits = 0, .misses = 0 };
+
+#define ANALYZE_CANCEL_INTERVAL 32
+
+typedef struct {
+  analyzed_ruby_cache_T* cache;
+  bool shared;
+  AST_DOCUMENT_NODE_T* document;
+  herb_cancel_callback_T cancel;
+  void* cancel_data;
+  uint32_t nodes_until_cancel_check;
+} analyze_erb_content_context_T;
+
+// Copies the cached analysis of `source` into `analyzed`. Returns false if there is none.
+static bool analyze_cache_lookup(analyze_erb_content_context_T* context, hb_string_T source, analyzed_ruby_T* analyzed) {
+  if (context->shared) { hb_mutex_lock(&process_cache_lock); }
+
+  // herb_analyze_cache_configure(0) may have freed the shared cache since the parse started.
+  const analyzed_ruby_T* cached =
+    (!context->shared || process_cache_enabled) ? analyzed_ruby_cache_lookup(context->cache, source) : NULL;
+
+  if (cached != NULL) { *analyzed = *cached; }
+
+  if (context->shared) { hb_mutex_unlock(&process_cache_lock); }
+
+  if (cached != NULL) {
+    cache_stats.hits++;
+  } else {
+    cache_stats.misses++;
+  }
+
+  return cached != NULL;
+}
+
+static void analyze_cache_store(analyze_erb_content_context_T* context, hb_string_T source, const analyzed_ruby_T* analyzed) {
+  if (!context->shared) {
+    analyzed_ruby_cache_store(context->cache, source, analyzed);
+    return;
+  }
+
+  hb_mutex_lock(&process_cache_lock);
+  if (process_cache_enabled) { analyzed_ruby_cache_store(context->cache, source, analyzed); }
+  hb_mutex_unlock(&process_cache_lock);
+}
+
+/**
+ * Fills `analyzed` for `source` by parsing it with Prism, without the shortcut
+ * of classify_trivial_ruby() or any cache.
+ */
+void analyze_ruby_with_prism(hb_string_T source, analyzed_ruby_T* analyzed) {
+  pm_parser_t parser;
+  pm_parser_init(&parser, (const uint8_t*) source.data, source.length, NULL);
+
+  pm_node_t* root = pm_parse(&parser);
+  analyzed->valid = (parser.error_list.size == 0);
+
+  pm_visit_node(root, search_ruby_nodes, analyzed);
+  search_ruby_errors(analyzed, &parser);
+
+  if (!analyzed->valid) { analyzed->earliest_control_type = find_earliest_control_keyword(root, parser.start); }
+
+  pm_node_destroy(&parser, root);
+  pm_parser_free(&parser);
+}
+
+static analyzed_ruby_T* herb_analyze_ruby(hb_string_T source, analyze_erb_content_context_T* context) {
+  analyzed_ruby_T* analyzed = init_analyzed_ruby();
+  if (classify_trivial_ruby(source, analyzed)) { return analyzed; }
+
+  if (analyze_cache_lookup(context, source, analyzed)) { return analyzed; }
+
+  analyze_ruby_with_prism(source, analyzed);
+  analyze_cache_store(context, source, analyzed);
+
+  return analyzed;
+}
+
+// Asks the cancel callback every ANALYZE_CANCEL_INTERVAL ERB nodes, see `parser_options_T.cancel`.
+static bool analyze_erb_content_cancelled(analyze_erb_content_context_T* context) {
+  AST_DOCUMENT_NODE_T* document = context->document;
+  if (context->cancel == NULL || document->cancelled) { return document->cancelled; }
+
+  if (context->nodes_until_cancel_check > 0) {
+    context->nodes_until_cancel_check--;
+    return false;
+  }
+
+  context->nodes_until_cancel_check = ANALYZE_CANCEL_INTERVAL;
+  document->cancelled = context->cancel(context->cancel_data);
+
+  return document->cancelled;
+}
+
+static bool analyze_erb_content(const AST_NODE_T* node, void* data) {
+  analyze_erb_content_context_T* context = (analyze_erb_content_context_T*) data;
+
+  if (node->type == AST_ERB_CONTENT_NODE) {
+    if (analyze_erb_content_cancelled(context)) { return false; }
+
+    AST_ERB_CONTENT_NODE_T* erb_content_node = (AST_ERB_CONTENT_NODE_T*) node;
+
+    hb_string_T opening = erb_content_node->tag_opening->value;
+
+    if (!hb_string_equals(opening, hb_string("<%%")) && !hb_string_equals(opening, hb_string("<%%="))
+        && !hb_string_equals(opening, hb_string("<%#"))) {
+      analyzed_ruby_T* analyzed = herb_analyze_ruby(erb_content_node->content->value, context);
+
+      erb_content_node->parsed = true;
+      erb_content_node->valid = analyzed->valid;
+      erb_content_node->analyzed_ruby = analyzed;
+    } else {
+      erb_content_node->parsed = false;
+      erb_content_node->valid = true;
+      erb_content_node->analyzed_ruby = NULL;
+    }
+  }
+
+  if (context->document->cancelled) { return false; }
+
+  herb_visit_child_nodes(node, analyze_erb_content, data);
+
+  return false;
+}
+
+static void herb_analyze_erb_contents(AST_DOCUMENT_NODE_T* document, herb_cancel_callback_T cancel, void* cancel_data) {
+  analyze_erb_content_context_T context = {
+    .cache = NULL,
+    .shared = false,
+    .document = document,
+    .cancel = cancel,
+    .cancel_data = cancel_data,
+    .nodes_until_cancel_check = 0,
+  };
+
+  hb_mutex_lock(&process_cache_lock);
+  context.shared = process_cache_enabled;
+  hb_mutex_unlock(&process_cache_lock);
+
+  if (context.shared) {
+    context.cache = &process_cache;
+    herb_visit_node((AST_NODE_T*) document, analyze_erb_content, &context);
+
+    return;
+  }
+
+  analyzed_ruby_cache_T document_cache;
+  analyzed_ruby_cache_init(&document_cache, 0, false);
+
+  context.cache = &document_cache;
+  herb_visit_node((AST_NODE_T*) document, analyze_erb_content, &context);
+
+  analyzed_ruby_cache_free(&document_cache);
+}
+
+/**
+ * Enables a process-wide cache of analyzed ERB snippets holding up to
+ * `max_entries` snippets, shared by every document parsed afterwards on any
+ * thread. Passing 0 disables it again and frees its entries, leaving only the
+ * per-document cache. Safe to call while other threads are parsing.
+ */
+void herb_analyze_cache_configure(size_t max_entries) {
+  hb_mutex_lock(&process_cache_lock);
+
+  if (process_cache_enabled) { analyzed_ruby_cache_free(&process_cache); }
+
+  process_cache_enabled = max_entries > 0;
+
+  if (process_cache_enabled) { analyzed_ruby_cache_init(&process_cache, max_entries, true); }
+
+  hb_mutex_unlock(&process_cache_lock);
+}
+
+/**
+ * @return Hit/miss counts of the ERB snippet analysis cache for lookups made
+ *         on the calling thread since the last herb_analyze_cache_reset_stats(),
+ *         whether they went to the process-wide or a per-document cache.
+ */
+analyze_cache_stats_T herb_analyze_cache_stats(void) {
+  return cache_stats;
+}
+
+void herb_analyze_cache_reset_stats(void) {
+  cache_stats.hits = 0;
+  cache_stats.misses = 0;
 }
 
 static bool is_subsequent_type(control_type_t parent_type, control_type_t child_type) {
@@ -272,6 +418,15 @@ static bool is_terminator_type(control_type_t parent_type, control_type_t child_
   }
 }
 
+// Frees an ERB content node after the node that replaces it took over its tokens.
+static void erb_content_node_free_moved(AST_ERB_CONTENT_NODE_T* erb_node) {
+  erb_node->tag_opening = NULL;
+  erb_node->content = NULL;
+  erb_node->tag_closing = NULL;
+
+  ast_node_free((AST_NODE_T*) erb_node);
+}
+
 static AST_NODE_T* create_control_node(
   AST_ERB_CONTENT_NODE_T* erb_node,
   hb_array_T* children,
@@ -588,7 +743,7 @@ static size_t process_control_structure(
           when_errors
         );
 
-        ast_node_free((AST_NODE_T*) erb_content);
+        erb_content_node_free_moved(erb_content);
 
         hb_array_append(when_conditions, (AST_NODE_T*) when_node);
 
@@ -612,7 +767,7 @@ static size_t process_control_structure(
           in_errors
         );
 
-        ast_node_free((AST_NODE_T*) erb_content);
+        erb_content_node_free_moved(erb_content);
 
         hb_array_append(in_conditions, (AST_NODE_T*) in_node);
 
@@ -654,7 +809,7 @@ static size_t process_control_structure(
             else_errors
           );
 
-          ast_node_free((AST_NODE_T*) next_erb);
+          erb_content_node_free_moved(next_erb);
         }
       }
     }
@@ -680,7 +835,7 @@ static size_t process_control_structure(
             end_errors
           );
 
-          ast_node_free((AST_NODE_T*) end_erb);
+          erb_content_node_free_moved(end_erb);
 
           index++;
         }
@@ -719,7 +874,7 @@ static size_t process_control_structure(
         case_match_errors
       );
 
-      ast_node_free((AST_NODE_T*) erb_node);
+      erb_content_node_free_moved(erb_node);
 
       hb_array_append(output_array, (AST_NODE_T*) case_match_node);
       hb_array_free(&when_conditions);
@@ -744,7 +899,7 @@ static size_t process_control_structure(
       case_errors
     );
 
-    ast_node_free((AST_NODE_T*) erb_node);
+    erb_content_node_free_moved(erb_node);
 
     hb_array_append(output_array, (AST_NODE_T*) case_node);
     hb_array_free(&in_conditions);
@@ -802,7 +957,7 @@ static size_t process_control_structure(
             else_errors
           );
 
-          ast_node_free((AST_NODE_T*) next_erb);
+          erb_content_node_free_moved(next_erb);
         }
       }
     }
@@ -848,7 +1003,7 @@ static size_t process_control_structure(
             ensure_errors
           );
 
-          ast_node_free((AST_NODE_T*) next_erb);
+          erb_content_node_free_moved(next_erb);
         }
       }
     }
@@ -874,7 +1029,7 @@ static size_t process_control_structure(
             end_errors
           );
 
-          ast_node_free((AST_NODE_T*) end_erb);
+          erb_content_node_free_moved(end_erb);
 
           index++;
         }
@@ -911,7 +1066,7 @@ static size_t process_control_structure(
       begin_errors
     );
 
-    ast_node_free((AST_NODE_T*) erb_node);
+    erb_content_node_free_moved(erb_node);
 
     hb_array_append(output_array, (AST_NODE_T*) begin_node);
     return index;
@@ -942,7 +1097,7 @@ static size_t process_control_structure(
             end_errors
           );
 
-          ast_node_free((AST_NODE_T*) close_erb);
+          erb_content_node_free_moved(close_erb);
 
           index++;
         }
@@ -973,7 +1128,7 @@ static size_t process_control_structure(
       block_errors
     );
 
-    ast_node_free((AST_NODE_T*) erb_node);
+    erb_content_node_free_moved(erb_node);
 
     hb_array_append(output_array, (AST_NODE_T*) block_node);
     return index;
@@ -1016,7 +1171,7 @@ static size_t process_control_structure(
           end_errors
         );
 
-        ast_node_free((AST_NODE_T*) end_erb);
+        erb_content_node_free_moved(end_erb);
 
         index++;
       }
@@ -1026,7 +1181,7 @@ static size_t process_control_structure(
   AST_NODE_T* control_node = create_control_node(erb_node, children, subsequent, end_node, initial_type);
 
   if (control_node) {
-    ast_node_free((AST_NODE_T*) erb_node);
+    erb_content_node_free_moved(erb_node);
     hb_array_append(output_array, control_node);
   } else {
     hb_array_free(&children);
@@ -1054,7 +1209,7 @@ static size_t process_subsequent_block(
   AST_NODE_T* subsequent_node = create_control_node(erb_node, children, NULL, NULL, type);
 
   if (subsequent_node) {
-    ast_node_free((AST_NODE_T*) erb_node);
+    erb_content_node_free_moved(erb_node);
   } else {
     hb_array_free(&children);
   }
@@ -1189,7 +1344,7 @@ hb_array_T* rewrite_node_array(AST_NODE_T* node, hb_array_T* array, analyze_ruby
         AST_NODE_T* yield_node = create_control_node(erb_node, NULL, NULL, NULL, type);
 
         if (yield_node) {
-          ast_node_free((AST_NODE_T*) erb_node);
+          erb_content_node_free_moved(erb_node);
           hb_array_append(new_array, yield_node);
         } else {
           hb_array_append(new_array, item);
@@ -1231,7 +1386,7 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
       analyzed_ruby_T* analyzed = content_node->analyzed_ruby;
 
       // =begin
-      if (has_error_message(analyzed, "embedded document meets end of file")) {
+      if (analyzed->has_unterminated_embedded_document) {
         if (is_loop_node) { context->loop_depth--; }
         if (is_begin_node) { context->rescue_depth--; }
 
@@ -1239,8 +1394,7 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
       }
 
       // =end
-      if (has_error_message(analyzed, "unexpected '=', ignoring it")
-          && has_error_message(analyzed, "unexpected 'end', ignoring it")) {
+      if (analyzed->has_embedded_document_end) {
         if (is_loop_node) { context->loop_depth--; }
         if (is_begin_node) { context->rescue_depth--; }
 
@@ -1250,17 +1404,15 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
       const char* keyword = NULL;
 
       if (context->loop_depth == 0) {
-        if (has_error_message(analyzed, "Invalid break")) {
+        if (analyzed->has_invalid_break) {
           keyword = "`<% break %>`";
-        } else if (has_error_message(analyzed, "Invalid next")) {
+        } else if (analyzed->has_invalid_next) {
           keyword = "`<% next %>`";
-        } else if (has_error_message(analyzed, "Invalid redo")) {
+        } else if (analyzed->has_invalid_redo) {
           keyword = "`<% redo %>`";
         }
       } else {
-        if (has_error_message(analyzed, "Invalid redo") || has_error_message(analyzed, "Invalid break")
-            || has_error_message(analyzed, "Invalid next")) {
-
+        if (analyzed->has_invalid_redo || analyzed->has_invalid_break || analyzed->has_invalid_next) {
           if (is_loop_node) { context->loop_depth--; }
           if (is_begin_node) { context->rescue_depth--; }
 
@@ -1269,9 +1421,9 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
       }
 
       if (context->rescue_depth == 0) {
-        if (has_error_message(analyzed, "Invalid retry without rescue")) { keyword = "`<% retry %>`"; }
+        if (analyzed->has_invalid_retry) { keyword = "`<% retry %>`"; }
       } else {
-        if (has_error_message(analyzed, "Invalid retry without rescue")) {
+        if (analyzed->has_invalid_retry) {
           if (is_loop_node) { context->loop_depth--; }
           if (is_begin_node) { context->rescue_depth--; }
 
@@ -1282,7 +1434,12 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
       if (keyword == NULL) { keyword = erb_keyword_from_analyzed_ruby(analyzed); }
 
       if (keyword != NULL && !token_value_empty(content_node->tag_closing)) {
-        append_erb_control_flow_scope_error(keyword, node->location.start, node->location.end, node->errors);
+        append_erb_control_flow_scope_error(
+          keyword,
+          node->location.start,
+          node->location.end,
+          &((AST_NODE_T*) node)->errors
+        );
       }
     }
   }
@@ -1290,7 +1447,7 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
   if (node->type == AST_ERB_IF_NODE) {
     const AST_ERB_IF_NODE_T* if_node = (const AST_ERB_IF_NODE_T*) node;
 
-    if (if_node->end_node == NULL) { check_erb_node_for_missing_end(node); }
+    if (if_node->end_node == NULL) { check_erb_node_for_missing_end((AST_NODE_T*) node); }
 
     if (if_node->statements != NULL) {
       for (size_t i = 0; i < hb_array_size(if_node->statements); i++) {
@@ -1315,7 +1472,7 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
               keyword,
               subsequent->location.start,
               subsequent->location.end,
-              subsequent->errors
+              &subsequent->errors
             );
           }
         }
@@ -1360,7 +1517,7 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
   if (node->type == AST_ERB_UNLESS_NODE || node->type == AST_ERB_WHILE_NODE || node->type == AST_ERB_UNTIL_NODE
       || node->type == AST_ERB_FOR_NODE || node->type == AST_ERB_CASE_NODE || node->type == AST_ERB_CASE_MATCH_NODE
       || node->type == AST_ERB_BEGIN_NODE || node->type == AST_ERB_BLOCK_NODE || node->type == AST_ERB_ELSE_NODE) {
-    check_erb_node_for_missing_end(node);
+    check_erb_node_for_missing_end((AST_NODE_T*) node);
 
     if (is_loop_node) { context->loop_depth--; }
     if (is_begin_node) { context->rescue_depth--; }
@@ -1384,43 +1541,78 @@ static bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data) {
 }
 
 void herb_analyze_parse_tree(AST_DOCUMENT_NODE_T* document, const char* source) {
-  herb_visit_node((AST_NODE_T*) document, analyze_erb_content, NULL);
+  herb_analyze_parse_tree_n(document, source, strlen(source));
+}
+
+/**
+ * Like herb_analyze_parse_tree(), for a document parsed with herb_parse_n() from
+ * the first `length` bytes of `source`.
+ */
+void herb_analyze_parse_tree_n(AST_DOCUMENT_NODE_T* document, const char* source, size_t length) {
+  herb_analyze_parse_tree_cancellable_n(document, source, length, NULL, NULL);
+}
+
+/**
+ * Like herb_analyze_parse_tree_n(), but polls `cancel` between ERB nodes the way the
+ * lexer does, see `parser_options_T.cancel`. Once it returns true the document is
+ * marked `cancelled` and keeps its parse tree as is.
+ */
+void herb_analyze_parse_tree_cancellable_n(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t length,
+  herb_cancel_callback_T cancel,
+  void* cancel_data
+) {
+  // The later passes expect every ERB node to be analyzed, a cancelled document keeps its parse tree as is.
+  if (document->cancelled) { return; }
+
+  hb_arena_T* previous_arena = hb_memory_use_arena(document->arena);
+
+  herb_analyze_erb_contents(document, cancel, cancel_data);
+
+  if (document->cancelled) {
+    hb_memory_use_arena(previous_arena);
+    return;
+  }
 
-  analyze_ruby_context_T* context = malloc(sizeof(analyze_ruby_context_T));
+  analyze_ruby_context_T* context = hb_memory_allocate(sizeof(analyze_ruby_context_T));
   context->document = document;
   context->parent = NULL;
   context->ruby_context_stack = hb_array_init(8);
 
   herb_visit_node((AST_NODE_T*) document, transform_erb_nodes, context);
 
-  invalid_erb_context_T* invalid_context = malloc(sizeof(invalid_erb_context_T));
+  invalid_erb_context_T* invalid_context = hb_memory_allocate(sizeof(invalid_erb_context_T));
   invalid_context->loop_depth = 0;
   invalid_context->rescue_depth = 0;
 
   herb_visit_node((AST_NODE_T*) document, detect_invalid_erb_structures, invalid_context);
 
-  herb_analyze_parse_errors(document, source);
+  herb_analyze_parse_errors_n(document, source, length);
 
   herb_parser_match_html_tags_post_analyze(document);
 
   hb_array_free(&context->ruby_context_stack);
 
-  free(context);
-  free(invalid_context);
+  hb_memory_free(context);
+  hb_memory_free(invalid_context);
+
+  hb_memory_use_arena(previous_arena);
 }
 
 static void parse_erb_content_errors(AST_NODE_T* erb_node, const char* source) {
   if (!erb_node || erb_node->type != AST_ERB_CONTENT_NODE) { return; }
   AST_ERB_CONTENT_NODE_T* content_node = (AST_ERB_CONTENT_NODE_T*) erb_node;
 
-  if (!content_node->content || !content_node->content->value) { return; }
+  if (!content_node->content) { return; }
 
-  const char* content = content_node->content->value;
-  if (strlen(content) == 0) { return; }
+  hb_string_T content = content_node->content->value;
+  if (hb_string_is_empty(content)) { return; }
 
   pm_parser_t parser;
   pm_options_t options = { 0, .partial_script = true };
-  pm_parser_init(&parser, (const uint8_t*) content, strlen(content), &options);
+  pm_parser_init(&parser, (const uint8_t*) content.data, content.length, &options);
 
   pm_node_t* root = pm_parse(&parser);
 
@@ -1430,7 +1622,7 @@ static void parse_erb_content_errors(AST_NODE_T* erb_node, const char* source) {
     RUBY_PARSE_ERROR_T* parse_error =
       ruby_parse_error_from_prism_error_with_positions(error, erb_node->location.start, erb_node->location.end);
 
-    hb_array_append(erb_node->errors, parse_error);
+    ast_node_append_error(erb_node, (ERROR_T*) parse_error);
   }
 
   pm_node_destroy(&parser, root);
@@ -1439,24 +1631,53 @@ static void parse_erb_content_errors(AST_NODE_T* erb_node, const char* source) {
 }
 
 void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source) {
-  char* extracted_ruby = herb_extract_ruby_with_semicolons(source);
+  herb_analyze_parse_errors_n(document, source, strlen(source));
+}
+
+void herb_analyze_parse_errors_n(AST_DOCUMENT_NODE_T* document, const char* source, size_t source_length) {
+  if (document->cancelled) { return; }
+
+  hb_arena_T* previous_arena = hb_memory_use_arena(document->arena);
 
-  if (!extracted_ruby) { return; }
+  // herb_parse() already built the Ruby projection, only documents created otherwise need to be lexed again.
+  // The document keeps it, so herb_reparse_n() can splice the projection of an edited range into it.
+  if (!document->extracted_ruby) {
+    document->extracted_ruby = herb_extract_n(source, source_length, HERB_EXTRACT_LANGUAGE_RUBY);
+  }
+
+  char* extracted_ruby = document->extracted_ruby;
+
+  if (!extracted_ruby) {
+    hb_memory_use_arena(previous_arena);
+    return;
+  }
+
+  // The projection keeps every byte offset of the source, NUL bytes included, see herb_extract_n().
+  size_t extracted_length = source_length;
 
   pm_parser_t parser;
   pm_options_t options = { 0, .partial_script = true };
-  pm_parser_init(&parser, (const uint8_t*) extracted_ruby, strlen(extracted_ruby), &options);
+  pm_parser_init(&parser, (const uint8_t*) extracted_ruby, extracted_length, &options);
 
   pm_node_t* root = pm_parse(&parser);
 
+  erb_content_index_T erb_content_index;
+  bool has_erb_content_index = false;
+  line_index_T* line_index = NULL;
+
   for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) parser.error_list.head; error != NULL;
        error = (const pm_diagnostic_t*) error->node.next) {
     size_t error_offset = (size_t) (error->location.start - parser.start);
 
     if (strstr(error->message, "unexpected ';'") != NULL) {
-      if (error_offset < strlen(extracted_ruby) && extracted_ruby[error_offset] == ';') {
-        if (error_offset >= strlen(source) || source[error_offset] != ';') {
-          AST_NODE_T* erb_node = find_erb_content_at_offset(document, source, error_offset);
+      if (error_offset < extracted_length && extracted_ruby[error_offset] == ';') {
+        if (error_offset >= source_length || source[error_offset] != ';') {
+          if (!has_erb_content_index) {
+            erb_content_index_init(&erb_content_index, document);
+            has_erb_content_index = true;
+          }
+
+          AST_NODE_T* erb_node = erb_content_index_find(&erb_content_index, error_offset);
 
           if (erb_node) { parse_erb_content_errors(erb_node, source); }
 
@@ -1465,12 +1686,19 @@ void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source
       }
     }
 
-    RUBY_PARSE_ERROR_T* parse_error = ruby_parse_error_from_prism_error(error, (AST_NODE_T*) document, source, &parser);
-    hb_array_append(document->base.errors, parse_error);
+    if (line_index == NULL) { line_index = line_index_init(source, source_length); }
+
+    RUBY_PARSE_ERROR_T* parse_error =
+      ruby_parse_error_from_prism_error(error, (AST_NODE_T*) document, line_index, &parser);
+    ast_node_append_error(&document->base, (ERROR_T*) parse_error);
   }
 
+  if (has_erb_content_index) { erb_content_index_free(&erb_content_index); }
+  line_index_free(&line_index);
+
   pm_node_destroy(&parser, root);
   pm_parser_free(&parser);
   pm_options_free(&options);
-  free(extracted_ruby);
+
+  hb_memory_use_arena(previous_arena);
 }
@@ -76,242 +76,234 @@ bool has_yield_node(analyzed_ruby_T* analyzed) {
   return analyzed->has_yield_node;
 }
 
-bool has_error_message(analyzed_ruby_T* anlayzed, const char* message) {
-  for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) anlayzed->parser.error_list.head; error != NULL;
-       error = (const pm_diagnostic_t*) error->node.next) {
-    if (strcmp(error->message, message) == 0) { return true; }
-  }
-
-  return false;
+static bool has_location(pm_location_t location) {
+  return location.start != NULL && location.end != NULL;
 }
 
-bool search_if_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_IF_NODE) {
-    const pm_if_node_t* if_node = (const pm_if_node_t*) node;
+static bool is_block_with_do_or_brace(const pm_block_node_t* block_node) {
+  size_t opening_length = block_node->opening_loc.end - block_node->opening_loc.start;
 
-    bool has_if_keyword = if_node->if_keyword_loc.start != NULL && if_node->if_keyword_loc.end != NULL;
-    bool has_end_keyword = if_node->end_keyword_loc.start != NULL && if_node->end_keyword_loc.end != NULL;
+  return (opening_length == 2 && block_node->opening_loc.start[0] == 'd' && block_node->opening_loc.start[1] == 'o')
+      || (opening_length == 1 && block_node->opening_loc.start[0] == '{');
+}
 
-    if (has_if_keyword && has_end_keyword) {
-      analyzed->has_if_node = true;
+/**
+ * Prism visitor that sets every node based `has_*` flag of `analyzed_ruby_T`
+ * in a single traversal of the tree.
+ */
+bool search_ruby_nodes(const pm_node_t* node, void* data) {
+  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
 
-      return true;
-    }
+  switch (node->type) {
+    case PM_IF_NODE: {
+      const pm_if_node_t* if_node = (const pm_if_node_t*) node;
+
+      if (has_location(if_node->if_keyword_loc) && has_location(if_node->end_keyword_loc)) {
+        analyzed->has_if_node = true;
+      }
+    } break;
+
+    case PM_UNLESS_NODE: {
+      const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
+
+      if (has_location(unless_node->keyword_loc) && has_location(unless_node->end_keyword_loc)) {
+        analyzed->has_unless_node = true;
+      }
+    } break;
+
+    case PM_BLOCK_NODE: {
+      if (is_block_with_do_or_brace((const pm_block_node_t*) node)) { analyzed->has_block_node = true; }
+    } break;
+
+    case PM_CASE_NODE: analyzed->has_case_node = true; break;
+    case PM_CASE_MATCH_NODE: analyzed->has_case_match_node = true; break;
+    case PM_WHILE_NODE: analyzed->has_while_node = true; break;
+    case PM_FOR_NODE: analyzed->has_for_node = true; break;
+    case PM_UNTIL_NODE: analyzed->has_until_node = true; break;
+    case PM_BEGIN_NODE: analyzed->has_begin_node = true; break;
+    case PM_YIELD_NODE: analyzed->has_yield_node = true; break;
+    default: break;
   }
 
-  pm_visit_child_nodes(node, search_if_nodes, analyzed);
-
-  return false;
+  return true;
 }
 
-bool search_block_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_BLOCK_NODE) {
-    pm_block_node_t* block_node = (pm_block_node_t*) node;
+/**
+ * Sets the `has_*` flags for keywords that only show up as Prism errors when the
+ * snippet is parsed on its own (`<% else %>`, `<% end %>`, ...), and the
+ * `has_invalid_*` / embedded document flags, in a single pass over the error list.
+ */
+void search_ruby_errors(analyzed_ruby_T* analyzed, const pm_parser_t* parser) {
+  bool has_unexpected_end = false;
+  bool has_unexpected_equals = false;
 
-    size_t opening_length = block_node->opening_loc.end - block_node->opening_loc.start;
-
-    if ((opening_length == 2 && block_node->opening_loc.start[0] == 'd' && block_node->opening_loc.start[1] == 'o')
-        || (opening_length == 1 && block_node->opening_loc.start[0] == '{')) {
-      analyzed->has_block_node = true;
+  for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) parser->error_list.head; error != NULL;
+       error = (const pm_diagnostic_t*) error->node.next) {
+    const char* message = error->message;
+
+    if (strncmp(message, "unexpected '", 12) != 0) {
+      if (strcmp(message, "embedded document meets end of file") == 0) {
+        analyzed->has_unterminated_embedded_document = true;
+      } else if (strcmp(message, "Invalid break") == 0) {
+        analyzed->has_invalid_break = true;
+      } else if (strcmp(message, "Invalid next") == 0) {
+        analyzed->has_invalid_next = true;
+      } else if (strcmp(message, "Invalid redo") == 0) {
+        analyzed->has_invalid_redo = true;
+      } else if (strcmp(message, "Invalid retry without rescue") == 0) {
+        analyzed->has_invalid_retry = true;
+      }
+
+      continue;
+    }
 
-      return true;
+    if (strcmp(message, "unexpected 'elsif', ignoring it") == 0) {
+      analyzed->has_elsif_node = true;
+    } else if (strcmp(message, "unexpected 'else', ignoring it") == 0) {
+      analyzed->has_else_node = true;
+    } else if (strcmp(message, "unexpected 'end', ignoring it") == 0) {
+      has_unexpected_end = true;
+    } else if (strcmp(message, "unexpected '=', ignoring it") == 0) {
+      has_unexpected_equals = true;
+    } else if (strcmp(message, "unexpected '}', ignoring it") == 0) {
+      analyzed->has_block_closing = true;
+    } else if (strcmp(message, "unexpected 'when', ignoring it") == 0) {
+      analyzed->has_when_node = true;
+    } else if (strcmp(message, "unexpected 'in', ignoring it") == 0) {
+      analyzed->has_in_node = true;
+    } else if (strcmp(message, "unexpected 'rescue', ignoring it") == 0) {
+      analyzed->has_rescue_node = true;
+    } else if (strcmp(message, "unexpected 'ensure', ignoring it") == 0) {
+      analyzed->has_ensure_node = true;
     }
   }
 
-  pm_visit_child_nodes(node, search_block_nodes, analyzed);
-
-  return false;
+  // `=end`
+  analyzed->has_embedded_document_end = has_unexpected_end && has_unexpected_equals;
+  analyzed->has_end = has_unexpected_end && !has_unexpected_equals;
 }
 
-bool search_case_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_CASE_NODE) {
-    analyzed->has_case_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_case_nodes, analyzed);
-  }
-
-  return false;
+static bool is_ruby_whitespace(char character) {
+  return character == ' ' || character == '\t' || character == '\n' || character == '\r';
 }
 
-bool search_case_match_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_CASE_MATCH_NODE) {
-    analyzed->has_case_match_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_case_match_nodes, analyzed);
-  }
-
-  return false;
+static bool is_ruby_word_character(char character) {
+  return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z')
+      || (character >= '0' && character <= '9') || character == '_' || (unsigned char) character >= 0x80;
 }
 
-bool search_while_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_WHILE_NODE) {
-    analyzed->has_while_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_while_nodes, analyzed);
+static hb_string_T trim_ruby_whitespace(hb_string_T source) {
+  while (source.length > 0 && is_ruby_whitespace(source.data[0])) {
+    source.data++;
+    source.length--;
   }
 
-  return false;
-}
-
-bool search_for_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_FOR_NODE) {
-    analyzed->has_for_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_for_nodes, analyzed);
+  while (source.length > 0 && is_ruby_whitespace(source.data[source.length - 1])) {
+    source.length--;
   }
 
-  return false;
+  return source;
 }
 
-bool search_until_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
+static bool is_ruby_keyword(hb_string_T word) {
+  static const char* keywords[] = { "BEGIN",  "END",   "__END__", "alias",  "begin",  "break",  "case",
+                                    "class",  "def",   "defined", "do",     "else",   "elsif",  "end",
+                                    "ensure", "for",   "if",      "in",     "module", "next",   "redo",
+                                    "rescue", "retry", "return",  "then",   "undef",  "unless", "until",
+                                    "when",   "while", "yield" };
 
-  if (node->type == PM_UNTIL_NODE) {
-    analyzed->has_until_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_until_nodes, analyzed);
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (hb_string_equals(word, hb_string(keywords[i]))) { return true; }
   }
 
   return false;
 }
 
-bool search_begin_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_BEGIN_NODE) {
-    analyzed->has_begin_node = true;
-    return true;
-  } else {
-    pm_visit_child_nodes(node, search_begin_nodes, analyzed);
-  }
-
-  return false;
-}
+/**
+ * Whether `expression` is plain enough that parsing it can't set any field of
+ * `analyzed_ruby_T`: no keywords, no blocks, braces or block arguments (which
+ * Prism reports as a call with a block), no statement separators and no
+ * comments or interpolation that could hide either.
+ */
+static bool is_plain_ruby_expression(hb_string_T expression) {
+  uint32_t index = 0;
 
-bool search_unless_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
+  while (index < expression.length) {
+    char character = expression.data[index];
 
-  if (node->type == PM_UNLESS_NODE) {
-    const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
+    if (is_ruby_word_character(character)) {
+      uint32_t start = index;
 
-    bool has_if_keyword = unless_node->keyword_loc.start != NULL && unless_node->keyword_loc.end != NULL;
-    bool has_end_keyword = unless_node->end_keyword_loc.start != NULL && unless_node->end_keyword_loc.end != NULL;
+      while (index < expression.length && is_ruby_word_character(expression.data[index])) {
+        index++;
+      }
 
-    if (has_if_keyword && has_end_keyword) {
-      analyzed->has_unless_node = true;
+      if (is_ruby_keyword(hb_string_range(expression, start, index))) { return false; }
 
-      return true;
+      continue;
     }
-  }
-
-  pm_visit_child_nodes(node, search_unless_nodes, analyzed);
 
-  return false;
-}
-
-bool search_elsif_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'elsif', ignoring it")) {
-    analyzed->has_elsif_node = true;
-    return true;
+    switch (character) {
+      case '&': {
+        // `&&` and `&.` are fine, a lone `&` may pass a block.
+        char next = index + 1 < expression.length ? expression.data[index + 1] : '\0';
+        if (next != '&' && next != '.') { return false; }
+
+        index += 2;
+      } break;
+
+      case '{':
+      case '}':
+      case ';':
+      case '#':
+      case '\\':
+      case '`': return false;
+      default: index++;
+    }
   }
 
-  return false;
+  return true;
 }
 
-bool search_else_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'else', ignoring it")) {
-    analyzed->has_else_node = true;
-    return true;
-  }
+static bool starts_with_keyword_clause(hb_string_T source, const char* keyword) {
+  hb_string_T prefix = hb_string(keyword);
 
-  return false;
+  return source.length > prefix.length && hb_string_starts_with(source, prefix)
+      && is_ruby_whitespace(source.data[prefix.length]);
 }
 
-bool search_end_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'end', ignoring it")) {
-    if (has_error_message(analyzed, "unexpected '=', ignoring it")) {
-      // `=end`
-      return false;
-    }
+/**
+ * Classifies the ERB snippets that make up most control flow tags without
+ * running Prism: a lone `end`, `else`, `ensure` or `}`, and `elsif`/`when`
+ * clauses followed by a plain expression. Prism reports the same keywords as
+ * "unexpected ..., ignoring it" errors, so the flags match what
+ * search_ruby_errors() would set.
+ *
+ * @return false if the snippet is anything else and needs a full Prism parse
+ */
+bool classify_trivial_ruby(hb_string_T source, analyzed_ruby_T* analyzed) {
+  hb_string_T content = trim_ruby_whitespace(source);
 
+  if (hb_string_equals(content, hb_string("end"))) {
     analyzed->has_end = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_block_closing_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected '}', ignoring it")) {
+  } else if (hb_string_equals(content, hb_string("else"))) {
+    analyzed->has_else_node = true;
+  } else if (hb_string_equals(content, hb_string("ensure"))) {
+    analyzed->has_ensure_node = true;
+  } else if (hb_string_equals(content, hb_string("}"))) {
     analyzed->has_block_closing = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_when_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'when', ignoring it")) {
+  } else if (starts_with_keyword_clause(content, "elsif")
+             && is_plain_ruby_expression(hb_string_slice(content, strlen("elsif")))) {
+    analyzed->has_elsif_node = true;
+  } else if (starts_with_keyword_clause(content, "when")
+             && is_plain_ruby_expression(hb_string_slice(content, strlen("when")))) {
     analyzed->has_when_node = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_in_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'in', ignoring it")) {
-    analyzed->has_in_node = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_rescue_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'rescue', ignoring it")) {
-    analyzed->has_rescue_node = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_ensure_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'ensure', ignoring it")) {
-    analyzed->has_ensure_node = true;
-    return true;
-  }
-
-  return false;
-}
-
-bool search_yield_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_YIELD_NODE) {
-    analyzed->has_yield_node = true;
-    return true;
   } else {
-    pm_visit_child_nodes(node, search_yield_nodes, analyzed);
+    return false;
   }
 
-  return false;
+  analyzed->valid = false;
+  analyzed->earliest_control_type = CONTROL_TYPE_UNKNOWN;
+
+  return true;
 }
@@ -1,35 +1,17 @@
 #include "include/analyzed_ruby.h"
+#include "include/util/hb_memory.h"
 #include "include/util/hb_string.h"
 
-#include <prism.h>
+#include <stdlib.h>
 #include <string.h>
 
-analyzed_ruby_T* init_analyzed_ruby(hb_string_T source) {
-  analyzed_ruby_T* analyzed = malloc(sizeof(analyzed_ruby_T));
-
-  pm_parser_init(&analyzed->parser, (const uint8_t*) source.data, source.length, NULL);
-
-  analyzed->root = pm_parse(&analyzed->parser);
-  analyzed->valid = (analyzed->parser.error_list.size == 0);
-  analyzed->parsed = true;
-  analyzed->has_if_node = false;
-  analyzed->has_elsif_node = false;
-  analyzed->has_else_node = false;
-  analyzed->has_end = false;
-  analyzed->has_block_node = false;
-  analyzed->has_block_closing = false;
-  analyzed->has_case_node = false;
-  analyzed->has_case_match_node = false;
-  analyzed->has_when_node = false;
-  analyzed->has_in_node = false;
-  analyzed->has_for_node = false;
-  analyzed->has_while_node = false;
-  analyzed->has_until_node = false;
-  analyzed->has_begin_node = false;
-  analyzed->has_rescue_node = false;
-  analyzed->has_ensure_node = false;
-  analyzed->has_unless_node = false;
-  analyzed->has_yield_node = false;
+#define ANALYZED_RUBY_CACHE_INITIAL_CAPACITY 64
+
+analyzed_ruby_T* init_analyzed_ruby(void) {
+  analyzed_ruby_T* analyzed = hb_memory_allocate_zeroed(1, sizeof(analyzed_ruby_T));
+
+  analyzed->valid = true;
+  analyzed->earliest_control_type = CONTROL_TYPE_UNKNOWN;
 
   return analyzed;
 }
@@ -37,11 +19,7 @@ analyzed_ruby_T* init_analyzed_ruby(hb_string_T source) {
 void free_analyzed_ruby(analyzed_ruby_T* analyzed) {
   if (!analyzed) { return; }
 
-  if (analyzed->parsed && analyzed->root != NULL) { pm_node_destroy(&analyzed->parser, analyzed->root); }
-
-  pm_parser_free(&analyzed->parser);
-
-  free(analyzed);
+  hb_memory_free(analyzed);
 }
 
 const char* erb_keyword_from_analyzed_ruby(const analyzed_ruby_T* analyzed) {
@@ -63,3 +41,122 @@ const char* erb_keyword_from_analyzed_ruby(const analyzed_ruby_T* analyzed) {
 
   return NULL;
 }
+
+static uint32_t analyzed_ruby_cache_hash(hb_string_T source) {
+  uint32_t hash = 2166136261u;
+
+  for (uint32_t i = 0; i < source.length; i++) {
+    hash ^= (unsigned char) source.data[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static analyzed_ruby_cache_entry_T* analyzed_ruby_cache_find_slot(
+  analyzed_ruby_cache_entry_T* entries,
+  size_t capacity,
+  hb_string_T source,
+  uint32_t hash
+) {
+  size_t slot = hash & (capacity - 1);
+
+  while (entries[slot].occupied
+         && (entries[slot].hash != hash || !hb_string_equals(entries[slot].source, source))) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+
+  return &entries[slot];
+}
+
+// A cache can outlive the document arena of any parse that fills it, so its memory always comes from the heap.
+static void analyzed_ruby_cache_grow(analyzed_ruby_cache_T* cache) {
+  size_t capacity = cache->capacity == 0 ? ANALYZED_RUBY_CACHE_INITIAL_CAPACITY : cache->capacity * 2;
+  analyzed_ruby_cache_entry_T* entries = calloc(capacity, sizeof(analyzed_ruby_cache_entry_T));
+
+  for (size_t i = 0; i < cache->capacity; i++) {
+    analyzed_ruby_cache_entry_T* entry = &cache->entries[i];
+    if (!entry->occupied) { continue; }
+
+    *analyzed_ruby_cache_find_slot(entries, capacity, entry->source, entry->hash) = *entry;
+  }
+
+  free(cache->entries);
+
+  cache->entries = entries;
+  cache->capacity = capacity;
+}
+
+void analyzed_ruby_cache_init(analyzed_ruby_cache_T* cache, size_t max_entries, bool owns_keys) {
+  cache->entries = NULL;
+  cache->capacity = 0;
+  cache->size = 0;
+  cache->max_entries = max_entries;
+  cache->owns_keys = owns_keys;
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+const analyzed_ruby_T* analyzed_ruby_cache_lookup(analyzed_ruby_cache_T* cache, hb_string_T source) {
+  if (cache->size > 0) {
+    analyzed_ruby_cache_entry_T* entry =
+      analyzed_ruby_cache_find_slot(cache->entries, cache->capacity, source, analyzed_ruby_cache_hash(source));
+
+    if (entry->occupied) {
+      cache->hits++;
+      return &entry->analyzed;
+    }
+  }
+
+  cache->misses++;
+
+  return NULL;
+}
+
+void analyzed_ruby_cache_store(analyzed_ruby_cache_T* cache, hb_string_T source, const analyzed_ruby_T* analyzed) {
+  if (cache->max_entries > 0 && cache->size >= cache->max_entries) { analyzed_ruby_cache_clear(cache); }
+
+  if ((cache->size + 1) * 4 > cache->capacity * 3) { analyzed_ruby_cache_grow(cache); }
+
+  uint32_t hash = analyzed_ruby_cache_hash(source);
+  analyzed_ruby_cache_entry_T* entry = analyzed_ruby_cache_find_slot(cache->entries, cache->capacity, source, hash);
+
+  if (entry->occupied) {
+    entry->analyzed = *analyzed;
+    return;
+  }
+
+  if (cache->owns_keys) {
+    char* data = calloc(source.length + 1, sizeof(char));
+    if (source.length > 0) { memcpy(data, source.data, source.length); }
+
+    source.data = data;
+  }
+
+  entry->source = source;
+  entry->hash = hash;
+  entry->occupied = true;
+  entry->analyzed = *analyzed;
+
+  cache->size++;
+}
+
+void analyzed_ruby_cache_clear(analyzed_ruby_cache_T* cache) {
+  if (cache->owns_keys) {
+    for (size_t i = 0; i < cache->capacity; i++) {
+      if (cache->entries[i].occupied) { free(cache->entries[i].source.data); }
+    }
+  }
+
+  if (cache->entries != NULL) { memset(cache->entries, 0, cache->capacity * sizeof(analyzed_ruby_cache_entry_T)); }
+
+  cache->size = 0;
+}
+
+void analyzed_ruby_cache_free(analyzed_ruby_cache_T* cache) {
+  analyzed_ruby_cache_clear(cache);
+  free(cache->entries);
+
+  cache->entries = NULL;
+  cache->capacity = 0;
+}
@@ -4,6 +4,7 @@
 #include "include/position.h"
 #include "include/token.h"
 #include "include/util.h"
+#include "include/util/hb_memory.h"
 #include "include/visitor.h"
 
 #include <prism.h>
@@ -21,19 +22,15 @@ void ast_node_init(AST_NODE_T* node, const ast_node_type_T type, position_T star
   node->location.start = start;
   node->location.end = end;
 
-  if (errors == NULL) {
-    node->errors = hb_array_init(8);
-  } else {
-    node->errors = errors;
-  }
+  node->errors = errors;
 }
 
 AST_LITERAL_NODE_T* ast_literal_node_init_from_token(const token_T* token) {
-  AST_LITERAL_NODE_T* literal = malloc(sizeof(AST_LITERAL_NODE_T));
+  AST_LITERAL_NODE_T* literal = hb_memory_allocate(sizeof(AST_LITERAL_NODE_T));
 
   ast_node_init(&literal->base, AST_LITERAL_NODE, token->location.start, token->location.end, NULL);
 
-  literal->content = herb_strdup(token->value);
+  literal->content = hb_string_to_c_string_using_hb_memory(token->value);
 
   return literal;
 }
@@ -50,8 +47,8 @@ hb_array_T* ast_node_errors(const AST_NODE_T* node) {
   return node->errors;
 }
 
-void ast_node_append_error(const AST_NODE_T* node, ERROR_T* error) {
-  hb_array_append(node->errors, error);
+void ast_node_append_error(AST_NODE_T* node, ERROR_T* error) {
+  error_append(&node->errors, error);
 }
 
 void ast_node_set_start(AST_NODE_T* node, position_T position) {
@@ -79,29 +76,89 @@ bool ast_node_is(const AST_NODE_T* node, const ast_node_type_T type) {
   return node->type == type;
 }
 
-typedef struct {
-  position_T position;
-  AST_NODE_T* found_node;
-} find_erb_at_position_context_T;
+static bool collect_erb_content_ranges(const AST_NODE_T* node, void* data) {
+  erb_content_index_T* index = (erb_content_index_T*) data;
 
-static bool find_erb_at_position_visitor(const AST_NODE_T* node, void* data) {
-  find_erb_at_position_context_T* context = (find_erb_at_position_context_T*) data;
+  if (node->type != AST_ERB_CONTENT_NODE) { return true; }
 
-  if (node->type == AST_ERB_CONTENT_NODE) {
-    if (position_is_within_range(context->position, node->location.start, node->location.end)) {
-      context->found_node = (AST_NODE_T*) node;
-      return false;
-    }
+  const AST_ERB_CONTENT_NODE_T* erb_node = (const AST_ERB_CONTENT_NODE_T*) node;
+  if (erb_node->tag_opening == NULL || erb_node->tag_closing == NULL) { return false; }
+
+  if (index->size == index->capacity) {
+    size_t capacity = index->capacity == 0 ? 16 : index->capacity * 2;
+
+    index->ranges = hb_memory_reallocate(
+      index->ranges,
+      index->capacity * sizeof(erb_content_range_T),
+      capacity * sizeof(erb_content_range_T)
+    );
+    index->capacity = capacity;
   }
 
-  return true;
+  index->ranges[index->size++] = (erb_content_range_T) { .from = erb_node->tag_opening->range.from,
+                                                          .to = erb_node->tag_closing->range.to,
+                                                          .node = (AST_NODE_T*) node };
+
+  return false;
+}
+
+static int compare_erb_content_ranges(const void* a, const void* b) {
+  const erb_content_range_T* left = (const erb_content_range_T*) a;
+  const erb_content_range_T* right = (const erb_content_range_T*) b;
+
+  if (left->from < right->from) { return -1; }
+  if (left->from > right->from) { return 1; }
+
+  return 0;
 }
 
-AST_NODE_T* find_erb_content_at_offset(AST_DOCUMENT_NODE_T* document, const char* source, size_t offset) {
-  position_T position = position_from_source_with_offset(source, offset);
-  find_erb_at_position_context_T context = { .position = position, .found_node = NULL };
+/**
+ * Builds a sorted index of the byte ranges of every ERB content node in `document`,
+ * so offsets into the source can be mapped back to their ERB tag in O(log n)
+ * instead of walking the tree for each lookup.
+ */
+void erb_content_index_init(erb_content_index_T* index, AST_DOCUMENT_NODE_T* document) {
+  index->ranges = NULL;
+  index->size = 0;
+  index->capacity = 0;
+
+  herb_visit_node((AST_NODE_T*) document, collect_erb_content_ranges, index);
+
+  for (size_t i = 1; i < index->size; i++) {
+    if (index->ranges[i - 1].from > index->ranges[i].from) {
+      qsort(index->ranges, index->size, sizeof(erb_content_range_T), compare_erb_content_ranges);
+      break;
+    }
+  }
+}
+
+/**
+ * @return the ERB content node whose tag spans `offset` (both ends inclusive), or NULL
+ */
+AST_NODE_T* erb_content_index_find(const erb_content_index_T* index, size_t offset) {
+  size_t low = 0;
+  size_t high = index->size;
+
+  // ERB tags don't overlap, so the first range ending at or after `offset` is the only candidate.
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+
+    if (index->ranges[middle].to < offset) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (low < index->size && index->ranges[low].from <= offset) { return index->ranges[low].node; }
+
+  return NULL;
+}
 
-  herb_visit_node((AST_NODE_T*) document, find_erb_at_position_visitor, &context);
+void erb_content_index_free(erb_content_index_T* index) {
+  hb_memory_free(index->ranges);
 
-  return context.found_node;
+  index->ranges = NULL;
+  index->size = 0;
+  index->capacity = 0;
 }
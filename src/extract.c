@@ -1,133 +1,189 @@
 #include "include/herb.h"
 #include "include/io.h"
 #include "include/lexer.h"
+#include "include/util.h"
 #include "include/util/hb_array.h"
 #include "include/util/hb_buffer.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-void herb_extract_ruby_to_buffer(const char* source, hb_buffer_T* output) {
-  hb_array_T* tokens = herb_lex(source);
-  bool skip_erb_content = false;
-  bool is_comment_tag = false;
-
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    const token_T* token = hb_array_get(tokens, i);
-
-    switch (token->type) {
-      case TOKEN_NEWLINE: {
-        hb_buffer_append(output, token->value);
-        break;
-      }
+void herb_ruby_extractor_init(herb_ruby_extractor_T* extractor, hb_buffer_T* output) {
+  extractor->output = output;
+  extractor->position = 0;
+  extractor->skip_erb_content = false;
+  extractor->is_comment_tag = false;
+  extractor->complete = false;
+}
 
-      case TOKEN_ERB_START: {
-        if (strcmp(token->value, "<%#") == 0) {
-          skip_erb_content = true;
-          is_comment_tag = true;
-        } else if (strcmp(token->value, "<%%") == 0 || strcmp(token->value, "<%%=") == 0) {
-          skip_erb_content = true;
-          is_comment_tag = false;
-        } else {
-          skip_erb_content = false;
-          is_comment_tag = false;
-        }
+/**
+ * Appends the Ruby projection of `token` to the extractor's output: ERB code
+ * is kept, every ERB tag is terminated with `;` and everything else becomes
+ * whitespace, so byte offsets line up with the HTML+ERB source.
+ *
+ * Tokens have to arrive in source order. A token that doesn't start where the
+ * previous one ended (e.g. when the lexer is rewound for lookahead) is ignored,
+ * so the extractor can observe a backtracking token stream.
+ */
+void herb_ruby_extractor_append_token(herb_ruby_extractor_T* extractor, const token_T* token) {
+  if (token->range.from != extractor->position) { return; }
+
+  hb_buffer_T* output = extractor->output;
+  extractor->position = token->range.to;
+
+  switch (token->type) {
+    case TOKEN_NEWLINE: {
+      hb_buffer_append_string(output, token->value);
+      break;
+    }
 
-        hb_buffer_append_whitespace(output, range_length(token->range));
-        break;
+    case TOKEN_ERB_START: {
+      if (hb_string_equals(token->value, hb_string("<%#"))) {
+        extractor->skip_erb_content = true;
+        extractor->is_comment_tag = true;
+      } else if (hb_string_equals(token->value, hb_string("<%%"))
+                 || hb_string_equals(token->value, hb_string("<%%="))) {
+        extractor->skip_erb_content = true;
+        extractor->is_comment_tag = false;
+      } else {
+        extractor->skip_erb_content = false;
+        extractor->is_comment_tag = false;
       }
 
-      case TOKEN_ERB_CONTENT: {
-        if (skip_erb_content == false) {
-          bool is_inline_comment = false;
+      hb_buffer_append_whitespace(output, range_length(token->range));
+      break;
+    }
 
-          if (!is_comment_tag && token->value != NULL) {
-            const char* content = token->value;
+    case TOKEN_ERB_CONTENT: {
+      if (extractor->skip_erb_content == false) {
+        bool is_inline_comment = false;
 
-            while (*content == ' ' || *content == '\t') {
-              content++;
-            }
+        if (!extractor->is_comment_tag) {
+          uint32_t index = 0;
 
-            if (*content == '#' && token->location.start.line == token->location.end.line) {
-              is_comment_tag = true;
-              is_inline_comment = true;
-            }
+          while (index < token->value.length && (token->value.data[index] == ' ' || token->value.data[index] == '\t')) {
+            index++;
           }
 
-          if (is_inline_comment) {
-            hb_buffer_append_whitespace(output, range_length(token->range));
-          } else {
-            hb_buffer_append(output, token->value);
+          if (index < token->value.length && token->value.data[index] == '#'
+              && token->location.start.line == token->location.end.line) {
+            extractor->is_comment_tag = true;
+            is_inline_comment = true;
           }
-        } else {
-          hb_buffer_append_whitespace(output, range_length(token->range));
         }
 
-        break;
+        if (is_inline_comment) {
+          hb_buffer_append_whitespace(output, range_length(token->range));
+        } else {
+          hb_buffer_append_string(output, token->value);
+        }
+      } else {
+        hb_buffer_append_whitespace(output, range_length(token->range));
       }
 
-      case TOKEN_ERB_END: {
-        bool was_comment = is_comment_tag;
-        skip_erb_content = false;
-        is_comment_tag = false;
+      break;
+    }
 
-        if (was_comment) {
-          hb_buffer_append_whitespace(output, range_length(token->range));
-          break;
-        }
+    case TOKEN_ERB_END: {
+      bool was_comment = extractor->is_comment_tag;
+      extractor->skip_erb_content = false;
+      extractor->is_comment_tag = false;
 
-        hb_buffer_append_char(output, ' ');
-        hb_buffer_append_char(output, ';');
-        hb_buffer_append_whitespace(output, range_length(token->range) - 2);
+      if (was_comment) {
+        hb_buffer_append_whitespace(output, range_length(token->range));
         break;
       }
 
-      default: {
-        hb_buffer_append_whitespace(output, range_length(token->range));
+      hb_buffer_append_char(output, ' ');
+      hb_buffer_append_char(output, ';');
+      hb_buffer_append_whitespace(output, range_length(token->range) - 2);
+      break;
+    }
+
+    case TOKEN_TEXT: {
+      for (uint32_t index = 0; index < token->value.length; index++) {
+        const char character = token->value.data[index];
+        hb_buffer_append_char(output, is_newline(character) ? character : ' ');
       }
+
+      break;
+    }
+
+    case TOKEN_EOF: {
+      extractor->complete = true;
+      break;
+    }
+
+    default: {
+      hb_buffer_append_whitespace(output, range_length(token->range));
     }
   }
+}
+
+void herb_extract_ruby_to_buffer(const char* source, hb_buffer_T* output) {
+  herb_extract_ruby_to_buffer_n(source, strlen(source), output);
+}
+
+void herb_extract_ruby_to_buffer_n(const char* source, size_t length, hb_buffer_T* output) {
+  herb_lexer_T lexer;
+  herb_lexer_init_n(&lexer, source, length);
 
-  herb_free_tokens(&tokens);
+  herb_ruby_extractor_T extractor;
+  herb_ruby_extractor_init(&extractor, output);
+
+  const token_T* token = NULL;
+
+  while ((token = herb_lexer_next(&lexer)) != NULL) {
+    herb_ruby_extractor_append_token(&extractor, token);
+  }
 }
 
 void herb_extract_html_to_buffer(const char* source, hb_buffer_T* output) {
-  hb_array_T* tokens = herb_lex(source);
+  herb_extract_html_to_buffer_n(source, strlen(source), output);
+}
+
+void herb_extract_html_to_buffer_n(const char* source, size_t length, hb_buffer_T* output) {
+  herb_lexer_T lexer;
+  herb_lexer_init_n(&lexer, source, length);
 
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    const token_T* token = hb_array_get(tokens, i);
+  const token_T* token = NULL;
 
+  while ((token = herb_lexer_next(&lexer)) != NULL) {
     switch (token->type) {
       case TOKEN_ERB_START:
       case TOKEN_ERB_CONTENT:
       case TOKEN_ERB_END: hb_buffer_append_whitespace(output, range_length(token->range)); break;
-      default: hb_buffer_append(output, token->value);
+      default: hb_buffer_append_string(output, token->value);
     }
   }
-
-  herb_free_tokens(&tokens);
 }
 
 char* herb_extract_ruby_with_semicolons(const char* source) {
   if (!source) { return NULL; }
 
-  hb_buffer_T output;
-  hb_buffer_init(&output, strlen(source));
+  return herb_extract_n(source, strlen(source), HERB_EXTRACT_LANGUAGE_RUBY);
+}
 
-  herb_extract_ruby_to_buffer(source, &output);
+char* herb_extract(const char* source, const herb_extract_language_T language) {
+  if (!source) { return NULL; }
 
-  return output.value;
+  return herb_extract_n(source, strlen(source), language);
 }
 
-char* herb_extract(const char* source, const herb_extract_language_T language) {
+/**
+ * Like herb_extract(), for the first `length` bytes of `source`, which may contain
+ * NUL bytes. The projection keeps every byte offset, so the result is `length`
+ * bytes long, plus a NUL terminator.
+ */
+char* herb_extract_n(const char* source, size_t length, const herb_extract_language_T language) {
   if (!source) { return NULL; }
 
   hb_buffer_T output;
-  hb_buffer_init(&output, strlen(source));
+  hb_buffer_init(&output, length);
 
   switch (language) {
-    case HERB_EXTRACT_LANGUAGE_RUBY: herb_extract_ruby_to_buffer(source, &output); break;
-    case HERB_EXTRACT_LANGUAGE_HTML: herb_extract_html_to_buffer(source, &output); break;
+    case HERB_EXTRACT_LANGUAGE_RUBY: herb_extract_ruby_to_buffer_n(source, length, &output); break;
+    case HERB_EXTRACT_LANGUAGE_HTML: herb_extract_html_to_buffer_n(source, length, &output); break;
   }
 
   return output.value;
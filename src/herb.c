@@ -1,18 +1,33 @@
 #include "include/herb.h"
+#include "include/analyze.h"
 #include "include/io.h"
 #include "include/lexer.h"
+#include "include/macros.h"
 #include "include/parser.h"
 #include "include/token.h"
 #include "include/util/hb_array.h"
 #include "include/util/hb_buffer.h"
+#include "include/util/hb_memory.h"
+#include "include/util/hb_thread_pool.h"
 #include "include/version.h"
 
 #include <prism.h>
 #include <stdlib.h>
+#include <string.h>
 
 hb_array_T* herb_lex(const char* source) {
+  if (!source) { source = ""; }
+
+  return herb_lex_n(source, strlen(source));
+}
+
+/**
+ * Like herb_lex(), for the first `length` bytes of `source`. The source doesn't
+ * need to be NUL-terminated and may contain NUL bytes.
+ */
+hb_array_T* herb_lex_n(const char* source, size_t length) {
   lexer_T lexer = { 0 };
-  lexer_init(&lexer, source);
+  lexer_init_n(&lexer, source, length);
 
   token_T* token = NULL;
   hb_array_T* tokens = hb_array_init(128);
@@ -26,23 +41,107 @@ hb_array_T* herb_lex(const char* source) {
   return tokens;
 }
 
+void herb_lexer_init(herb_lexer_T* lexer, const char* source) {
+  if (!source) { source = ""; }
+
+  herb_lexer_init_n(lexer, source, strlen(source));
+}
+
+void herb_lexer_init_n(herb_lexer_T* lexer, const char* source, size_t length) {
+  *lexer = (herb_lexer_T) { 0 };
+
+  lexer_init_n(&lexer->lexer, source, length);
+  lexer->lexer.token_slot = &lexer->token;
+}
+
+/**
+ * Returns the next token of the source, ending with TOKEN_EOF, and NULL after
+ * that. See `herb_lexer_T` for the lifetime of the returned token.
+ */
+const token_T* herb_lexer_next(herb_lexer_T* lexer) {
+  if (lexer->finished) { return NULL; }
+
+  const token_T* token = lexer_next_token(&lexer->lexer);
+  if (token->type == TOKEN_EOF) { lexer->finished = true; }
+
+  return token;
+}
+
+static hb_arena_T* herb_document_arena_init(void) {
+  hb_arena_T* arena = malloc(sizeof(hb_arena_T));
+  if (arena == NULL) { return NULL; }
+
+  if (!hb_arena_init(arena, KB(64))) {
+    free(arena);
+    return NULL;
+  }
+
+  return arena;
+}
+
+/**
+ * Parses `source` into a document node.
+ *
+ * With `options->use_arena` set, every allocation made for the document (nodes,
+ * arrays, tokens, strings and errors, including those added later by
+ * herb_analyze_parse_tree()) comes from an arena owned by the document.
+ * ast_node_free() on the document then releases it in one go instead of
+ * walking the tree. Individual nodes of such a document must not be freed.
+ */
 AST_DOCUMENT_NODE_T* herb_parse(const char* source, parser_options_T* options) {
   if (!source) { source = ""; }
 
+  return herb_parse_n(source, strlen(source), options);
+}
+
+/**
+ * Like herb_parse(), for the first `length` bytes of `source`. The source doesn't
+ * need to be NUL-terminated and may contain NUL bytes. Pass the same length to
+ * herb_analyze_parse_tree_n().
+ */
+AST_DOCUMENT_NODE_T* herb_parse_n(const char* source, size_t length, parser_options_T* options) {
   lexer_T lexer = { 0 };
-  lexer_init(&lexer, source);
+  lexer_init_n(&lexer, source, length);
   parser_T parser = { 0 };
 
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
 
   if (options != NULL) { parser_options = *options; }
 
-  herb_parser_init(&parser, &lexer, parser_options);
+  hb_arena_T* arena = parser_options.use_arena ? herb_document_arena_init() : NULL;
+  hb_arena_T* previous_arena = hb_memory_use_arena(arena);
+
+  // The Ruby projection used by herb_analyze_parse_errors() is built from the tokens the parser consumes,
+  // so the template doesn't have to be lexed a second time.
+  hb_buffer_T extracted_ruby;
+  herb_ruby_extractor_T ruby_extractor;
+
+  hb_buffer_init(&extracted_ruby, lexer.source.length);
+  herb_ruby_extractor_init(&ruby_extractor, &extracted_ruby);
+  lexer.ruby_extractor = &ruby_extractor;
+
+  herb_parser_init(&parser, &lexer, parser_options, arena);
 
   AST_DOCUMENT_NODE_T* document = herb_parser_parse(&parser);
 
   herb_parser_deinit(&parser);
 
+  // A cancelled parse ends with an EOF token too, but its projection stops short of the source.
+  if (document != NULL && ruby_extractor.complete && !lexer.cancelled) {
+    document->extracted_ruby = extracted_ruby.value;
+  } else {
+    hb_memory_free(extracted_ruby.value);
+  }
+
+  if (document != NULL) { document->cancelled = lexer.cancelled; }
+
+  hb_memory_use_arena(previous_arena);
+
+  if (document == NULL && arena != NULL) {
+    hb_arena_free(arena);
+    free(arena);
+  }
+
   return document;
 }
 
@@ -50,25 +149,31 @@ hb_array_T* herb_lex_file(const char* path) {
   char* source = herb_read_file(path);
   hb_array_T* tokens = herb_lex(source);
 
+  // Token values are views into `source`, so they need their own storage before it is freed.
+  for (size_t i = 0; i < hb_array_size(tokens); i++) {
+    token_T* token = hb_array_get(tokens, i);
+    hb_array_set(tokens, i, token_copy_owned(token));
+    token_free(token);
+  }
+
   free(source);
 
   return tokens;
 }
 
 void herb_lex_to_buffer(const char* source, hb_buffer_T* output) {
-  hb_array_T* tokens = herb_lex(source);
+  herb_lexer_T lexer;
+  herb_lexer_init(&lexer, source);
 
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    token_T* token = hb_array_get(tokens, i);
+  const token_T* token = NULL;
 
+  while ((token = herb_lexer_next(&lexer)) != NULL) {
     hb_string_T type = token_to_string(token);
     hb_buffer_append_string(output, type);
-    free(type.data);
+    hb_memory_free(type.data);
 
     hb_buffer_append(output, "\n");
   }
-
-  herb_free_tokens(&tokens);
 }
 
 void herb_free_tokens(hb_array_T** tokens) {
@@ -82,6 +187,90 @@ void herb_free_tokens(hb_array_T** tokens) {
   hb_array_free(tokens);
 }
 
+typedef struct {
+  const herb_source_T* sources;
+  parser_options_T* options;
+  herb_extract_language_T language;
+  hb_array_T** tokens;
+  AST_DOCUMENT_NODE_T** documents;
+  char** extracted;
+} herb_batch_T;
+
+static void herb_lex_batch_task(size_t index, void* data) {
+  herb_batch_T* batch = (herb_batch_T*) data;
+  const herb_source_T* source = &batch->sources[index];
+
+  batch->tokens[index] = herb_lex_n(source->source, source->length);
+}
+
+static void herb_parse_batch_task(size_t index, void* data) {
+  herb_batch_T* batch = (herb_batch_T*) data;
+  const herb_source_T* source = &batch->sources[index];
+
+  herb_cancel_callback_T cancel = batch->options != NULL ? batch->options->cancel : NULL;
+  void* cancel_data = batch->options != NULL ? batch->options->cancel_data : NULL;
+
+  AST_DOCUMENT_NODE_T* document = herb_parse_n(source->source, source->length, batch->options);
+  herb_analyze_parse_tree_cancellable_n(document, source->source, source->length, cancel, cancel_data);
+
+  batch->documents[index] = document;
+}
+
+static void herb_extract_batch_task(size_t index, void* data) {
+  herb_batch_T* batch = (herb_batch_T*) data;
+  const herb_source_T* source = &batch->sources[index];
+
+  batch->extracted[index] = herb_extract_n(source->source, source->length, batch->language);
+}
+
+/**
+ * Lexes `count` sources on up to `thread_count` threads (the processor count if 0)
+ * and stores the tokens of `sources[i]` in `results[i]`, as herb_lex_n() would.
+ */
+void herb_lex_batch(const herb_source_T* sources, size_t count, size_t thread_count, hb_array_T** results) {
+  herb_batch_T batch = { .sources = sources, .tokens = results };
+
+  hb_thread_pool_run(count, thread_count, herb_lex_batch_task, &batch);
+}
+
+/**
+ * Parses and analyzes `count` sources on up to `thread_count` threads (the processor
+ * count if 0). `results[i]` is the document of `sources[i]`, the same as herb_parse_n()
+ * followed by herb_analyze_parse_tree_n() returns; free each one with ast_node_free().
+ *
+ * Every parse has its own parser, Prism parser and allocator state, so nothing is
+ * shared between threads. The `cancel` callback of `options` is called from all of
+ * them and has to be thread-safe.
+ */
+void herb_parse_batch(
+  const herb_source_T* sources,
+  size_t count,
+  parser_options_T* options,
+  size_t thread_count,
+  AST_DOCUMENT_NODE_T** results
+) {
+  herb_batch_T batch = { .sources = sources, .options = options, .documents = results };
+
+  hb_thread_pool_run(count, thread_count, herb_parse_batch_task, &batch);
+}
+
+/**
+ * Extracts `language` from `count` sources on up to `thread_count` threads (the
+ * processor count if 0) and stores the result of herb_extract_n() for `sources[i]`
+ * in `results[i]`.
+ */
+void herb_extract_batch(
+  const herb_source_T* sources,
+  size_t count,
+  herb_extract_language_T language,
+  size_t thread_count,
+  char** results
+) {
+  herb_batch_T batch = { .sources = sources, .language = language, .extracted = results };
+
+  hb_thread_pool_run(count, thread_count, herb_extract_batch_task, &batch);
+}
+
 const char* herb_version(void) {
   return HERB_VERSION;
 }
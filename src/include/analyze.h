@@ -3,7 +3,9 @@
 
 #include "analyzed_ruby.h"
 #include "ast_nodes.h"
+#include "lexer_struct.h"
 #include "util/hb_array.h"
+#include "util/hb_string.h"
 
 typedef struct ANALYZE_RUBY_CONTEXT_STRUCT {
   AST_DOCUMENT_NODE_T* document;
@@ -11,35 +13,33 @@ typedef struct ANALYZE_RUBY_CONTEXT_STRUCT {
   hb_array_T* ruby_context_stack;
 } analyze_ruby_context_T;
 
-typedef enum {
-  CONTROL_TYPE_IF,
-  CONTROL_TYPE_ELSIF,
-  CONTROL_TYPE_ELSE,
-  CONTROL_TYPE_END,
-  CONTROL_TYPE_CASE,
-  CONTROL_TYPE_CASE_MATCH,
-  CONTROL_TYPE_WHEN,
-  CONTROL_TYPE_IN,
-  CONTROL_TYPE_BEGIN,
-  CONTROL_TYPE_RESCUE,
-  CONTROL_TYPE_ENSURE,
-  CONTROL_TYPE_UNLESS,
-  CONTROL_TYPE_WHILE,
-  CONTROL_TYPE_UNTIL,
-  CONTROL_TYPE_FOR,
-  CONTROL_TYPE_BLOCK,
-  CONTROL_TYPE_BLOCK_CLOSE,
-  CONTROL_TYPE_YIELD,
-  CONTROL_TYPE_UNKNOWN
-} control_type_t;
-
 typedef struct {
   int loop_depth;
   int rescue_depth;
 } invalid_erb_context_T;
 
+typedef struct ANALYZE_CACHE_STATS_STRUCT {
+  size_t hits;
+  size_t misses;
+} analyze_cache_stats_T;
+
 void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source);
+void herb_analyze_parse_errors_n(AST_DOCUMENT_NODE_T* document, const char* source, size_t length);
 void herb_analyze_parse_tree(AST_DOCUMENT_NODE_T* document, const char* source);
+void herb_analyze_parse_tree_n(AST_DOCUMENT_NODE_T* document, const char* source, size_t length);
+void herb_analyze_parse_tree_cancellable_n(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t length,
+  herb_cancel_callback_T cancel,
+  void* cancel_data
+);
+
+void analyze_ruby_with_prism(hb_string_T source, analyzed_ruby_T* analyzed);
+
+void herb_analyze_cache_configure(size_t max_entries);
+analyze_cache_stats_T herb_analyze_cache_stats(void);
+void herb_analyze_cache_reset_stats(void);
 
 hb_array_T* rewrite_node_array(AST_NODE_T* node, hb_array_T* array, analyze_ruby_context_T* context);
 bool transform_erb_nodes(const AST_NODE_T* node, void* data);
@@ -26,27 +26,10 @@ bool has_ensure_node(analyzed_ruby_T* analyzed);
 bool has_unless_node(analyzed_ruby_T* analyzed);
 bool has_yield_node(analyzed_ruby_T* analyzed);
 
-bool has_error_message(analyzed_ruby_T* anlayzed, const char* message);
+bool search_ruby_nodes(const pm_node_t* node, void* data);
+void search_ruby_errors(analyzed_ruby_T* analyzed, const pm_parser_t* parser);
+bool classify_trivial_ruby(hb_string_T source, analyzed_ruby_T* analyzed);
 
-bool search_if_nodes(const pm_node_t* node, void* data);
-bool search_block_nodes(const pm_node_t* node, void* data);
-bool search_case_nodes(const pm_node_t* node, void* data);
-bool search_case_match_nodes(const pm_node_t* node, void* data);
-bool search_while_nodes(const pm_node_t* node, void* data);
-bool search_for_nodes(const pm_node_t* node, void* data);
-bool search_until_nodes(const pm_node_t* node, void* data);
-bool search_begin_nodes(const pm_node_t* node, void* data);
-bool search_unless_nodes(const pm_node_t* node, void* data);
-bool search_elsif_nodes(analyzed_ruby_T* analyzed);
-bool search_else_nodes(analyzed_ruby_T* analyzed);
-bool search_end_nodes(analyzed_ruby_T* analyzed);
-bool search_block_closing_nodes(analyzed_ruby_T* analyzed);
-bool search_when_nodes(analyzed_ruby_T* analyzed);
-bool search_in_nodes(analyzed_ruby_T* analyzed);
-bool search_rescue_nodes(analyzed_ruby_T* analyzed);
-bool search_ensure_nodes(analyzed_ruby_T* analyzed);
-bool search_yield_nodes(const pm_node_t* node, void* data);
-
-void check_erb_node_for_missing_end(const AST_NODE_T* node);
+void check_erb_node_for_missing_end(AST_NODE_T* node);
 
 #endif
@@ -4,13 +4,39 @@
 #include "util/hb_array.h"
 #include "util/hb_string.h"
 
-#include <prism.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+typedef enum {
+  CONTROL_TYPE_IF,
+  CONTROL_TYPE_ELSIF,
+  CONTROL_TYPE_ELSE,
+  CONTROL_TYPE_END,
+  CONTROL_TYPE_CASE,
+  CONTROL_TYPE_CASE_MATCH,
+  CONTROL_TYPE_WHEN,
+  CONTROL_TYPE_IN,
+  CONTROL_TYPE_BEGIN,
+  CONTROL_TYPE_RESCUE,
+  CONTROL_TYPE_ENSURE,
+  CONTROL_TYPE_UNLESS,
+  CONTROL_TYPE_WHILE,
+  CONTROL_TYPE_UNTIL,
+  CONTROL_TYPE_FOR,
+  CONTROL_TYPE_BLOCK,
+  CONTROL_TYPE_BLOCK_CLOSE,
+  CONTROL_TYPE_YIELD,
+  CONTROL_TYPE_UNKNOWN
+} control_type_t;
+
+/**
+ * Classification of a single ERB snippet. Everything the analyzer needs is
+ * computed up front, so the Prism parse is released right after analysis and
+ * the struct can be copied freely (see `analyzed_ruby_cache_T`).
+ */
 typedef struct ANALYZED_RUBY_STRUCT {
-  pm_parser_t parser;
-  pm_node_t* root;
   bool valid;
-  bool parsed;
   bool has_if_node;
   bool has_elsif_node;
   bool has_else_node;
@@ -29,10 +55,47 @@ typedef struct ANALYZED_RUBY_STRUCT {
   bool has_ensure_node;
   bool has_unless_node;
   bool has_yield_node;
+  bool has_unterminated_embedded_document;
+  bool has_embedded_document_end;
+  bool has_invalid_break;
+  bool has_invalid_next;
+  bool has_invalid_redo;
+  bool has_invalid_retry;
+  control_type_t earliest_control_type;
 } analyzed_ruby_T;
 
-analyzed_ruby_T* init_analyzed_ruby(hb_string_T source);
+typedef struct ANALYZED_RUBY_CACHE_ENTRY_STRUCT {
+  hb_string_T source;
+  uint32_t hash;
+  bool occupied;
+  analyzed_ruby_T analyzed;
+} analyzed_ruby_cache_entry_T;
+
+/**
+ * Open-addressing map from ERB snippet bytes to their `analyzed_ruby_T`.
+ *
+ * A cache with `owns_keys == false` borrows the snippet bytes, so it must not
+ * outlive the source it was filled from. `max_entries == 0` means unbounded;
+ * a bounded cache starts over once it is full.
+ */
+typedef struct ANALYZED_RUBY_CACHE_STRUCT {
+  analyzed_ruby_cache_entry_T* entries;
+  size_t capacity;
+  size_t size;
+  size_t max_entries;
+  bool owns_keys;
+  size_t hits;
+  size_t misses;
+} analyzed_ruby_cache_T;
+
+analyzed_ruby_T* init_analyzed_ruby(void);
 void free_analyzed_ruby(analyzed_ruby_T* analyzed);
 const char* erb_keyword_from_analyzed_ruby(const analyzed_ruby_T* analyzed);
 
+void analyzed_ruby_cache_init(analyzed_ruby_cache_T* cache, size_t max_entries, bool owns_keys);
+const analyzed_ruby_T* analyzed_ruby_cache_lookup(analyzed_ruby_cache_T* cache, hb_string_T source);
+void analyzed_ruby_cache_store(analyzed_ruby_cache_T* cache, hb_string_T source, const analyzed_ruby_T* analyzed);
+void analyzed_ruby_cache_clear(analyzed_ruby_cache_T* cache);
+void analyzed_ruby_cache_free(analyzed_ruby_cache_T* cache);
+
 #endif
@@ -23,7 +23,7 @@ void ast_node_set_end(AST_NODE_T* node, position_T position);
 
 size_t ast_node_errors_count(const AST_NODE_T* node);
 hb_array_T* ast_node_errors(const AST_NODE_T* node);
-void ast_node_append_error(const AST_NODE_T* node, ERROR_T* error);
+void ast_node_append_error(AST_NODE_T* node, ERROR_T* error);
 
 void ast_node_set_start_from_token(AST_NODE_T* node, const token_T* token);
 void ast_node_set_end_from_token(AST_NODE_T* node, const token_T* token);
@@ -32,6 +32,21 @@ void ast_node_set_positions_from_token(AST_NODE_T* node, const token_T* token);
 
 bool ast_node_is(const AST_NODE_T* node, ast_node_type_T type);
 
-AST_NODE_T* find_erb_content_at_offset(AST_DOCUMENT_NODE_T* document, const char* source, size_t offset);
+typedef struct ERB_CONTENT_RANGE_STRUCT {
+  uint32_t from;
+  uint32_t to;
+  AST_NODE_T* node;
+} erb_content_range_T;
+
+// Byte ranges of all ERB content nodes of a document (from `<%` to `%>`), sorted by offset.
+typedef struct ERB_CONTENT_INDEX_STRUCT {
+  erb_content_range_T* ranges;
+  size_t size;
+  size_t capacity;
+} erb_content_index_T;
+
+void erb_content_index_init(erb_content_index_T* index, AST_DOCUMENT_NODE_T* document);
+AST_NODE_T* erb_content_index_find(const erb_content_index_T* index, size_t offset);
+void erb_content_index_free(erb_content_index_T* index);
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef HERB_AST_SERIALIZE_H
+#define HERB_AST_SERIALIZE_H
+
+#include "ast_nodes.h"
+#include "util/hb_buffer.h"
+
+// Bumped whenever the byte layout changes, including changes to config.yml or token_type_T.
+#define HERB_SERIALIZATION_VERSION 1
+
+void herb_serialize(const AST_DOCUMENT_NODE_T* document, hb_buffer_T* output);
+
+#endif
@@ -1,19 +1,38 @@
 #ifndef HERB_EXTRACT_H
 #define HERB_EXTRACT_H
 
+#include "token_struct.h"
 #include "util/hb_buffer.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum {
   HERB_EXTRACT_LANGUAGE_RUBY,
   HERB_EXTRACT_LANGUAGE_HTML,
 } herb_extract_language_T;
 
+typedef struct HERB_RUBY_EXTRACTOR_STRUCT {
+  hb_buffer_T* output;
+  uint32_t position; // end of the last token appended to `output`
+  bool skip_erb_content;
+  bool is_comment_tag;
+  bool complete; // whether the EOF token was reached
+} herb_ruby_extractor_T;
+
+void herb_ruby_extractor_init(herb_ruby_extractor_T* extractor, hb_buffer_T* output);
+void herb_ruby_extractor_append_token(herb_ruby_extractor_T* extractor, const token_T* token);
+
 void herb_extract_ruby_to_buffer(const char* source, hb_buffer_T* output);
+void herb_extract_ruby_to_buffer_n(const char* source, size_t length, hb_buffer_T* output);
 void herb_extract_html_to_buffer(const char* source, hb_buffer_T* output);
+void herb_extract_html_to_buffer_n(const char* source, size_t length, hb_buffer_T* output);
 
 char* herb_extract_ruby_with_semicolons(const char* source);
 
 char* herb_extract(const char* source, herb_extract_language_T language);
+char* herb_extract_n(const char* source, size_t length, herb_extract_language_T language);
 char* herb_extract_from_file(const char* path, herb_extract_language_T language);
 
 #endif
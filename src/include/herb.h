@@ -3,22 +3,71 @@
 
 #include "ast_node.h"
 #include "extract.h"
+#include "lexer_struct.h"
+#include "line_index.h"
 #include "parser.h"
+#include "token_stream.h"
 #include "util/hb_array.h"
 #include "util/hb_buffer.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Pull-based lexer over a NUL-terminated source.
+ *
+ * Every token is written into the same `token` slot, so lexing takes constant
+ * memory no matter how long the source is. The returned token is only valid
+ * until the next call to herb_lexer_next() and must not be freed; its value is
+ * a view into `source`, which has to outlive the lexer.
+ */
+typedef struct HERB_LEXER_STRUCT {
+  lexer_T lexer;
+  token_T token;
+  bool finished; // whether the EOF token was returned
+} herb_lexer_T;
+
+void herb_lexer_init(herb_lexer_T* lexer, const char* source);
+void herb_lexer_init_n(herb_lexer_T* lexer, const char* source, size_t length);
+const token_T* herb_lexer_next(herb_lexer_T* lexer);
+
+/**
+ * One source of a batch. It doesn't need to be NUL-terminated and has to stay
+ * alive as long as the results that point into it.
+ */
+typedef struct HERB_SOURCE_STRUCT {
+  const char* source;
+  size_t length;
+} herb_source_T;
+
 void herb_lex_to_buffer(const char* source, hb_buffer_T* output);
 
 hb_array_T* herb_lex(const char* source);
+hb_array_T* herb_lex_n(const char* source, size_t length);
 hb_array_T* herb_lex_file(const char* path);
 
 AST_DOCUMENT_NODE_T* herb_parse(const char* source, parser_options_T* options);
+AST_DOCUMENT_NODE_T* herb_parse_n(const char* source, size_t length, parser_options_T* options);
+
+void herb_lex_batch(const herb_source_T* sources, size_t count, size_t thread_count, hb_array_T** results);
+void herb_parse_batch(
+  const herb_source_T* sources,
+  size_t count,
+  parser_options_T* options,
+  size_t thread_count,
+  AST_DOCUMENT_NODE_T** results
+);
+void herb_extract_batch(
+  const herb_source_T* sources,
+  size_t count,
+  herb_extract_language_T language,
+  size_t thread_count,
+  char** results
+);
 
 const char* herb_version(void);
 const char* herb_prism_version(void);
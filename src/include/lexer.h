@@ -4,7 +4,11 @@
 #include "lexer_struct.h"
 #include "token_struct.h"
 
+#include <stddef.h>
+
 void lexer_init(lexer_T* lexer, const char* source);
+void lexer_init_n(lexer_T* lexer, const char* source, size_t length);
+void lexer_init_at(lexer_T* lexer, const char* source, size_t length, uint32_t offset, position_T position);
 token_T* lexer_next_token(lexer_T* lexer);
 token_T* lexer_error(lexer_T* lexer, const char* message);
 
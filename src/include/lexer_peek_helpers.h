@@ -39,6 +39,9 @@ char lexer_backtrack(const lexer_T* lexer, uint32_t offset);
 
 bool lexer_peek_for_token_type_after_whitespace(lexer_T* lexer, token_type_T token_type);
 bool lexer_peek_for_close_tag_start(const lexer_T* lexer, uint32_t offset);
+bool lexer_peek_for_text_end(const lexer_T* lexer, uint32_t offset);
+bool lexer_peek_for_raw_text_tag_name(const lexer_T* lexer, uint32_t offset);
+bool lexer_peek_for_raw_text_end(const lexer_T* lexer, uint32_t offset);
 
 lexer_state_snapshot_T lexer_save_state(lexer_T* lexer);
 void lexer_restore_state(lexer_T* lexer, lexer_state_snapshot_T snapshot);
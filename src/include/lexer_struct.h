@@ -1,6 +1,8 @@
 #ifndef HERB_LEXER_STRUCT_H
 #define HERB_LEXER_STRUCT_H
 
+#include "extract.h"
+#include "token_struct.h"
 #include "util/hb_string.h"
 
 #include <stdbool.h>
@@ -9,10 +11,17 @@
 
 typedef enum {
   STATE_DATA,
+  STATE_TEXT, // the next token is the rest of a text run, as one TOKEN_TEXT; set by the parser
+  STATE_RAW_TEXT, // like STATE_TEXT, but for the content of <script> and <style>, see `raw_text_tag_name`
   STATE_ERB_CONTENT,
   STATE_ERB_CLOSE,
 } lexer_state_T;
 
+#define LEXER_ERROR_MESSAGE_SIZE 128
+
+// Returns true once the parse should stop, see `parser_options_T.cancel`.
+typedef bool (*herb_cancel_callback_T)(void* data);
+
 typedef struct LEXER_STRUCT {
   hb_string_T source;
 
@@ -29,6 +38,16 @@ typedef struct LEXER_STRUCT {
   uint32_t stall_counter;
   uint32_t last_position;
   bool stalled;
+
+  herb_ruby_extractor_T* ruby_extractor; // optional, receives every token in source order
+  hb_string_T raw_text_tag_name; // the closing tag that ends STATE_RAW_TEXT, set by the parser
+  token_T* token_slot; // optional, reused for every token instead of allocating one, see herb_lexer_next()
+  char error_message[LEXER_ERROR_MESSAGE_SIZE]; // value of the error token in `token_slot`, see token_init_owned()
+
+  herb_cancel_callback_T cancel; // optional, polled every LEXER_CANCEL_INTERVAL tokens
+  void* cancel_data;
+  uint32_t tokens_until_cancel_check;
+  bool cancelled; // once set, the lexer behaves as if it reached the end of the source
 } lexer_T;
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef HERB_LINE_INDEX_H
+#define HERB_LINE_INDEX_H
+
+#include "position.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Byte offsets of the start of every line of a source, for converting between
+ * byte offsets and (line, column) positions in O(log n).
+ *
+ * Lines are 1-based and columns 0-based, like `position_T`. `\n`, `\r\n` and a
+ * lone `\r` each end a line, the same way the lexer counts them. The index
+ * doesn't copy `source`, which has to outlive it.
+ */
+typedef struct LINE_INDEX_STRUCT {
+  const char* source;
+  uint32_t length;
+  uint32_t* line_starts;
+  uint32_t line_count;
+} line_index_T;
+
+line_index_T* line_index_init(const char* source, size_t length);
+void line_index_free(line_index_T** index);
+
+uint32_t line_index_line_count(const line_index_T* index);
+uint32_t line_index_line_start(const line_index_T* index, uint32_t line);
+
+position_T line_index_position(const line_index_T* index, uint32_t offset);
+uint32_t line_index_offset(const line_index_T* index, position_T position);
+
+position_T line_index_utf16_position(const line_index_T* index, uint32_t offset);
+uint32_t line_index_offset_from_utf16(const line_index_T* index, position_T position);
+
+#endif
@@ -11,4 +11,14 @@
 
 #define unlikely(x) __builtin_expect(!!(x), 0)
 
+#if !defined(__cplusplus) && !defined(thread_local)
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define thread_local _Thread_local
+#elif defined(_MSC_VER)
+#define thread_local __declspec(thread)
+#else
+#define thread_local __thread
+#endif
+#endif
+
 #endif
@@ -3,6 +3,7 @@
 
 #include "ast_node.h"
 #include "lexer.h"
+#include "util/hb_arena.h"
 #include "util/hb_array.h"
 
 typedef enum {
@@ -15,8 +16,18 @@ typedef enum {
 
 typedef enum { PARSER_STATE_DATA, PARSER_STATE_FOREIGN_CONTENT } parser_state_T;
 
+/**
+ * `cancel` is optional. The lexer calls it with `cancel_data` every few hundred tokens.
+ * Once it returns true the parse stops where it is: the document holds the tree up to
+ * that point, closed as if the source ended there, and has `cancelled` set. A deadline
+ * is a callback that compares against a clock. The document doesn't keep the callback,
+ * pass it to herb_analyze_parse_tree_cancellable_n() to cancel the analysis too.
+ */
 typedef struct PARSER_OPTIONS_STRUCT {
   bool track_whitespace;
+  bool use_arena;
+  herb_cancel_callback_T cancel;
+  void* cancel_data;
 } parser_options_T;
 
 extern const parser_options_T HERB_DEFAULT_PARSER_OPTIONS;
@@ -28,18 +39,19 @@ typedef struct PARSER_STRUCT {
   parser_state_T state;
   foreign_content_type_T foreign_content_type;
   parser_options_T options;
+  hb_arena_T* arena; // owns everything the parse allocates, or NULL; handed to the document, see herb_parse()
 } parser_T;
 
 size_t parser_sizeof(void);
 
-void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options);
+void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options, hb_arena_T* arena);
 
 AST_DOCUMENT_NODE_T* herb_parser_parse(parser_T* parser);
 
 void herb_parser_match_html_tags_post_analyze(AST_DOCUMENT_NODE_T* document);
 void herb_parser_deinit(parser_T* parser);
 
-void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors);
+void match_tags_in_node_array(hb_array_T* nodes, hb_array_T** errors);
 bool match_tags_visitor(const AST_NODE_T* node, void* data);
 
 #endif
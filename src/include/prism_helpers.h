@@ -3,6 +3,7 @@
 
 #include "ast_nodes.h"
 #include "errors.h"
+#include "line_index.h"
 #include "position.h"
 
 #include <prism.h>
@@ -12,7 +13,7 @@ const char* pm_error_level_to_string(pm_error_level_t level);
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error(
   const pm_diagnostic_t* error,
   const AST_NODE_T* node,
-  const char* source,
+  const line_index_T* line_index,
   pm_parser_t* parser
 );
 
@@ -0,0 +1,40 @@
+#ifndef HERB_REPARSE_H
+#define HERB_REPARSE_H
+
+#include "ast_nodes.h"
+#include "parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A single edit of a source: the bytes from `start` to `old_end` of the old source
+ * were replaced by the bytes from `start` to `new_end` of the new source.
+ */
+typedef struct HERB_EDIT_STRUCT {
+  uint32_t start;
+  uint32_t old_end;
+  uint32_t new_end;
+} herb_edit_T;
+
+herb_edit_T herb_edit_from_sources(const char* old_source, size_t old_length, const char* source, size_t length);
+
+AST_DOCUMENT_NODE_T* herb_reparse_n(
+  AST_DOCUMENT_NODE_T* document,
+  const char* old_source,
+  size_t old_length,
+  const char* source,
+  size_t length,
+  herb_edit_T edit,
+  parser_options_T* options
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,10 +7,12 @@
 #include "util/hb_string.h"
 
 token_T* token_init(hb_string_T value, token_type_T type, lexer_T* lexer);
+token_T* token_init_owned(hb_string_T value, token_type_T type, lexer_T* lexer);
 hb_string_T token_to_string(const token_T* token);
 const char* token_type_to_string(token_type_T type);
 
 token_T* token_copy(token_T* token);
+token_T* token_copy_owned(const token_T* token);
 
 void token_free(token_T* token);
 
@@ -0,0 +1,50 @@
+#ifndef HERB_TOKEN_STREAM_H
+#define HERB_TOKEN_STREAM_H
+
+#include "line_index.h"
+#include "position.h"
+#include "token_struct.h"
+#include "util/hb_string.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Columnar form of the tokens herb_lex() returns: token `i` has type `types[i]`
+ * and spans the bytes `starts[i]` to `ends[i]` of `source`.
+ *
+ * `starts`, `ends` and `types` are one allocation of `size * 9` bytes, in that
+ * order and without padding, so bindings can hand the whole stream over with a
+ * single copy.
+ *
+ * Positions aren't stored. herb_token_stream_start()/herb_token_stream_end()
+ * derive them on demand from a `line_index_T` that is built on first use, and
+ * count columns like the lexer does for `token_T.location`: one per UTF-8
+ * character, except inside TOKEN_ERB_CONTENT and TOKEN_ERROR, where every byte
+ * is a column.
+ * The stream doesn't copy `source`, which has to outlive it.
+ */
+typedef struct HERB_TOKEN_STREAM_STRUCT {
+  hb_string_T source;
+  uint32_t* starts;
+  uint32_t* ends;
+  uint8_t* types; // token_type_T
+  size_t size;
+  line_index_T* line_index;
+
+  // The last position derived, so walking the tokens of a long line stays linear.
+  size_t column_token;
+  uint32_t column_offset;
+  uint32_t column;
+} herb_token_stream_T;
+
+void herb_token_stream_init(herb_token_stream_T* stream, const char* source);
+void herb_token_stream_init_n(herb_token_stream_T* stream, const char* source, size_t length);
+void herb_token_stream_free(herb_token_stream_T* stream);
+
+token_type_T herb_token_stream_type(const herb_token_stream_T* stream, size_t index);
+hb_string_T herb_token_stream_value(const herb_token_stream_T* stream, size_t index);
+position_T herb_token_stream_start(herb_token_stream_T* stream, size_t index);
+position_T herb_token_stream_end(herb_token_stream_T* stream, size_t index);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "location.h"
 #include "range.h"
+#include "util/hb_string.h"
 
 typedef enum {
   TOKEN_WHITESPACE, // ' '
@@ -44,12 +45,13 @@ typedef enum {
   TOKEN_AMPERSAND,   // &
 
   TOKEN_CHARACTER,
+  TOKEN_TEXT, // run of text or raw text, only lexed on request of the parser (see STATE_TEXT, STATE_RAW_TEXT)
   TOKEN_ERROR,
   TOKEN_EOF,
 } token_type_T;
 
 typedef struct TOKEN_STRUCT {
-  char* value;
+  hb_string_T value; // view into the lexed source, see token_copy_owned()
   range_T range;
   location_T location;
   token_type_T type;
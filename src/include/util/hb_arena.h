@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct HB_ARENA_PAGE_STRUCT hb_arena_page_T;
 
@@ -13,15 +14,25 @@ struct HB_ARENA_PAGE_STRUCT {
   char memory[];
 };
 
+// A page overlapping the 64 KB of address space numbered `chunk`, see hb_arena_contains().
+typedef struct HB_ARENA_CHUNK_STRUCT {
+  uintptr_t chunk;
+  hb_arena_page_T* page;
+} hb_arena_chunk_T;
+
 typedef struct HB_ARENA_STRUCT {
   hb_arena_page_T* head;
   hb_arena_page_T* tail;
   size_t default_page_size;
   size_t allocation_count;
+  hb_arena_chunk_T* chunks; // hash table with linear probing, `chunk_capacity` is a power of two
+  size_t chunk_capacity;
+  size_t chunk_count;
 } hb_arena_T;
 
 bool hb_arena_init(hb_arena_T* allocator, size_t initial_size);
 void* hb_arena_alloc(hb_arena_T* allocator, size_t size);
+bool hb_arena_contains(const hb_arena_T* allocator, const void* pointer);
 size_t hb_arena_position(hb_arena_T* allocator);
 size_t hb_arena_capacity(hb_arena_T* allocator);
 void hb_arena_reset(hb_arena_T* allocator);
@@ -0,0 +1,16 @@
+#ifndef HERB_MEMORY_H
+#define HERB_MEMORY_H
+
+#include "hb_arena.h"
+
+#include <stddef.h>
+
+hb_arena_T* hb_memory_arena(void);
+hb_arena_T* hb_memory_use_arena(hb_arena_T* arena);
+
+void* hb_memory_allocate(size_t size);
+void* hb_memory_allocate_zeroed(size_t count, size_t size);
+void* hb_memory_reallocate(void* pointer, size_t old_size, size_t new_size);
+void hb_memory_free(void* pointer);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef HERB_MUTEX_H
+#define HERB_MUTEX_H
+
+// A mutex for the few places that share state between threads. HB_NO_THREADS is set for
+// builds without thread support (WebAssembly without pthreads), where locking is a no-op.
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__) && !defined(HB_NO_THREADS)
+#define HB_NO_THREADS
+#endif
+
+#if defined(HB_NO_THREADS)
+
+typedef int hb_mutex_T;
+
+#define HB_MUTEX_INITIALIZER 0
+
+static inline void hb_mutex_init(hb_mutex_T* mutex) {
+  (void) mutex;
+}
+
+static inline void hb_mutex_lock(hb_mutex_T* mutex) {
+  (void) mutex;
+}
+
+static inline void hb_mutex_unlock(hb_mutex_T* mutex) {
+  (void) mutex;
+}
+
+static inline void hb_mutex_destroy(hb_mutex_T* mutex) {
+  (void) mutex;
+}
+
+#elif defined(_WIN32)
+
+#include <windows.h>
+
+typedef SRWLOCK hb_mutex_T;
+
+#define HB_MUTEX_INITIALIZER SRWLOCK_INIT
+
+static inline void hb_mutex_init(hb_mutex_T* mutex) {
+  InitializeSRWLock(mutex);
+}
+
+static inline void hb_mutex_lock(hb_mutex_T* mutex) {
+  AcquireSRWLockExclusive(mutex);
+}
+
+static inline void hb_mutex_unlock(hb_mutex_T* mutex) {
+  ReleaseSRWLockExclusive(mutex);
+}
+
+static inline void hb_mutex_destroy(hb_mutex_T* mutex) {
+  (void) mutex;
+}
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_mutex_t hb_mutex_T;
+
+#define HB_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+static inline void hb_mutex_init(hb_mutex_T* mutex) {
+  pthread_mutex_init(mutex, NULL);
+}
+
+static inline void hb_mutex_lock(hb_mutex_T* mutex) {
+  pthread_mutex_lock(mutex);
+}
+
+static inline void hb_mutex_unlock(hb_mutex_T* mutex) {
+  pthread_mutex_unlock(mutex);
+}
+
+static inline void hb_mutex_destroy(hb_mutex_T* mutex) {
+  pthread_mutex_destroy(mutex);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HERB_SCAN_H
+#define HERB_SCAN_H
+
+#include <stddef.h>
+
+/**
+ * Finds the first byte in `data[0, length)` that equals `a`, `b`, `c` or `d`.
+ * Callers looking for fewer than four bytes repeat one of them.
+ *
+ * Compares 32 (AVX2) or 16 (SSE2) bytes at a time when the compiler targets
+ * those instruction sets, and falls back to a plain loop elsewhere.
+ *
+ * @return The offset of the first match, or `length` if there is none.
+ */
+size_t hb_scan_find_first_of(const char* data, size_t length, char a, char b, char c, char d);
+
+#endif
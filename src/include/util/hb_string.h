@@ -23,6 +23,7 @@ hb_string_T hb_string_truncate(hb_string_T string, uint32_t max_length);
 hb_string_T hb_string_range(hb_string_T string, uint32_t from, uint32_t to);
 
 char* hb_string_to_c_string_using_malloc(hb_string_T string);
+char* hb_string_to_c_string_using_hb_memory(hb_string_T string);
 
 char* hb_string_to_c_string(hb_arena_T* allocator, hb_string_T string);
 
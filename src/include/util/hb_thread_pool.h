@@ -0,0 +1,11 @@
+#ifndef HERB_THREAD_POOL_H
+#define HERB_THREAD_POOL_H
+
+#include <stddef.h>
+
+typedef void (*hb_thread_pool_task_T)(size_t index, void* data);
+
+size_t hb_thread_pool_default_size(void);
+void hb_thread_pool_run(size_t count, size_t thread_count, hb_thread_pool_task_T task, void* data);
+
+#endif
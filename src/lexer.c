@@ -1,23 +1,29 @@
+#include "include/extract.h"
+#include "include/lexer.h"
 #include "include/lexer_peek_helpers.h"
 #include "include/token.h"
 #include "include/utf8.h"
 #include "include/util.h"
 #include "include/util/hb_buffer.h"
+#include "include/util/hb_scan.h"
 #include "include/util/hb_string.h"
 
 #include <ctype.h>
+#include <stdio.h>
 #include <string.h>
 
 #define LEXER_STALL_LIMIT 5
-
-static bool lexer_eof(const lexer_T* lexer) {
-  return lexer->current_character == '\0' || lexer->stalled;
-}
+#define LEXER_CANCEL_INTERVAL 256
 
 static bool lexer_has_more_characters(const lexer_T* lexer) {
   return lexer->current_position < lexer->source.length;
 }
 
+// The end of the source is its length, not the first NUL byte, see lexer_init_n().
+static bool lexer_eof(const lexer_T* lexer) {
+  return !lexer_has_more_characters(lexer) || lexer->stalled || lexer->cancelled;
+}
+
 static bool lexer_stalled(lexer_T* lexer) {
   if (lexer->last_position == lexer->current_position) {
     lexer->stall_counter++;
@@ -33,17 +39,30 @@ static bool lexer_stalled(lexer_T* lexer) {
 
 void lexer_init(lexer_T* lexer, const char* source) {
   if (source != NULL) {
-    lexer->source = hb_string(source);
+    lexer_init_n(lexer, source, strlen(source));
   } else {
-    lexer->source = hb_string("");
+    lexer_init_n(lexer, "", 0);
+  }
+}
+
+/**
+ * Initializes `lexer` for the first `length` bytes of `source`, which doesn't need to be
+ * NUL-terminated and may contain NUL bytes. The lexer never reads past `length`.
+ */
+void lexer_init_n(lexer_T* lexer, const char* source, size_t length) {
+  if (source == NULL) {
+    source = "";
+    length = 0;
   }
 
-  lexer->current_character = lexer->source.data[0];
+  lexer->source = (hb_string_T) { .data = (char*) source, .length = (uint32_t) length };
+
   lexer->state = STATE_DATA;
 
   lexer->current_line = 1;
   lexer->current_column = 0;
   lexer->current_position = 0;
+  lexer->current_character = lexer_peek(lexer, 0);
 
   lexer->previous_line = lexer->current_line;
   lexer->previous_column = lexer->current_column;
@@ -52,12 +71,41 @@ void lexer_init(lexer_T* lexer, const char* source) {
   lexer->stall_counter = 0;
   lexer->last_position = 0;
   lexer->stalled = false;
+
+  lexer->ruby_extractor = NULL;
+  lexer->raw_text_tag_name = hb_string("");
+
+  lexer->cancel = NULL;
+  lexer->cancel_data = NULL;
+  lexer->tokens_until_cancel_check = 0;
+  lexer->cancelled = false;
+}
+
+/**
+ * Like lexer_init_n(), but starts lexing at byte `offset`, which is at `position` in `source`.
+ * Used to lex a range of a larger source with the positions the whole source would have.
+ */
+void lexer_init_at(lexer_T* lexer, const char* source, size_t length, uint32_t offset, position_T position) {
+  lexer_init_n(lexer, source, length);
+
+  if (offset > lexer->source.length) { offset = lexer->source.length; }
+
+  lexer->current_line = position.line;
+  lexer->current_column = position.column;
+  lexer->current_position = offset;
+  lexer->current_character = lexer_peek(lexer, 0);
+
+  lexer->previous_line = lexer->current_line;
+  lexer->previous_column = lexer->current_column;
+  lexer->previous_position = lexer->current_position;
+
+  lexer->last_position = offset;
 }
 
 token_T* lexer_error(lexer_T* lexer, const char* message) {
-  char error_message[128];
+  char error_message[LEXER_ERROR_MESSAGE_SIZE];
 
-  snprintf(
+  int length = snprintf(
     error_message,
     sizeof(error_message),
     "[Lexer] Error: %s (character '%c', line %u, col %u)\n",
@@ -67,7 +115,9 @@ token_T* lexer_error(lexer_T* lexer, const char* message) {
     lexer->current_column
   );
 
-  return token_init(hb_string(error_message), TOKEN_ERROR, lexer);
+  if (length < 0) { length = 0; }
+
+  return token_init_owned((hb_string_T) { .data = error_message, .length = (uint32_t) length }, TOKEN_ERROR, lexer);
 }
 
 static void lexer_advance(lexer_T* lexer) {
@@ -75,7 +125,7 @@ static void lexer_advance(lexer_T* lexer) {
     if (!is_newline(lexer->current_character)) { lexer->current_column++; }
 
     lexer->current_position++;
-    lexer->current_character = lexer->source.data[lexer->current_position];
+    lexer->current_character = lexer_peek(lexer, 0);
   }
 }
 
@@ -91,7 +141,7 @@ static void lexer_advance_utf8_bytes(lexer_T* lexer, int byte_count) {
       lexer->current_position = lexer->source.length;
       lexer->current_character = '\0';
     } else {
-      lexer->current_character = lexer->source.data[lexer->current_position];
+      lexer->current_character = lexer_peek(lexer, 0);
     }
   }
 }
@@ -102,29 +152,22 @@ static void lexer_advance_by(lexer_T* lexer, const size_t count) {
   }
 }
 
-static token_T* lexer_advance_with(lexer_T* lexer, hb_string_T value, const token_type_T type) {
-  lexer_advance_by(lexer, value.length);
-  return token_init(value, type, lexer);
-}
-
 static token_T* lexer_advance_with_next(lexer_T* lexer, size_t count, token_type_T type) {
   uint32_t start_position = lexer->current_position;
 
-  for (size_t i = 0; i < count; i++) {
-    lexer_advance(lexer);
-  }
+  lexer_advance_by(lexer, count);
 
   token_T* token = token_init(hb_string_range(lexer->source, start_position, lexer->current_position), type, lexer);
 
   return token;
 }
 
-static token_T* lexer_advance_current(lexer_T* lexer, const token_type_T type) {
-  char buffer[2];
-  buffer[0] = lexer->current_character;
-  buffer[1] = '\0';
+static token_T* lexer_advance_with(lexer_T* lexer, hb_string_T value, const token_type_T type) {
+  return lexer_advance_with_next(lexer, value.length, type);
+}
 
-  return lexer_advance_with(lexer, hb_string(buffer), type);
+static token_T* lexer_advance_current(lexer_T* lexer, const token_type_T type) {
+  return lexer_advance_with_next(lexer, 1, type);
 }
 
 static token_T* lexer_advance_utf8_character(lexer_T* lexer, const token_type_T type) {
@@ -182,6 +225,69 @@ static token_T* lexer_parse_identifier(lexer_T* lexer) {
   return token;
 }
 
+// ===== Text Parsing
+
+// Columns count characters, the same way the per-character tokens advance them: one per ASCII byte
+// and one per well-formed UTF-8 sequence.
+static uint32_t lexer_count_columns(const lexer_T* lexer, uint32_t from, uint32_t to) {
+  uint32_t columns = 0;
+
+  while (from < to) {
+    if ((unsigned char) lexer->source.data[from] < 0x80) {
+      from++;
+    } else {
+      uint32_t length = utf8_sequence_length(lexer->source.data, from, lexer->source.length);
+      from += length > 0 ? length : 1;
+    }
+
+    columns++;
+  }
+
+  return columns;
+}
+
+// Lexes the rest of a run of text as one TOKEN_TEXT, up to the next `<` for which `is_text_end` holds:
+// `lexer_peek_for_text_end` in data state, `lexer_peek_for_raw_text_end` in raw text. Only `<` and
+// newlines need a closer look, so the bytes in between are skipped with `hb_scan_find_first_of`.
+// Returns NULL if there is no text left.
+static token_T* lexer_parse_text(lexer_T* lexer, bool (*is_text_end)(const lexer_T*, uint32_t)) {
+  const char* source = lexer->source.data;
+  const uint32_t length = lexer->source.length;
+  const uint32_t start_position = lexer->current_position;
+
+  uint32_t position = start_position;
+  uint32_t column_start = start_position;
+  uint32_t column = lexer->current_column;
+
+  while (position < length) {
+    position += (uint32_t) hb_scan_find_first_of(source + position, length - position, '<', '\n', '\r', '\r');
+    if (position >= length) { break; }
+
+    if (source[position] == '<') {
+      if (is_text_end(lexer, position - start_position)) { break; }
+
+      position++;
+      continue;
+    }
+
+    if (source[position] == '\r' && position + 1 < length && source[position + 1] == '\n') { position++; }
+
+    position++;
+
+    lexer->current_line++;
+    column_start = position;
+    column = 0;
+  }
+
+  if (position == start_position) { return NULL; }
+
+  lexer->current_position = position;
+  lexer->current_column = column + lexer_count_columns(lexer, column_start, position);
+  lexer->current_character = lexer_peek(lexer, 0);
+
+  return token_init(hb_string_range(lexer->source, start_position, position), TOKEN_TEXT, lexer);
+}
+
 // ===== ERB Parsing
 
 static token_T* lexer_parse_erb_open(lexer_T* lexer) {
@@ -198,29 +304,52 @@ static token_T* lexer_parse_erb_open(lexer_T* lexer) {
   return lexer_error(lexer, "Unexpected ERB start");
 }
 
+// An ERB tag ends at `%>`, `-%>`, `=%>` or `%%>`, so the content runs up to the first `%>`, minus one
+// byte if that is preceded by one of the modifiers. Only `%` and newlines need a closer look, and
+// everything in between is skipped with `hb_scan_find_first_of`.
 static token_T* lexer_parse_erb_content(lexer_T* lexer) {
-  uint32_t start_position = lexer->current_position;
-
-  while (!lexer_peek_erb_end(lexer, 0)) {
-    if (lexer_eof(lexer)) {
-      token_T* token = token_init(
-        hb_string_range(lexer->source, start_position, lexer->current_position),
-        TOKEN_ERROR,
-        lexer
-      ); // Handle unexpected EOF
-
-      return token;
-    }
+  const char* source = lexer->source.data;
+  const uint32_t length = lexer->source.length;
+  const uint32_t start_position = lexer->current_position;
+
+  uint32_t position = start_position;
+  uint32_t line_start = start_position;
+  uint32_t column = lexer->current_column;
+  bool found_end = false;
+
+  while (position < length) {
+    position += (uint32_t) hb_scan_find_first_of(source + position, length - position, '%', '\n', '\r', '\r');
+    if (position >= length) { break; }
+
+    if (source[position] == '%') {
+      if (position + 1 < length && source[position + 1] == '>') {
+        const char modifier = position > start_position ? source[position - 1] : '\0';
+        if (modifier == '-' || modifier == '=' || modifier == '%') { position--; }
+
+        found_end = true;
+        break;
+      }
+    } else {
+      // `\r\n` is one line break, like everywhere else in the lexer and in line_index_T.
+      if (source[position] == '\r' && position + 1 < length && source[position + 1] == '\n') { position++; }
 
-    if (is_newline(lexer->current_character)) {
       lexer->current_line++;
-      lexer->current_column = 0;
-    } else {
-      lexer->current_column++;
+      line_start = position + 1;
+      column = 0;
     }
 
-    lexer->current_position++;
-    lexer->current_character = lexer->source.data[lexer->current_position];
+    position++;
+  }
+
+  if (!found_end) { position = length; }
+
+  lexer->current_position = position;
+  lexer->current_column = column + (position - line_start);
+  lexer->current_character = lexer_peek(lexer, 0);
+
+  // Handle unexpected EOF
+  if (!found_end) {
+    return token_init(hb_string_range(lexer->source, start_position, lexer->current_position), TOKEN_ERROR, lexer);
   }
 
   lexer->state = STATE_ERB_CLOSE;
@@ -243,13 +372,39 @@ static token_T* lexer_parse_erb_close(lexer_T* lexer) {
 
 // ===== Tokenizing Function
 
-token_T* lexer_next_token(lexer_T* lexer) {
+// Asks the cancel callback every LEXER_CANCEL_INTERVAL tokens, so a deadline costs a clock read
+// per interval rather than per token.
+static void lexer_poll_cancel(lexer_T* lexer) {
+  if (lexer->cancel == NULL || lexer->cancelled) { return; }
+
+  if (lexer->tokens_until_cancel_check > 0) {
+    lexer->tokens_until_cancel_check--;
+    return;
+  }
+
+  lexer->tokens_until_cancel_check = LEXER_CANCEL_INTERVAL;
+  lexer->cancelled = lexer->cancel(lexer->cancel_data);
+}
+
+static token_T* lexer_scan_token(lexer_T* lexer) {
+  lexer_poll_cancel(lexer);
+
   if (lexer_eof(lexer)) { return token_init(hb_string(""), TOKEN_EOF, lexer); }
   if (lexer_stalled(lexer)) { return lexer_error(lexer, "Lexer stalled after 5 iterations"); }
 
   if (lexer->state == STATE_ERB_CONTENT) { return lexer_parse_erb_content(lexer); }
   if (lexer->state == STATE_ERB_CLOSE) { return lexer_parse_erb_close(lexer); }
 
+  if (lexer->state == STATE_TEXT || lexer->state == STATE_RAW_TEXT) {
+    bool (*is_text_end)(const lexer_T*, uint32_t) =
+      lexer->state == STATE_TEXT ? lexer_peek_for_text_end : lexer_peek_for_raw_text_end;
+
+    lexer->state = STATE_DATA;
+
+    token_T* text = lexer_parse_text(lexer, is_text_end);
+    if (text) { return text; }
+  }
+
   if (lexer->current_character == '\r' && lexer_peek(lexer, 1) == '\n') {
     return lexer_advance_with_next(lexer, 2, TOKEN_NEWLINE);
   }
@@ -333,3 +488,11 @@ token_T* lexer_next_token(lexer_T* lexer) {
     }
   }
 }
+
+token_T* lexer_next_token(lexer_T* lexer) {
+  token_T* token = lexer_scan_token(lexer);
+
+  if (lexer->ruby_extractor != NULL) { herb_ruby_extractor_append_token(lexer->ruby_extractor, token); }
+
+  return token;
+}
@@ -12,8 +12,11 @@ char lexer_backtrack(const lexer_T* lexer, uint32_t offset) {
   return lexer->source.data[MAX(lexer->current_position - offset, 0)];
 }
 
+// Returns '\0' past the end of the source, which doesn't have to be NUL-terminated.
 char lexer_peek(const lexer_T* lexer, uint32_t offset) {
-  return lexer->source.data[MIN(lexer->current_position + offset, lexer->source.length)];
+  uint32_t position = lexer->current_position + offset;
+
+  return position < lexer->source.length ? lexer->source.data[position] : '\0';
 }
 
 bool lexer_peek_for(const lexer_T* lexer, uint32_t offset, hb_string_T pattern, const bool case_insensitive) {
@@ -75,11 +78,7 @@ bool lexer_peek_erb_end(const lexer_T* lexer, uint32_t offset) {
 }
 
 bool lexer_peek_for_token_type_after_whitespace(lexer_T* lexer, token_type_T token_type) {
-  uint32_t saved_position = lexer->current_position;
-  uint32_t saved_line = lexer->current_line;
-  uint32_t saved_column = lexer->current_column;
-  char saved_character = lexer->current_character;
-  lexer_state_T saved_state = lexer->state;
+  lexer_state_snapshot_T saved_state = lexer_save_state(lexer);
 
   token_T* token = lexer_next_token(lexer);
 
@@ -92,11 +91,8 @@ bool lexer_peek_for_token_type_after_whitespace(lexer_T* lexer, token_type_T tok
 
   if (token) { token_free(token); }
 
-  lexer->current_position = saved_position;
-  lexer->current_line = saved_line;
-  lexer->current_column = saved_column;
-  lexer->current_character = saved_character;
-  lexer->state = saved_state;
+  // Including the previous position, which the range of the next token starts at.
+  lexer_restore_state(lexer, saved_state);
 
   return result;
 }
@@ -116,6 +112,42 @@ bool lexer_peek_for_close_tag_start(const lexer_T* lexer, uint32_t offset) {
   return isalpha(c) || c == '_';
 }
 
+// Whether the `<` at `offset` starts a token that ends a run of text in data state: an ERB tag, a
+// doctype, an opening or closing tag, or a comment. Any other `<` is lexed as part of the text.
+bool lexer_peek_for_text_end(const lexer_T* lexer, uint32_t offset) {
+  if (lexer_peek(lexer, offset) != '<') { return false; }
+
+  const char next = lexer_peek(lexer, offset + 1);
+
+  return next == '%' || lexer_peek_for_doctype(lexer, offset) || isalnum(next)
+      || lexer_peek_for_html_comment_start(lexer, offset) || lexer_peek_for_close_tag_start(lexer, offset);
+}
+
+// Whether `raw_text_tag_name` is at `offset` as a whole tag name, the way it would be lexed as an
+// identifier: `script` in `</script>` or `</script-->`, but not in `</scripts>` or `</script-x>`.
+bool lexer_peek_for_raw_text_tag_name(const lexer_T* lexer, uint32_t offset) {
+  const hb_string_T tag_name = lexer->raw_text_tag_name;
+
+  if (hb_string_is_empty(tag_name) || !lexer_peek_for(lexer, offset, tag_name, false)) { return false; }
+
+  const uint32_t name_end = offset + tag_name.length;
+  const char next = lexer_peek(lexer, name_end);
+
+  if (lexer_peek_for_html_comment_end(lexer, name_end)) { return true; }
+
+  return !(isalnum(next) || next == '-' || next == '_' || next == ':');
+}
+
+// Whether the `<` at `offset` ends the raw text of a <script> or <style> element: an ERB tag, or the
+// closing tag named `raw_text_tag_name`.
+bool lexer_peek_for_raw_text_end(const lexer_T* lexer, uint32_t offset) {
+  if (lexer_peek(lexer, offset) != '<') { return false; }
+
+  const char next = lexer_peek(lexer, offset + 1);
+
+  return next == '%' || (next == '/' && lexer_peek_for_raw_text_tag_name(lexer, offset + 2));
+}
+
 lexer_state_snapshot_T lexer_save_state(lexer_T* lexer) {
   lexer_state_snapshot_T snapshot = { .position = lexer->current_position,
                                       .line = lexer->current_line,
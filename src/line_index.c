@@ -0,0 +1,182 @@
+#include "include/line_index.h"
+#include "include/position.h"
+#include "include/util/hb_memory.h"
+
+#include <string.h>
+
+static void line_index_append(line_index_T* index, uint32_t* capacity, uint32_t line_start) {
+  if (index->line_count == *capacity) {
+    uint32_t new_capacity = *capacity * 2;
+
+    index->line_starts = hb_memory_reallocate(
+      index->line_starts,
+      *capacity * sizeof(uint32_t),
+      new_capacity * sizeof(uint32_t)
+    );
+
+    *capacity = new_capacity;
+  }
+
+  index->line_starts[index->line_count++] = line_start;
+}
+
+/**
+ * Builds the line index of the first `length` bytes of `source`.
+ *
+ * Sources without `\r` are scanned with memchr(), which libc implements with
+ * vector instructions, instead of byte by byte.
+ */
+line_index_T* line_index_init(const char* source, size_t length) {
+  line_index_T* index = hb_memory_allocate(sizeof(line_index_T));
+  uint32_t capacity = 64;
+
+  index->source = source;
+  index->length = (uint32_t) length;
+  index->line_starts = hb_memory_allocate(capacity * sizeof(uint32_t));
+  index->line_count = 0;
+
+  line_index_append(index, &capacity, 0);
+
+  if (memchr(source, '\r', index->length) == NULL) {
+    const char* end = source + index->length;
+    const char* newline = source;
+
+    while ((newline = memchr(newline, '\n', (size_t) (end - newline))) != NULL) {
+      newline++;
+      line_index_append(index, &capacity, (uint32_t) (newline - source));
+    }
+
+    return index;
+  }
+
+  for (uint32_t offset = 0; offset < index->length; offset++) {
+    if (source[offset] == '\r' && offset + 1 < index->length && source[offset + 1] == '\n') { offset++; }
+
+    if (source[offset] == '\n' || source[offset] == '\r') { line_index_append(index, &capacity, offset + 1); }
+  }
+
+  return index;
+}
+
+void line_index_free(line_index_T** index) {
+  if (index == NULL || *index == NULL) { return; }
+
+  hb_memory_free((*index)->line_starts);
+  hb_memory_free(*index);
+
+  *index = NULL;
+}
+
+uint32_t line_index_line_count(const line_index_T* index) {
+  return index->line_count;
+}
+
+/**
+ * @return byte offset of the first character of `line`, clamped to the first and last line
+ */
+uint32_t line_index_line_start(const line_index_T* index, uint32_t line) {
+  if (line < 1) { line = 1; }
+  if (line > index->line_count) { line = index->line_count; }
+
+  return index->line_starts[line - 1];
+}
+
+// Byte offset of the line break (or the end of the source) that ends `line`.
+static uint32_t line_index_line_end(const line_index_T* index, uint32_t line) {
+  if (line >= index->line_count) { return index->length; }
+
+  uint32_t end = index->line_starts[line];
+
+  if (end > 0 && index->source[end - 1] == '\n') { end--; }
+  if (end > 0 && index->source[end - 1] == '\r') { end--; }
+
+  return end;
+}
+
+// 1-based line containing `offset`, found by binary search over the line starts.
+static uint32_t line_index_line_at(const line_index_T* index, uint32_t offset) {
+  uint32_t low = 0;
+  uint32_t high = index->line_count;
+
+  while (high - low > 1) {
+    uint32_t middle = low + (high - low) / 2;
+
+    if (index->line_starts[middle] <= offset) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low + 1;
+}
+
+/**
+ * @return line and byte column of `offset`, which is clamped to the end of the source
+ */
+position_T line_index_position(const line_index_T* index, uint32_t offset) {
+  if (offset > index->length) { offset = index->length; }
+
+  uint32_t line = line_index_line_at(index, offset);
+
+  return (position_T) { .line = line, .column = offset - index->line_starts[line - 1] };
+}
+
+/**
+ * @return byte offset of a line and byte column, with the column clamped to the end of its line
+ */
+uint32_t line_index_offset(const line_index_T* index, position_T position) {
+  uint32_t line = position.line < 1 ? 1 : (position.line > index->line_count ? index->line_count : position.line);
+  uint32_t start = index->line_starts[line - 1];
+  uint32_t end = line_index_line_end(index, line);
+
+  if (position.column > end - start) { return end; }
+
+  return start + position.column;
+}
+
+// Number of UTF-16 code units needed for the UTF-8 character starting with `byte`.
+static uint32_t utf16_length_of_utf8_lead_byte(unsigned char byte) {
+  if ((byte & 0xC0) == 0x80) { return 0; }
+
+  return byte >= 0xF0 ? 2 : 1;
+}
+
+/**
+ * @return line and UTF-16 column of `offset`, as used by the Language Server Protocol
+ */
+position_T line_index_utf16_position(const line_index_T* index, uint32_t offset) {
+  position_T position = line_index_position(index, offset);
+  uint32_t start = index->line_starts[position.line - 1];
+  uint32_t column = 0;
+
+  for (uint32_t i = start; i < start + position.column; i++) {
+    column += utf16_length_of_utf8_lead_byte((unsigned char) index->source[i]);
+  }
+
+  position.column = column;
+
+  return position;
+}
+
+/**
+ * @return byte offset of a line and UTF-16 column, with the column clamped to the end of its line.
+ *         A column pointing into the middle of a surrogate pair resolves to the start of that character.
+ */
+uint32_t line_index_offset_from_utf16(const line_index_T* index, position_T position) {
+  uint32_t line = position.line < 1 ? 1 : (position.line > index->line_count ? index->line_count : position.line);
+  uint32_t offset = index->line_starts[line - 1];
+  uint32_t end = line_index_line_end(index, line);
+  uint32_t column = 0;
+
+  while (offset < end) {
+    uint32_t units = utf16_length_of_utf8_lead_byte((unsigned char) index->source[offset]);
+
+    if (units > 0 && column + units > position.column) { break; }
+
+    column += units;
+    offset++;
+  }
+
+  return offset;
+}
@@ -39,7 +39,7 @@ int main(const int argc, char* argv[]) {
     printf("Herb 🌿 Powerful and seamless HTML-aware ERB parsing and tooling.\n\n");
 
     printf("./herb lex [file]      -  Lex a file\n");
-    printf("./herb parse [file]    -  Parse a file\n");
+    printf("./herb parse [file]    -  Parse a file (--arena to allocate the document from an arena)\n");
     printf("./herb ruby [file]     -  Extract Ruby from a file\n");
     printf("./herb html [file]     -  Extract HTML from a file\n");
     printf("./herb prism [file]    -  Extract Ruby from a file and parse the Ruby source with Prism\n");
@@ -80,6 +80,16 @@ int main(const int argc, char* argv[]) {
   }
 
   if (strcmp(argv[1], "lex") == 0) {
+    if (argc > 3 && strcmp(argv[3], "--silent") == 0) {
+      hb_array_T* tokens = herb_lex(source);
+      herb_free_tokens(&tokens);
+
+      free(output.value);
+      free(source);
+
+      return 0;
+    }
+
     herb_lex_to_buffer(source, &output);
     clock_gettime(CLOCK_MONOTONIC, &end);
 
@@ -93,20 +103,28 @@ int main(const int argc, char* argv[]) {
   }
 
   if (strcmp(argv[1], "parse") == 0) {
-    AST_DOCUMENT_NODE_T* root = herb_parse(source, NULL);
+    int silent = 0;
+    parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+
+    for (int i = 3; i < argc; i++) {
+      if (strcmp(argv[i], "--silent") == 0) { silent = 1; }
+      if (strcmp(argv[i], "--arena") == 0) { options.use_arena = true; }
+    }
+
+    AST_DOCUMENT_NODE_T* root = herb_parse(source, &options);
 
     herb_analyze_parse_tree(root, source);
 
     clock_gettime(CLOCK_MONOTONIC, &end);
 
-    int silent = 0;
-    if (argc > 3 && strcmp(argv[3], "--silent") == 0) { silent = 1; }
-
     if (!silent) {
       ast_pretty_print_node((AST_NODE_T*) root, 0, 0, &output);
       printf("%s\n", output.value);
 
       print_time_diff(start, end, "parsing");
+
+      analyze_cache_stats_T cache_stats = herb_analyze_cache_stats();
+      printf("ERB analysis cache: %zu hits, %zu misses\n\n", cache_stats.hits, cache_stats.misses);
     }
 
     ast_node_free((AST_NODE_T*) root);
@@ -11,6 +11,7 @@
 #include "include/util.h"
 #include "include/util/hb_array.h"
 #include "include/util/hb_buffer.h"
+#include "include/util/hb_memory.h"
 #include "include/util/hb_string.h"
 #include "include/visitor.h"
 
@@ -19,8 +20,8 @@
 #include <string.h>
 #include <strings.h>
 
-static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, hb_array_T* errors);
-static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children, hb_array_T* errors);
+static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, hb_array_T** errors);
+static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children, hb_array_T** errors);
 static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser);
 static void parser_handle_whitespace(parser_T* parser, token_T* whitespace_token, hb_array_T* children);
 static void parser_consume_whitespace(parser_T* parser, hb_array_T* children);
@@ -29,28 +30,37 @@ static bool parser_lookahead_erb_is_attribute(lexer_T* lexer);
 static void parser_handle_erb_in_open_tag(parser_T* parser, hb_array_T* children);
 static void parser_handle_whitespace_in_open_tag(parser_T* parser, hb_array_T* children);
 
-const parser_options_T HERB_DEFAULT_PARSER_OPTIONS = { .track_whitespace = false };
+const parser_options_T HERB_DEFAULT_PARSER_OPTIONS = {
+  .track_whitespace = false,
+  .use_arena = false,
+  .cancel = NULL,
+  .cancel_data = NULL,
+};
 
 size_t parser_sizeof(void) {
   return sizeof(struct PARSER_STRUCT);
 }
 
-void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options) {
+void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options, hb_arena_T* arena) {
+  lexer->cancel = options.cancel;
+  lexer->cancel_data = options.cancel_data;
+
   parser->lexer = lexer;
   parser->current_token = lexer_next_token(lexer);
   parser->open_tags_stack = hb_array_init(16);
   parser->state = PARSER_STATE_DATA;
   parser->foreign_content_type = FOREIGN_CONTENT_UNKNOWN;
   parser->options = options;
+  parser->arena = arena;
 }
 
 static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
   hb_buffer_T content;
   hb_buffer_init(&content, 128);
 
-  token_T* tag_opening = parser_consume_expected(parser, TOKEN_CDATA_START, errors);
+  token_T* tag_opening = parser_consume_expected(parser, TOKEN_CDATA_START, &errors);
   position_T start = parser->current_token->location.start;
 
   while (token_is_none_of(parser, TOKEN_CDATA_END, TOKEN_EOF)) {
@@ -63,12 +73,12 @@ static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    hb_buffer_append_string(&content, token->value);
     token_free(token);
   }
 
   parser_append_literal_node_from_buffer(parser, &content, children, start);
-  token_T* tag_closing = parser_consume_expected(parser, TOKEN_CDATA_END, errors);
+  token_T* tag_closing = parser_consume_expected(parser, TOKEN_CDATA_END, &errors);
 
   AST_CDATA_NODE_T* cdata = ast_cdata_node_init(
     tag_opening,
@@ -79,17 +89,15 @@ static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
     errors
   );
 
-  free(content.value);
-  token_free(tag_opening);
-  token_free(tag_closing);
+  hb_memory_free(content.value);
 
   return cdata;
 }
 
 static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
-  token_T* comment_start = parser_consume_expected(parser, TOKEN_HTML_COMMENT_START, errors);
+  token_T* comment_start = parser_consume_expected(parser, TOKEN_HTML_COMMENT_START, &errors);
   position_T start = parser->current_token->location.start;
 
   hb_buffer_T comment;
@@ -108,13 +116,13 @@ static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&comment, token->value);
+    hb_buffer_append_string(&comment, token->value);
     token_free(token);
   }
 
   parser_append_literal_node_from_buffer(parser, &comment, children, start);
 
-  token_T* comment_end = parser_consume_expected(parser, TOKEN_HTML_COMMENT_END, errors);
+  token_T* comment_end = parser_consume_expected(parser, TOKEN_HTML_COMMENT_END, &errors);
 
   AST_HTML_COMMENT_NODE_T* comment_node = ast_html_comment_node_init(
     comment_start,
@@ -125,20 +133,18 @@ static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
     errors
   );
 
-  free(comment.value);
-  token_free(comment_start);
-  token_free(comment_end);
+  hb_memory_free(comment.value);
 
   return comment_node;
 }
 
 static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
   hb_buffer_T content;
   hb_buffer_init(&content, 64);
 
-  token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_DOCTYPE, errors);
+  token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_DOCTYPE, &errors);
 
   position_T start = parser->current_token->location.start;
 
@@ -152,14 +158,14 @@ static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
       continue;
     }
 
-    token_T* token = parser_consume_expected(parser, parser->current_token->type, errors);
-    hb_buffer_append(&content, token->value);
+    token_T* token = parser_consume_expected(parser, parser->current_token->type, &errors);
+    hb_buffer_append_string(&content, token->value);
     token_free(token);
   }
 
   parser_append_literal_node_from_buffer(parser, &content, children, start);
 
-  token_T* tag_closing = parser_consume_expected(parser, TOKEN_HTML_TAG_END, errors);
+  token_T* tag_closing = parser_consume_expected(parser, TOKEN_HTML_TAG_END, &errors);
 
   AST_HTML_DOCTYPE_NODE_T* doctype = ast_html_doctype_node_init(
     tag_opening,
@@ -170,20 +176,18 @@ static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
     errors
   );
 
-  token_free(tag_opening);
-  token_free(tag_closing);
-  free(content.value);
+  hb_memory_free(content.value);
 
   return doctype;
 }
 
 static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
   hb_buffer_T content;
   hb_buffer_init(&content, 64);
 
-  token_T* tag_opening = parser_consume_expected(parser, TOKEN_XML_DECLARATION, errors);
+  token_T* tag_opening = parser_consume_expected(parser, TOKEN_XML_DECLARATION, &errors);
 
   position_T start = parser->current_token->location.start;
 
@@ -200,13 +204,13 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    hb_buffer_append_string(&content, token->value);
     token_free(token);
   }
 
   parser_append_literal_node_from_buffer(parser, &content, children, start);
 
-  token_T* tag_closing = parser_consume_expected(parser, TOKEN_XML_DECLARATION_END, errors);
+  token_T* tag_closing = parser_consume_expected(parser, TOKEN_XML_DECLARATION_END, &errors);
 
   AST_XML_DECLARATION_NODE_T* xml_declaration = ast_xml_declaration_node_init(
     tag_opening,
@@ -217,69 +221,35 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
     errors
   );
 
-  token_free(tag_opening);
-  token_free(tag_closing);
-  free(content.value);
+  hb_memory_free(content.value);
 
   return xml_declaration;
 }
 
-static AST_HTML_TEXT_NODE_T* parser_parse_text_content(parser_T* parser, hb_array_T* document_errors) {
+static AST_HTML_TEXT_NODE_T* parser_parse_text_content(parser_T* parser) {
   position_T start = parser->current_token->location.start;
+  uint32_t start_position = parser->current_token->range.from;
 
-  hb_buffer_T content;
-  hb_buffer_init(&content, 2048);
-
-  while (token_is_none_of(
-    parser,
-    TOKEN_HTML_TAG_START,
-    TOKEN_HTML_TAG_START_CLOSE,
-    TOKEN_HTML_DOCTYPE,
-    TOKEN_HTML_COMMENT_START,
-    TOKEN_ERB_START,
-    TOKEN_EOF
-  )) {
-    if (token_is(parser, TOKEN_ERROR)) {
-      free(content.value);
-
-      token_T* token = parser_consume_expected(parser, TOKEN_ERROR, document_errors);
-      append_unexpected_error(
-        "Token Error",
-        "not TOKEN_ERROR",
-        token->value,
-        token->location.start,
-        token->location.end,
-        document_errors
-      );
-
-      token_free(token);
-
-      return NULL;
-    }
+  // The current token only starts the text. Everything up to the next tag, comment, doctype or ERB
+  // tag belongs to this node too, so the lexer hands that over as a single TOKEN_TEXT.
+  parser->lexer->state = STATE_TEXT;
+  token_free(parser_advance(parser));
 
-    token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
-    token_free(token);
-  }
+  if (token_is(parser, TOKEN_TEXT)) { token_free(parser_advance(parser)); }
 
-  hb_array_T* errors = hb_array_init(8);
+  hb_string_T content = hb_string_range(parser->lexer->source, start_position, parser->current_token->range.from);
+  char* content_string = hb_string_to_c_string_using_hb_memory(content);
 
-  AST_HTML_TEXT_NODE_T* text_node = NULL;
+  AST_HTML_TEXT_NODE_T* text_node =
+    ast_html_text_node_init(content_string, start, parser->current_token->location.start, NULL);
 
-  if (hb_buffer_length(&content) > 0) {
-    text_node =
-      ast_html_text_node_init(hb_buffer_value(&content), start, parser->current_token->location.start, errors);
-  } else {
-    text_node = ast_html_text_node_init("", start, parser->current_token->location.start, errors);
-  }
-
-  free(content.value);
+  hb_memory_free(content_string);
 
   return text_node;
 }
 
 static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
   hb_buffer_T buffer;
   hb_buffer_init(&buffer, 128);
@@ -305,7 +275,7 @@ static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&buffer, token->value);
+    hb_buffer_append_string(&buffer, token->value);
     token_free(token);
   }
 
@@ -328,25 +298,25 @@ static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T
   AST_HTML_ATTRIBUTE_NAME_NODE_T* attribute_name =
     ast_html_attribute_name_node_init(children, node_start, node_end, errors);
 
-  free(buffer.value);
+  hb_memory_free(buffer.value);
 
   return attribute_name;
 }
 
 static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value(
   parser_T* parser,
-  hb_array_T* children,
-  hb_array_T* errors
+  hb_array_T* children
 ) {
+  hb_array_T* errors = NULL;
   hb_buffer_T buffer;
   hb_buffer_init(&buffer, 512);
-  token_T* opening_quote = parser_consume_expected(parser, TOKEN_QUOTE, errors);
+  token_T* opening_quote = parser_consume_expected(parser, TOKEN_QUOTE, &errors);
   position_T start = parser->current_token->location.start;
 
   while (!token_is(parser, TOKEN_EOF)
          && !(
            token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-           && strcmp(parser->current_token->value, opening_quote->value) == 0
+           && hb_string_equals(parser->current_token->value, opening_quote->value)
          )) {
     if (token_is(parser, TOKEN_ERB_START)) {
       parser_append_literal_node_from_buffer(parser, &buffer, children, start);
@@ -364,9 +334,9 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
       token_T* next_token = lexer_next_token(parser->lexer);
 
       if (next_token && next_token->type == TOKEN_QUOTE && opening_quote != NULL
-          && strcmp(next_token->value, opening_quote->value) == 0) {
-        hb_buffer_append(&buffer, parser->current_token->value);
-        hb_buffer_append(&buffer, next_token->value);
+          && hb_string_equals(next_token->value, opening_quote->value)) {
+        hb_buffer_append_string(&buffer, parser->current_token->value);
+        hb_buffer_append_string(&buffer, next_token->value);
 
         token_free(parser->current_token);
         token_free(next_token);
@@ -380,42 +350,46 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
       }
     }
 
-    hb_buffer_append(&buffer, parser->current_token->value);
+    hb_buffer_append_string(&buffer, parser->current_token->value);
     token_free(parser->current_token);
 
     parser->current_token = lexer_next_token(parser->lexer);
   }
 
   if (token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-      && strcmp(parser->current_token->value, opening_quote->value) == 0) {
+      && hb_string_equals(parser->current_token->value, opening_quote->value)) {
     lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
 
     token_T* potential_closing = parser->current_token;
     parser->current_token = lexer_next_token(parser->lexer);
 
     if (token_is(parser, TOKEN_IDENTIFIER) || token_is(parser, TOKEN_CHARACTER)) {
+      char* quote = hb_string_to_c_string_using_hb_memory(opening_quote->value);
+
       append_unexpected_error(
         "Unescaped quote character in attribute value",
         "escaped quote (\\') or different quote style (\")",
-        opening_quote->value,
+        quote,
         potential_closing->location.start,
         potential_closing->location.end,
-        errors
+        &errors
       );
 
+      hb_memory_free(quote);
+
       lexer_restore_state(parser->lexer, saved_state);
 
       token_free(parser->current_token);
       parser->current_token = potential_closing;
 
-      hb_buffer_append(&buffer, parser->current_token->value);
+      hb_buffer_append_string(&buffer, parser->current_token->value);
       token_free(parser->current_token);
       parser->current_token = lexer_next_token(parser->lexer);
 
       while (!token_is(parser, TOKEN_EOF)
              && !(
                token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-               && strcmp(parser->current_token->value, opening_quote->value) == 0
+               && hb_string_equals(parser->current_token->value, opening_quote->value)
              )) {
         if (token_is(parser, TOKEN_ERB_START)) {
           parser_append_literal_node_from_buffer(parser, &buffer, children, start);
@@ -427,7 +401,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
           continue;
         }
 
-        hb_buffer_append(&buffer, parser->current_token->value);
+        hb_buffer_append_string(&buffer, parser->current_token->value);
         token_free(parser->current_token);
 
         parser->current_token = lexer_next_token(parser->lexer);
@@ -441,17 +415,17 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
   }
 
   parser_append_literal_node_from_buffer(parser, &buffer, children, start);
-  free(buffer.value);
+  hb_memory_free(buffer.value);
 
-  token_T* closing_quote = parser_consume_expected(parser, TOKEN_QUOTE, errors);
+  token_T* closing_quote = parser_consume_expected(parser, TOKEN_QUOTE, &errors);
 
-  if (opening_quote != NULL && closing_quote != NULL && strcmp(opening_quote->value, closing_quote->value) != 0) {
+  if (opening_quote != NULL && closing_quote != NULL && !hb_string_equals(opening_quote->value, closing_quote->value)) {
     append_quotes_mismatch_error(
       opening_quote,
       closing_quote,
       closing_quote->location.start,
       closing_quote->location.end,
-      errors
+      &errors
     );
   }
 
@@ -465,15 +439,12 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
     errors
   );
 
-  token_free(opening_quote);
-  token_free(closing_quote);
-
   return attribute_value;
 }
 
 static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser_T* parser) {
   hb_array_T* children = hb_array_init(8);
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
 
   // <div id=<%= "home" %>>
   if (token_is(parser, TOKEN_ERB_START)) {
@@ -493,7 +464,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
 
   // <div id=home>
   if (token_is(parser, TOKEN_IDENTIFIER)) {
-    token_T* identifier = parser_consume_expected(parser, TOKEN_IDENTIFIER, errors);
+    token_T* identifier = parser_consume_expected(parser, TOKEN_IDENTIFIER, &errors);
     AST_LITERAL_NODE_T* literal = ast_literal_node_init_from_token(identifier);
     token_free(identifier);
 
@@ -511,7 +482,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
   }
 
   // <div id="home">
-  if (token_is(parser, TOKEN_QUOTE)) { return parser_parse_quoted_html_attribute_value(parser, children, errors); }
+  if (token_is(parser, TOKEN_QUOTE)) { return parser_parse_quoted_html_attribute_value(parser, children); }
 
   if (token_is(parser, TOKEN_BACKTICK)) {
     token_T* token = parser_advance(parser);
@@ -524,7 +495,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
       "backtick (`)",
       start,
       end,
-      errors
+      &errors
     );
 
     AST_HTML_ATTRIBUTE_VALUE_NODE_T* value =
@@ -541,7 +512,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
     token_type_to_string(parser->current_token->type),
     parser->current_token->location.start,
     parser->current_token->location.end,
-    errors
+    &errors
   );
 
   AST_HTML_ATTRIBUTE_VALUE_NODE_T* value = ast_html_attribute_value_node_init(
@@ -565,8 +536,6 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
                    || lexer_peek_for_token_type_after_whitespace(parser->lexer, TOKEN_EQUALS);
 
     if (has_equals) {
-      hb_buffer_T equals_buffer;
-      hb_buffer_init(&equals_buffer, 256);
       position_T equals_start = { 0 };
       position_T equals_end = { 0 };
       uint32_t range_start = 0;
@@ -582,7 +551,6 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
           range_start = whitespace->range.from;
         }
 
-        hb_buffer_append(&equals_buffer, whitespace->value);
         token_free(whitespace);
       }
 
@@ -594,27 +562,23 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
         range_start = equals->range.from;
       }
 
-      hb_buffer_append(&equals_buffer, equals->value);
       equals_end = equals->location.end;
       range_end = equals->range.to;
       token_free(equals);
 
       while (token_is_any_of(parser, TOKEN_WHITESPACE, TOKEN_NEWLINE)) {
         token_T* whitespace = parser_advance(parser);
-        hb_buffer_append(&equals_buffer, whitespace->value);
         equals_end = whitespace->location.end;
         range_end = whitespace->range.to;
         token_free(whitespace);
       }
 
-      token_T* equals_with_whitespace = calloc(1, sizeof(token_T));
+      token_T* equals_with_whitespace = hb_memory_allocate_zeroed(1, sizeof(token_T));
       equals_with_whitespace->type = TOKEN_EQUALS;
-      equals_with_whitespace->value = herb_strdup(equals_buffer.value);
+      equals_with_whitespace->value = hb_string_range(parser->lexer->source, range_start, range_end);
       equals_with_whitespace->location = (location_T) { .start = equals_start, .end = equals_end };
       equals_with_whitespace->range = (range_T) { .from = range_start, .to = range_end };
 
-      free(equals_buffer.value);
-
       AST_HTML_ATTRIBUTE_VALUE_NODE_T* attribute_value = parser_parse_html_attribute_value(parser);
 
       return ast_html_attribute_node_init(
@@ -655,8 +619,6 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
       NULL
     );
 
-    token_free(equals);
-
     return attribute_node;
   }
 
@@ -676,7 +638,7 @@ static void parser_skip_erb_content(lexer_T* lexer) {
   do {
     token = lexer_next_token(lexer);
 
-    if (token->type == TOKEN_ERB_END) {
+    if (token->type == TOKEN_ERB_END || token->type == TOKEN_EOF) {
       token_free(token);
       break;
     }
@@ -720,8 +682,7 @@ static bool parser_lookahead_erb_is_attribute(lexer_T* lexer) {
 }
 
 static void parser_handle_erb_in_open_tag(parser_T* parser, hb_array_T* children) {
-  bool is_output_tag = parser->current_token->value && strlen(parser->current_token->value) >= 3
-                    && strncmp(parser->current_token->value, "<%=", 3) == 0;
+  bool is_output_tag = hb_string_starts_with(parser->current_token->value, hb_string("<%="));
 
   if (!is_output_tag) {
     hb_array_append(children, parser_parse_erb_tag(parser));
@@ -758,11 +719,11 @@ static void parser_handle_whitespace_in_open_tag(parser_T* parser, hb_array_T* c
 }
 
 static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
 
-  token_T* tag_start = parser_consume_expected(parser, TOKEN_HTML_TAG_START, errors);
-  token_T* tag_name = parser_consume_expected(parser, TOKEN_IDENTIFIER, errors);
+  token_T* tag_start = parser_consume_expected(parser, TOKEN_HTML_TAG_START, &errors);
+  token_T* tag_name = parser_consume_expected(parser, TOKEN_IDENTIFIER, &errors);
 
   while (token_is_none_of(parser, TOKEN_HTML_TAG_END, TOKEN_HTML_TAG_SELF_CLOSE, TOKEN_EOF)) {
     if (token_is_any_of(parser, TOKEN_WHITESPACE, TOKEN_NEWLINE)) {
@@ -803,7 +764,7 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
       parser,
       "Unexpected Token",
       "TOKEN_IDENTIFIER, TOKEN_AT, TOKEN_ERB_START,TOKEN_WHITESPACE, or TOKEN_NEWLINE",
-      errors
+      &errors
     );
   }
 
@@ -812,7 +773,7 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
   token_T* tag_end = parser_consume_if_present(parser, TOKEN_HTML_TAG_END);
 
   if (tag_end == NULL) {
-    tag_end = parser_consume_expected(parser, TOKEN_HTML_TAG_SELF_CLOSE, errors);
+    tag_end = parser_consume_expected(parser, TOKEN_HTML_TAG_SELF_CLOSE, &errors);
 
     if (tag_end == NULL) {
       token_free(tag_start);
@@ -838,30 +799,26 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
     errors
   );
 
-  token_free(tag_start);
-  token_free(tag_name);
-  token_free(tag_end);
-
   return open_tag_node;
 }
 
 static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* children = hb_array_init(8);
 
-  token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_TAG_START_CLOSE, errors);
+  token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_TAG_START_CLOSE, &errors);
 
   parser_consume_whitespace(parser, children);
 
-  token_T* tag_name = parser_consume_expected(parser, TOKEN_IDENTIFIER, errors);
+  token_T* tag_name = parser_consume_expected(parser, TOKEN_IDENTIFIER, &errors);
 
   parser_consume_whitespace(parser, children);
 
-  token_T* tag_closing = parser_consume_expected(parser, TOKEN_HTML_TAG_END, errors);
+  token_T* tag_closing = parser_consume_expected(parser, TOKEN_HTML_TAG_END, &errors);
 
-  if (tag_name != NULL && is_void_element(hb_string(tag_name->value)) && parser_in_svg_context(parser) == false) {
-    hb_string_T expected = html_self_closing_tag_string(hb_string(tag_name->value));
-    hb_string_T got = html_closing_tag_string(hb_string(tag_name->value));
+  if (tag_name != NULL && is_void_element(tag_name->value) && parser_in_svg_context(parser) == false) {
+    hb_string_T expected = html_self_closing_tag_string(tag_name->value);
+    hb_string_T got = html_closing_tag_string(tag_name->value);
 
     append_void_element_closing_tag_error(
       tag_name,
@@ -869,11 +826,11 @@ static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser)
       got.data,
       tag_opening->location.start,
       tag_closing->location.end,
-      errors
+      &errors
     );
 
-    free(expected.data);
-    free(got.data);
+    hb_memory_free(expected.data);
+    hb_memory_free(got.data);
   }
 
   AST_HTML_CLOSE_TAG_NODE_T* close_tag = ast_html_close_tag_node_init(
@@ -886,10 +843,6 @@ static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser)
     errors
   );
 
-  token_free(tag_opening);
-  token_free(tag_name);
-  token_free(tag_closing);
-
   return close_tag;
 }
 
@@ -900,7 +853,7 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_self_closing_element(
 ) {
   return ast_html_element_node_init(
     open_tag,
-    open_tag->tag_name,
+    token_copy(open_tag->tag_name),
     NULL,
     NULL,
     true,
@@ -915,41 +868,41 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_regular_element(
   parser_T* parser,
   AST_HTML_OPEN_TAG_NODE_T* open_tag
 ) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   hb_array_T* body = hb_array_init(8);
 
   parser_push_open_tag(parser, open_tag->tag_name);
 
-  if (open_tag->tag_name->value && parser_is_foreign_content_tag(hb_string(open_tag->tag_name->value))) {
-    foreign_content_type_T content_type = parser_get_foreign_content_type(hb_string(open_tag->tag_name->value));
+  if (parser_is_foreign_content_tag(open_tag->tag_name->value)) {
+    foreign_content_type_T content_type = parser_get_foreign_content_type(open_tag->tag_name->value);
     parser_enter_foreign_content(parser, content_type);
-    parser_parse_foreign_content(parser, body, errors);
+    parser_parse_foreign_content(parser, body, &errors);
   } else {
-    parser_parse_in_data_state(parser, body, errors);
+    parser_parse_in_data_state(parser, body, &errors);
   }
 
-  if (!token_is(parser, TOKEN_HTML_TAG_START_CLOSE)) { return parser_handle_missing_close_tag(open_tag, body, errors); }
+  if (!token_is(parser, TOKEN_HTML_TAG_START_CLOSE)) { return parser_handle_missing_close_tag(open_tag, body, &errors); }
 
   AST_HTML_CLOSE_TAG_NODE_T* close_tag = parser_parse_html_close_tag(parser);
 
-  if (parser_in_svg_context(parser) == false && is_void_element(hb_string(close_tag->tag_name->value))) {
+  if (parser_in_svg_context(parser) == false && is_void_element(close_tag->tag_name->value)) {
     hb_array_push(body, close_tag);
-    parser_parse_in_data_state(parser, body, errors);
+    parser_parse_in_data_state(parser, body, &errors);
     close_tag = parser_parse_html_close_tag(parser);
   }
 
-  bool matches_stack = parser_check_matching_tag(parser, hb_string(close_tag->tag_name->value));
+  bool matches_stack = parser_check_matching_tag(parser, close_tag->tag_name->value);
 
   if (matches_stack) {
     token_T* popped_token = parser_pop_open_tag(parser);
     token_free(popped_token);
   } else {
-    parser_handle_mismatched_tags(parser, close_tag, errors);
+    parser_handle_mismatched_tags(parser, close_tag, &errors);
   }
 
   return ast_html_element_node_init(
     open_tag,
-    open_tag->tag_name,
+    token_copy(open_tag->tag_name),
     body,
     close_tag,
     false,
@@ -967,11 +920,11 @@ static AST_NODE_T* parser_parse_html_element(parser_T* parser) {
   if (open_tag->is_void) { return (AST_NODE_T*) parser_parse_html_self_closing_element(parser, open_tag); }
 
   // <tag>, in void element list, and not in inside an <svg> element
-  if (!open_tag->is_void && is_void_element(hb_string(open_tag->tag_name->value)) && !parser_in_svg_context(parser)) {
+  if (!open_tag->is_void && is_void_element(open_tag->tag_name->value) && !parser_in_svg_context(parser)) {
     return (AST_NODE_T*) parser_parse_html_self_closing_element(parser, open_tag);
   }
 
-  if (open_tag->tag_name->value && parser_is_foreign_content_tag(hb_string(open_tag->tag_name->value))) {
+  if (parser_is_foreign_content_tag(open_tag->tag_name->value)) {
     AST_HTML_ELEMENT_NODE_T* regular_element = parser_parse_html_regular_element(parser, open_tag);
 
     if (regular_element != NULL) { return (AST_NODE_T*) regular_element; }
@@ -981,11 +934,11 @@ static AST_NODE_T* parser_parse_html_element(parser_T* parser) {
 }
 
 static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
 
-  token_T* opening_tag = parser_consume_expected(parser, TOKEN_ERB_START, errors);
-  token_T* content = parser_consume_expected(parser, TOKEN_ERB_CONTENT, errors);
-  token_T* closing_tag = parser_consume_expected(parser, TOKEN_ERB_END, errors);
+  token_T* opening_tag = parser_consume_expected(parser, TOKEN_ERB_START, &errors);
+  token_T* content = parser_consume_expected(parser, TOKEN_ERB_CONTENT, &errors);
+  token_T* closing_tag = parser_consume_expected(parser, TOKEN_ERB_END, &errors);
 
   AST_ERB_CONTENT_NODE_T* erb_node = ast_erb_content_node_init(
     opening_tag,
@@ -999,14 +952,10 @@ static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser) {
     errors
   );
 
-  token_free(opening_tag);
-  token_free(content);
-  token_free(closing_tag);
-
   return erb_node;
 }
 
-static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children, hb_array_T* errors) {
+static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children, hb_array_T** errors) {
   hb_buffer_T content;
   hb_buffer_init(&content, 1024);
   position_T start = parser->current_token->location.start;
@@ -1014,11 +963,13 @@ static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children,
 
   if (hb_string_is_empty(expected_closing_tag)) {
     parser_exit_foreign_content(parser);
-    free(content.value);
+    hb_memory_free(content.value);
 
     return;
   }
 
+  parser->lexer->raw_text_tag_name = expected_closing_tag;
+
   while (!token_is(parser, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
       parser_append_literal_node_from_buffer(parser, &content, children, start);
@@ -1031,42 +982,30 @@ static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children,
       continue;
     }
 
-    if (token_is(parser, TOKEN_HTML_TAG_START_CLOSE)) {
-      lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
-
-      token_T* next_token = lexer_next_token(parser->lexer);
-      bool is_potential_match = false;
-
-      if (next_token && next_token->type == TOKEN_IDENTIFIER && next_token->value) {
-        is_potential_match =
-          parser_is_expected_closing_tag_name(hb_string(next_token->value), parser->foreign_content_type);
-      }
-
-      lexer_restore_state(parser->lexer, saved_state);
-
-      if (next_token) { token_free(next_token); }
-
-      if (is_potential_match) {
-        parser_append_literal_node_from_buffer(parser, &content, children, start);
-        parser_exit_foreign_content(parser);
+    // The lexer is right behind the `</`, so the tag name can be checked in the source.
+    if (token_is(parser, TOKEN_HTML_TAG_START_CLOSE) && lexer_peek_for_raw_text_tag_name(parser->lexer, 0)) {
+      parser_append_literal_node_from_buffer(parser, &content, children, start);
+      parser_exit_foreign_content(parser);
 
-        free(content.value);
+      hb_memory_free(content.value);
 
-        return;
-      }
+      return;
     }
 
+    // Everything up to the next ERB tag or closing tag is raw text, lexed as one TOKEN_TEXT.
+    parser->lexer->state = STATE_RAW_TEXT;
+
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    hb_buffer_append_string(&content, token->value);
     token_free(token);
   }
 
   parser_append_literal_node_from_buffer(parser, &content, children, start);
   parser_exit_foreign_content(parser);
-  free(content.value);
+  hb_memory_free(content.value);
 }
 
-static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, hb_array_T* errors) {
+static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, hb_array_T** errors) {
   while (token_is_not(parser, TOKEN_EOF)) {
 
     if (token_is(parser, TOKEN_ERB_START)) {
@@ -1125,7 +1064,7 @@ static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, h
           TOKEN_UNDERSCORE,
           TOKEN_WHITESPACE
         )) {
-      hb_array_append(children, parser_parse_text_content(parser, errors));
+      hb_array_append(children, parser_parse_text_content(parser));
       continue;
     }
 
@@ -1139,119 +1078,209 @@ static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, h
   }
 }
 
-static size_t find_matching_close_tag(hb_array_T* nodes, size_t start_idx, hb_string_T tag_name) {
-  int depth = 0;
+#define NO_MATCHING_TAG ((size_t) -1)
 
-  for (size_t i = start_idx + 1; i < hb_array_size(nodes); i++) {
-    AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, i);
+typedef struct {
+  hb_string_T tag_name;
+  size_t last_open_index;
+} open_tag_chain_T;
+
+static uint32_t tag_name_hash(hb_string_T tag_name) {
+  uint32_t hash = 2166136261u;
+
+  for (uint32_t i = 0; i < tag_name.length; i++) {
+    hash ^= (unsigned char) tag_name.data[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static open_tag_chain_T* find_open_tag_chain(open_tag_chain_T* chains, size_t capacity, hb_string_T tag_name) {
+  size_t slot = tag_name_hash(tag_name) & (capacity - 1);
+
+  while (chains[slot].tag_name.data != NULL && !hb_string_equals(chains[slot].tag_name, tag_name)) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+
+  if (chains[slot].tag_name.data == NULL) {
+    chains[slot].tag_name = tag_name;
+    chains[slot].last_open_index = NO_MATCHING_TAG;
+  }
+
+  return &chains[slot];
+}
+
+/**
+ * Pairs every open tag in `nodes` with the close tag of the same name that balances it,
+ * keeping one stack of unmatched open tags per tag name. Open tags with the same name
+ * nest, tags with other names are ignored, which matches the rules of the old
+ * forward scan for each open tag, but in a single pass.
+ *
+ * @return An array with the index of the matching close tag for every open tag,
+ * or NO_MATCHING_TAG, to be freed with hb_memory_free()
+ */
+static size_t* find_matching_close_tags(hb_array_T* nodes) {
+  size_t size = hb_array_size(nodes);
+  size_t* matches = hb_memory_allocate(sizeof(size_t) * size);
+  size_t* previous_open = hb_memory_allocate(sizeof(size_t) * size);
+
+  size_t capacity = 16;
+  while (capacity < size * 2) {
+    capacity *= 2;
+  }
+
+  open_tag_chain_T* chains = hb_memory_allocate_zeroed(capacity, sizeof(open_tag_chain_T));
+
+  for (size_t index = 0; index < size; index++) {
+    matches[index] = NO_MATCHING_TAG;
+
+    AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, index);
     if (node == NULL) { continue; }
 
     if (node->type == AST_HTML_OPEN_TAG_NODE) {
-      AST_HTML_OPEN_TAG_NODE_T* open = (AST_HTML_OPEN_TAG_NODE_T*) node;
+      token_T* tag_name = ((AST_HTML_OPEN_TAG_NODE_T*) node)->tag_name;
+      open_tag_chain_T* chain = find_open_tag_chain(chains, capacity, tag_name->value);
 
-      if (hb_string_equals(hb_string(open->tag_name->value), tag_name)) { depth++; }
+      previous_open[index] = chain->last_open_index;
+      chain->last_open_index = index;
     } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
-      AST_HTML_CLOSE_TAG_NODE_T* close = (AST_HTML_CLOSE_TAG_NODE_T*) node;
+      token_T* tag_name = ((AST_HTML_CLOSE_TAG_NODE_T*) node)->tag_name;
+      open_tag_chain_T* chain = find_open_tag_chain(chains, capacity, tag_name->value);
 
-      if (hb_string_equals(hb_string(close->tag_name->value), tag_name)) {
-        if (depth == 0) { return i; }
-        depth--;
+      if (chain->last_open_index != NO_MATCHING_TAG) {
+        size_t open_index = chain->last_open_index;
+
+        matches[open_index] = index;
+        chain->last_open_index = previous_open[open_index];
       }
     }
   }
 
-  return (size_t) -1;
+  hb_memory_free(chains);
+  hb_memory_free(previous_open);
+
+  return matches;
+}
+
+typedef struct {
+  hb_array_T* children;
+  size_t open_index;
+  size_t close_index;
+} element_frame_T;
+
+static AST_HTML_ELEMENT_NODE_T* element_from_frame(hb_array_T* nodes, element_frame_T* frame) {
+  AST_HTML_OPEN_TAG_NODE_T* open_tag = (AST_HTML_OPEN_TAG_NODE_T*) hb_array_get(nodes, frame->open_index);
+  AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) hb_array_get(nodes, frame->close_index);
+
+  return ast_html_element_node_init(
+    open_tag,
+    token_copy(open_tag->tag_name),
+    frame->children,
+    close_tag,
+    false,
+    ELEMENT_SOURCE_HTML,
+    open_tag->base.location.start,
+    close_tag->base.location.end,
+    NULL
+  );
 }
 
-static hb_array_T* parser_build_elements_from_tags(hb_array_T* nodes, hb_array_T* errors);
+/**
+ * Builds elements out of the open and close tags in `nodes` in a single pass.
+ *
+ * An open tag becomes an element if its matching close tag is within the element that
+ * is currently being built, everything in between becomes the element's body. Open and
+ * close tags without a counterpart stay in place and get a missing tag error.
+ */
+static hb_array_T* parser_build_elements_from_tags(hb_array_T* nodes) {
+  size_t size = hb_array_size(nodes);
+  hb_array_T* result = hb_array_init(size);
 
-static hb_array_T* parser_build_elements_from_tags(hb_array_T* nodes, hb_array_T* errors) {
-  hb_array_T* result = hb_array_init(hb_array_size(nodes));
+  size_t* matches = find_matching_close_tags(nodes);
+  hb_array_T* frames = hb_array_init(8);
 
-  for (size_t index = 0; index < hb_array_size(nodes); index++) {
+  hb_array_T* children = result;
+  size_t end_index = size;
+
+  for (size_t index = 0; index < size; index++) {
     AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, index);
-    if (node == NULL) { continue; }
 
-    if (node->type == AST_HTML_OPEN_TAG_NODE) {
-      AST_HTML_OPEN_TAG_NODE_T* open_tag = (AST_HTML_OPEN_TAG_NODE_T*) node;
-      hb_string_T tag_name = hb_string(open_tag->tag_name->value);
+    if (node != NULL) {
+      if (node->type == AST_HTML_OPEN_TAG_NODE && matches[index] < end_index) {
+        element_frame_T* frame = hb_memory_allocate(sizeof(element_frame_T));
+        frame->children = hb_array_init(8);
+        frame->open_index = index;
+        frame->close_index = matches[index];
 
-      size_t close_index = find_matching_close_tag(nodes, index, tag_name);
+        hb_array_push(frames, frame);
+
+        children = frame->children;
+        end_index = frame->close_index;
+      } else if (node->type == AST_HTML_OPEN_TAG_NODE) {
+        AST_HTML_OPEN_TAG_NODE_T* open_tag = (AST_HTML_OPEN_TAG_NODE_T*) node;
 
-      if (close_index == (size_t) -1) {
         if (hb_array_size(open_tag->base.errors) == 0) {
           append_missing_closing_tag_error(
             open_tag->tag_name,
             open_tag->base.location.start,
             open_tag->base.location.end,
-            open_tag->base.errors
+            &open_tag->base.errors
           );
         }
 
-        hb_array_append(result, node);
-      } else {
-        AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) hb_array_get(nodes, close_index);
-
-        hb_array_T* body = hb_array_init(close_index - index - 1);
-
-        for (size_t j = index + 1; j < close_index; j++) {
-          hb_array_append(body, hb_array_get(nodes, j));
+        hb_array_append(children, node);
+      } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
+        AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) node;
+
+        if (!is_void_element(close_tag->tag_name->value)) {
+          if (hb_array_size(close_tag->base.errors) == 0) {
+            append_missing_opening_tag_error(
+              close_tag->tag_name,
+              close_tag->base.location.start,
+              close_tag->base.location.end,
+              &close_tag->base.errors
+            );
+          }
         }
 
-        hb_array_T* processed_body = parser_build_elements_from_tags(body, errors);
-        hb_array_free(&body);
-
-        hb_array_T* element_errors = hb_array_init(8);
+        hb_array_append(children, node);
+      } else {
+        hb_array_append(children, node);
+      }
+    }
 
-        AST_HTML_ELEMENT_NODE_T* element = ast_html_element_node_init(
-          open_tag,
-          open_tag->tag_name,
-          processed_body,
-          close_tag,
-          false,
-          ELEMENT_SOURCE_HTML,
-          open_tag->base.location.start,
-          close_tag->base.location.end,
-          element_errors
-        );
+    while (hb_array_size(frames) > 0 && index + 1 == end_index) {
+      element_frame_T* frame = hb_array_pop(frames);
+      element_frame_T* parent = hb_array_last(frames);
 
-        hb_array_append(result, element);
+      children = parent ? parent->children : result;
+      end_index = parent ? parent->close_index : size;
 
-        index = close_index;
-      }
-    } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
-      AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) node;
-
-      if (!is_void_element(hb_string(close_tag->tag_name->value))) {
-        if (hb_array_size(close_tag->base.errors) == 0) {
-          append_missing_opening_tag_error(
-            close_tag->tag_name,
-            close_tag->base.location.start,
-            close_tag->base.location.end,
-            close_tag->base.errors
-          );
-        }
-      }
+      hb_array_append(children, element_from_frame(nodes, frame));
 
-      hb_array_append(result, node);
-    } else {
-      hb_array_append(result, node);
+      index = frame->close_index;
+      hb_memory_free(frame);
     }
   }
 
+  hb_array_free(&frames);
+  hb_memory_free(matches);
+
   return result;
 }
 
 static AST_DOCUMENT_NODE_T* parser_parse_document(parser_T* parser) {
   hb_array_T* children = hb_array_init(8);
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = NULL;
   position_T start = parser->current_token->location.start;
 
-  parser_parse_in_data_state(parser, children, errors);
+  parser_parse_in_data_state(parser, children, &errors);
 
-  token_T* eof = parser_consume_expected(parser, TOKEN_EOF, errors);
+  token_T* eof = parser_consume_expected(parser, TOKEN_EOF, &errors);
 
   AST_DOCUMENT_NODE_T* document_node = ast_document_node_init(children, start, eof->location.end, errors);
+  document_node->arena = parser->arena;
 
   token_free(eof);
 
@@ -1264,14 +1293,15 @@ AST_DOCUMENT_NODE_T* herb_parser_parse(parser_T* parser) {
 
 static void parser_handle_whitespace(parser_T* parser, token_T* whitespace_token, hb_array_T* children) {
   if (parser->options.track_whitespace) {
-    hb_array_T* errors = hb_array_init(8);
     AST_WHITESPACE_NODE_T* whitespace_node = ast_whitespace_node_init(
       whitespace_token,
       whitespace_token->location.start,
       whitespace_token->location.end,
-      errors
+      NULL
     );
     hb_array_append(children, whitespace_node);
+
+    return;
   }
 
   token_free(whitespace_token);
@@ -1296,10 +1326,10 @@ void herb_parser_deinit(parser_T* parser) {
   if (parser->open_tags_stack != NULL) { hb_array_free(&parser->open_tags_stack); }
 }
 
-void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors) {
+void match_tags_in_node_array(hb_array_T* nodes, hb_array_T** errors) {
   if (nodes == NULL || hb_array_size(nodes) == 0) { return; }
 
-  hb_array_T* processed = parser_build_elements_from_tags(nodes, errors);
+  hb_array_T* processed = parser_build_elements_from_tags(nodes);
 
   nodes->size = 0;
 
@@ -1320,5 +1350,5 @@ void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors) {
 void herb_parser_match_html_tags_post_analyze(AST_DOCUMENT_NODE_T* document) {
   if (document == NULL) { return; }
 
-  match_tags_in_node_array(document->children, document->base.errors);
+  match_tags_in_node_array(document->children, &document->base.errors);
 }
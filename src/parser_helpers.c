@@ -22,9 +22,9 @@ bool parser_check_matching_tag(const parser_T* parser, hb_string_T tag_name) {
   if (hb_array_size(parser->open_tags_stack) == 0) { return false; }
 
   token_T* top_token = hb_array_last(parser->open_tags_stack);
-  if (top_token == NULL || top_token->value == NULL) { return false; };
+  if (top_token == NULL) { return false; };
 
-  return hb_string_equals(hb_string(top_token->value), tag_name);
+  return hb_string_equals(top_token->value, tag_name);
 }
 
 token_T* parser_pop_open_tag(const parser_T* parser) {
@@ -47,10 +47,7 @@ bool parser_in_svg_context(const parser_T* parser) {
   for (size_t i = 0; i < stack_size; i++) {
     token_T* tag = (token_T*) hb_array_get(parser->open_tags_stack, i);
 
-    if (tag && tag->value) {
-      hb_string_T tag_value_string = hb_string(tag->value);
-      if (hb_string_equals(tag_value_string, hb_string("svg"))) { return true; }
-    }
+    if (tag && hb_string_equals(tag->value, hb_string("svg"))) { return true; }
   }
 
   return false;
@@ -97,7 +94,7 @@ void parser_append_unexpected_error(
   parser_T* parser,
   const char* description,
   const char* expected,
-  hb_array_T* errors
+  hb_array_T** errors
 ) {
   token_T* token = parser_advance(parser);
 
@@ -113,7 +110,7 @@ void parser_append_unexpected_error(
   token_free(token);
 }
 
-void parser_append_unexpected_token_error(parser_T* parser, token_type_T expected_type, hb_array_T* errors) {
+void parser_append_unexpected_token_error(parser_T* parser, token_type_T expected_type, hb_array_T** errors) {
   append_unexpected_token_error(
     expected_type,
     parser->current_token,
@@ -149,13 +146,13 @@ token_T* parser_consume_if_present(parser_T* parser, const token_type_T type) {
   return parser_advance(parser);
 }
 
-token_T* parser_consume_expected(parser_T* parser, const token_type_T expected_type, hb_array_T* array) {
+token_T* parser_consume_expected(parser_T* parser, const token_type_T expected_type, hb_array_T** errors) {
   token_T* token = parser_consume_if_present(parser, expected_type);
 
   if (token == NULL) {
     token = parser_advance(parser);
 
-    append_unexpected_token_error(expected_type, token, token->location.start, token->location.end, array);
+    append_unexpected_token_error(expected_type, token, token->location.start, token->location.end, errors);
   }
 
   return token;
@@ -164,7 +161,7 @@ token_T* parser_consume_expected(parser_T* parser, const token_type_T expected_t
 AST_HTML_ELEMENT_NODE_T* parser_handle_missing_close_tag(
   AST_HTML_OPEN_TAG_NODE_T* open_tag,
   hb_array_T* body,
-  hb_array_T* errors
+  hb_array_T** errors
 ) {
   append_missing_closing_tag_error(
     open_tag->tag_name,
@@ -175,21 +172,21 @@ AST_HTML_ELEMENT_NODE_T* parser_handle_missing_close_tag(
 
   return ast_html_element_node_init(
     open_tag,
-    open_tag->tag_name,
+    token_copy(open_tag->tag_name),
     body,
     NULL,
     false,
     ELEMENT_SOURCE_HTML,
     open_tag->base.location.start,
     open_tag->base.location.end,
-    errors
+    *errors
   );
 }
 
 void parser_handle_mismatched_tags(
   const parser_T* parser,
   const AST_HTML_CLOSE_TAG_NODE_T* close_tag,
-  hb_array_T* errors
+  hb_array_T** errors
 ) {
   if (hb_array_size(parser->open_tags_stack) > 0) {
     token_T* expected_tag = hb_array_last(parser->open_tags_stack);
@@ -211,11 +208,3 @@ void parser_handle_mismatched_tags(
     );
   }
 }
-
-bool parser_is_expected_closing_tag_name(hb_string_T tag_name, foreign_content_type_T expected_type) {
-  hb_string_T expected_tag_name = parser_get_foreign_content_closing_tag(expected_type);
-
-  if (hb_string_is_empty(tag_name) || hb_string_is_empty(expected_tag_name)) { return false; }
-
-  return hb_string_equals(expected_tag_name, tag_name);
-}
@@ -7,6 +7,7 @@
 #include "include/token_struct.h"
 #include "include/util.h"
 #include "include/util/hb_buffer.h"
+#include "include/util/hb_memory.h"
 #include "include/util/hb_string.h"
 
 #include <stdbool.h>
@@ -55,7 +56,7 @@ void pretty_print_quoted_property(
 ) {
   hb_string_T quoted = quoted_string(value);
   pretty_print_property(name, quoted, indent, relative_indent, last_property, buffer);
-  free(quoted.data);
+  hb_memory_free(quoted.data);
 }
 
 void pretty_print_boolean_property(
@@ -212,10 +213,10 @@ void pretty_print_token_property(
 ) {
   pretty_print_label(name, indent, relative_indent, last_property, buffer);
 
-  if (token != NULL && token->value != NULL) {
-    hb_string_T quoted = quoted_string(hb_string(token->value));
+  if (token != NULL && token->value.data != NULL) {
+    hb_string_T quoted = quoted_string(token->value);
     hb_buffer_append_string(buffer, quoted);
-    free(quoted.data);
+    hb_memory_free(quoted.data);
 
     hb_buffer_append(buffer, " ");
     pretty_print_location(token->location, buffer);
@@ -247,7 +248,7 @@ void pretty_print_string_property(
   pretty_print_property(name, value, indent, relative_indent, last_property, buffer);
 
   if (!hb_string_is_empty(string)) {
-    if (!hb_string_is_empty(escaped)) { free(escaped.data); }
-    if (!hb_string_is_empty(quoted)) { free(quoted.data); }
+    if (!hb_string_is_empty(escaped)) { hb_memory_free(escaped.data); }
+    if (!hb_string_is_empty(quoted)) { hb_memory_free(quoted.data); }
   }
 }
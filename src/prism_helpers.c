@@ -1,6 +1,7 @@
 #include "include/prism_helpers.h"
 #include "include/ast_nodes.h"
 #include "include/errors.h"
+#include "include/line_index.h"
 #include "include/position.h"
 #include "include/util.h"
 
@@ -19,14 +20,14 @@ const char* pm_error_level_to_string(pm_error_level_t level) {
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error(
   const pm_diagnostic_t* error,
   const AST_NODE_T* node,
-  const char* source,
+  const line_index_T* line_index,
   pm_parser_t* parser
 ) {
   size_t start_offset = (size_t) (error->location.start - parser->start);
   size_t end_offset = (size_t) (error->location.end - parser->start);
 
-  position_T start = position_from_source_with_offset(source, start_offset);
-  position_T end = position_from_source_with_offset(source, end_offset);
+  position_T start = line_index_position(line_index, (uint32_t) start_offset);
+  position_T end = line_index_position(line_index, (uint32_t) end_offset);
 
   return ruby_parse_error_init(
     error->message,
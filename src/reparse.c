@@ -0,0 +1,346 @@
+#include "include/reparse.h"
+#include "include/analyze.h"
+#include "include/ast_node.h"
+#include "include/ast_nodes.h"
+#include "include/herb.h"
+#include "include/lexer.h"
+#include "include/parser.h"
+#include "include/util/hb_array.h"
+#include "include/util/hb_memory.h"
+#include "include/visitor.h"
+
+#include <prism.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t from;
+  uint32_t to;
+  bool has_tokens;
+  bool has_errors;
+} reparse_span_T;
+
+// Moves what follows the reparsed range: positions at or after `start` by `line_delta`
+// lines (and by `column_delta` columns on `start.line`), offsets at or after `offset`
+// by `offset_delta` bytes. Token values are moved from `old_source` into `source`.
+typedef struct {
+  const char* old_source;
+  size_t old_length;
+  const char* source;
+  uint32_t offset;
+  int64_t offset_delta;
+  position_T start;
+  int64_t line_delta;
+  int64_t column_delta;
+} reparse_shift_T;
+
+/**
+ * @return the edit that turns `old_source` into `source`, spanning everything
+ *         between their common prefix and their common suffix.
+ */
+herb_edit_T herb_edit_from_sources(const char* old_source, size_t old_length, const char* source, size_t length) {
+  size_t prefix = 0;
+  size_t shortest = old_length < length ? old_length : length;
+
+  while (prefix < shortest && old_source[prefix] == source[prefix]) {
+    prefix++;
+  }
+
+  size_t suffix = 0;
+
+  while (suffix < shortest - prefix && old_source[old_length - suffix - 1] == source[length - suffix - 1]) {
+    suffix++;
+  }
+
+  return (herb_edit_T) {
+    .start = (uint32_t) prefix,
+    .old_end = (uint32_t) (old_length - suffix),
+    .new_end = (uint32_t) (length - suffix),
+  };
+}
+
+static AST_DOCUMENT_NODE_T* herb_reparse_fully(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t length,
+  parser_options_T* options
+) {
+  ast_node_free((AST_NODE_T*) document);
+
+  herb_cancel_callback_T cancel = options != NULL ? options->cancel : NULL;
+  void* cancel_data = options != NULL ? options->cancel_data : NULL;
+
+  AST_DOCUMENT_NODE_T* reparsed = herb_parse_n(source, length, options);
+  herb_analyze_parse_tree_cancellable_n(reparsed, source, length, cancel, cancel_data);
+
+  return reparsed;
+}
+
+static void reparse_span_visit_token(token_T* token, void* data) {
+  reparse_span_T* span = (reparse_span_T*) data;
+
+  if (!span->has_tokens || token->range.from < span->from) { span->from = token->range.from; }
+  if (!span->has_tokens || token->range.to > span->to) { span->to = token->range.to; }
+
+  span->has_tokens = true;
+}
+
+static bool reparse_span_visit_node(const AST_NODE_T* node, void* data) {
+  reparse_span_T* span = (reparse_span_T*) data;
+
+  if (hb_array_size(node->errors) > 0) { span->has_errors = true; }
+
+  herb_visit_node_tokens(node, reparse_span_visit_token, data);
+
+  return true;
+}
+
+static void reparse_shift_position(position_T* position, const reparse_shift_T* shift) {
+  if (position->line < shift->start.line) { return; }
+  if (position->line == shift->start.line && position->column < shift->start.column) { return; }
+
+  if (position->line == shift->start.line) { position->column = (uint32_t) (position->column + shift->column_delta); }
+
+  position->line = (uint32_t) (position->line + shift->line_delta);
+}
+
+static void reparse_shift_token(token_T* token, void* data) {
+  const reparse_shift_T* shift = (const reparse_shift_T*) data;
+
+  // Error messages and synthesized tokens don't point into the source.
+  if (token->value.data >= shift->old_source && token->value.data <= shift->old_source + shift->old_length) {
+    int64_t offset = token->value.data - shift->old_source;
+    if (offset >= shift->offset) { offset += shift->offset_delta; }
+
+    token->value.data = (char*) shift->source + offset;
+  }
+
+  if (token->range.from >= shift->offset) { token->range.from = (uint32_t) (token->range.from + shift->offset_delta); }
+  if (token->range.to >= shift->offset) { token->range.to = (uint32_t) (token->range.to + shift->offset_delta); }
+
+  reparse_shift_position(&token->location.start, shift);
+  reparse_shift_position(&token->location.end, shift);
+}
+
+static bool reparse_shift_node(const AST_NODE_T* node, void* data) {
+  AST_NODE_T* shifted = (AST_NODE_T*) node;
+
+  reparse_shift_position(&shifted->location.start, data);
+  reparse_shift_position(&shifted->location.end, data);
+
+  herb_visit_node_tokens(node, reparse_shift_token, data);
+
+  return true;
+}
+
+// Whether `region` or anything in it has an error. The reparsed range is only
+// spliced in when it parses cleanly on its own.
+static bool reparse_region_has_errors(AST_DOCUMENT_NODE_T* region) {
+  reparse_span_T span = { 0 };
+  herb_visit_node((AST_NODE_T*) region, reparse_span_visit_node, &span);
+
+  return span.has_errors;
+}
+
+// Whether the Ruby projection of the edited document has a syntax error. A full
+// parse would attach those to the document, so they rule out reusing the old tree.
+static bool reparse_ruby_has_errors(const char* extracted_ruby, size_t length) {
+  pm_parser_t parser;
+  pm_options_t options = { 0, .partial_script = true };
+  pm_parser_init(&parser, (const uint8_t*) extracted_ruby, length, &options);
+
+  pm_node_t* root = pm_parse(&parser);
+  bool has_errors = parser.error_list.size > 0;
+
+  pm_node_destroy(&parser, root);
+  pm_parser_free(&parser);
+  pm_options_free(&options);
+
+  return has_errors;
+}
+
+static bool reparse_is_text(const AST_NODE_T* node) {
+  return node->type == AST_HTML_TEXT_NODE;
+}
+
+/**
+ * Returns the document for `source`, which is `old_source` with `edit` applied, reusing
+ * the top-level nodes of `document` that the edit doesn't touch. Only the nodes around
+ * the edit are parsed again, and only their ERB tags are analyzed again.
+ *
+ * `document` is consumed: it is either updated in place and returned, or freed. It must
+ * come from herb_parse_n() and herb_analyze_parse_tree_n() on `old_source`, or from an
+ * earlier herb_reparse_n(), with the same `options`. Its tokens are moved over to `source`,
+ * so `old_source` may be released afterwards.
+ *
+ * Reusing nodes is only safe when nothing in the old tree or the reparsed range has an
+ * error, since errors can span top-level nodes. Otherwise, and for arena-backed documents,
+ * the whole source is parsed again. Either way the result matches herb_parse_n() followed
+ * by herb_analyze_parse_tree_n().
+ */
+AST_DOCUMENT_NODE_T* herb_reparse_n(
+  AST_DOCUMENT_NODE_T* document,
+  const char* old_source,
+  size_t old_length,
+  const char* source,
+  size_t length,
+  herb_edit_T edit,
+  parser_options_T* options
+) {
+  parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  if (options != NULL) { parser_options = *options; }
+
+  if (document == NULL || document->arena != NULL || parser_options.use_arena || document->cancelled
+      || document->extracted_ruby == NULL || hb_array_size(document->base.errors) > 0) {
+    return herb_reparse_fully(document, source, length, options);
+  }
+
+  if (edit.start > edit.old_end || edit.old_end > old_length || edit.start > edit.new_end || edit.new_end > length
+      || old_length - edit.old_end != length - edit.new_end) {
+    return herb_reparse_fully(document, source, length, options);
+  }
+
+  size_t count = hb_array_size(document->children);
+  if (count == 0) { return herb_reparse_fully(document, source, length, options); }
+
+  // Top-level nodes are back to back, so each one starts where the previous one ends.
+  // Text nodes have no tokens, but they are never next to each other.
+  reparse_span_T* spans = hb_memory_allocate_zeroed(count, sizeof(reparse_span_T));
+  bool reusable = true;
+
+  for (size_t i = 0; i < count; i++) {
+    herb_visit_node(hb_array_get(document->children, i), reparse_span_visit_node, &spans[i]);
+    if (spans[i].has_errors) { reusable = false; }
+  }
+
+  uint32_t* starts = hb_memory_allocate_zeroed(count + 1, sizeof(uint32_t));
+  starts[count] = (uint32_t) old_length;
+
+  for (size_t i = 1; i < count && reusable; i++) {
+    if (spans[i].has_tokens) {
+      starts[i] = spans[i].from;
+    } else if (spans[i - 1].has_tokens) {
+      starts[i] = spans[i - 1].to;
+    } else {
+      reusable = false;
+    }
+
+    if (starts[i] < starts[i - 1]) { reusable = false; }
+  }
+
+  hb_memory_free(spans);
+
+  if (!reusable) {
+    hb_memory_free(starts);
+    return herb_reparse_fully(document, source, length, options);
+  }
+
+  // The damaged nodes overlap or touch the edit. A text node next to them is reparsed
+  // too, since a full parse would merge it with text at the edge of the range.
+  size_t first = 0;
+  while (first + 1 < count && starts[first + 1] < edit.start) {
+    first++;
+  }
+
+  size_t last = first;
+  while (last + 1 < count && starts[last + 1] <= edit.old_end) {
+    last++;
+  }
+
+  if (first > 0 && reparse_is_text(hb_array_get(document->children, first - 1))) { first--; }
+  if (last + 1 < count && reparse_is_text(hb_array_get(document->children, last + 1))) { last++; }
+
+  int64_t offset_delta = (int64_t) edit.new_end - (int64_t) edit.old_end;
+  uint32_t region_start = starts[first];
+  uint32_t region_old_end = starts[last + 1];
+  uint32_t region_end = (uint32_t) (region_old_end + offset_delta);
+
+  hb_memory_free(starts);
+
+  AST_NODE_T* first_damaged = hb_array_get(document->children, first);
+  position_T region_old_end_position = last + 1 < count
+                                       ? ((AST_NODE_T*) hb_array_get(document->children, last + 1))->location.start
+                                       : document->base.location.end;
+
+  lexer_T lexer = { 0 };
+  lexer_init_at(&lexer, source, region_end, region_start, first_damaged->location.start);
+
+  parser_T parser = { 0 };
+  herb_parser_init(&parser, &lexer, parser_options, NULL);
+
+  AST_DOCUMENT_NODE_T* region = herb_parser_parse(&parser);
+  herb_parser_deinit(&parser);
+
+  region->cancelled = lexer.cancelled;
+
+  // The range is analyzed as a document of its own, which leaves its Ruby projection on `region`.
+  herb_analyze_parse_tree_cancellable_n(
+    region,
+    source + region_start,
+    region_end - region_start,
+    parser_options.cancel,
+    parser_options.cancel_data
+  );
+
+  if (region->cancelled || region->extracted_ruby == NULL || reparse_region_has_errors(region)) {
+    ast_node_free((AST_NODE_T*) region);
+    return herb_reparse_fully(document, source, length, options);
+  }
+
+  char* extracted_ruby = hb_memory_allocate(length + 1);
+
+  memcpy(extracted_ruby, document->extracted_ruby, region_start);
+  memcpy(extracted_ruby + region_start, region->extracted_ruby, region_end - region_start);
+  memcpy(extracted_ruby + region_end, document->extracted_ruby + region_old_end, old_length - region_old_end);
+  extracted_ruby[length] = '\0';
+
+  if (reparse_ruby_has_errors(extracted_ruby, length)) {
+    hb_memory_free(extracted_ruby);
+    ast_node_free((AST_NODE_T*) region);
+    return herb_reparse_fully(document, source, length, options);
+  }
+
+  reparse_shift_T shift = {
+    .old_source = old_source,
+    .old_length = old_length,
+    .source = source,
+    .offset = region_old_end,
+    .offset_delta = offset_delta,
+    .start = region_old_end_position,
+    .line_delta = (int64_t) region->base.location.end.line - region_old_end_position.line,
+    .column_delta = (int64_t) region->base.location.end.column - region_old_end_position.column,
+  };
+
+  hb_array_T* children = hb_array_init(count - (last - first + 1) + hb_array_size(region->children));
+
+  for (size_t i = 0; i < count; i++) {
+    AST_NODE_T* child = hb_array_get(document->children, i);
+
+    if (i == first) {
+      for (size_t j = 0; j < hb_array_size(region->children); j++) {
+        hb_array_append(children, hb_array_get(region->children, j));
+      }
+    }
+
+    if (i >= first && i <= last) {
+      ast_node_free(child);
+      continue;
+    }
+
+    herb_visit_node(child, reparse_shift_node, &shift);
+    hb_array_append(children, child);
+  }
+
+  hb_array_free(&document->children);
+  document->children = children;
+
+  reparse_shift_position(&document->base.location.end, &shift);
+
+  hb_memory_free(document->extracted_ruby);
+  document->extracted_ruby = extracted_ruby;
+
+  // The region's children moved into `document`, only its own node is left to free.
+  hb_array_free(&region->children);
+  ast_node_free((AST_NODE_T*) region);
+
+  return document;
+}
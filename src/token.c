@@ -4,21 +4,20 @@
 #include "include/range.h"
 #include "include/token_struct.h"
 #include "include/util.h"
+#include "include/util/hb_memory.h"
 
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-token_T* token_init(hb_string_T value, const token_type_T type, lexer_T* lexer) {
-  token_T* token = calloc(1, sizeof(token_T));
-
+static token_T* token_fill(token_T* token, hb_string_T value, const token_type_T type, lexer_T* lexer) {
   if (type == TOKEN_NEWLINE) {
     lexer->current_line++;
     lexer->current_column = 0;
   }
 
-  token->value = hb_string_to_c_string_using_malloc(value);
+  token->value = value;
 
   token->type = type;
   token->range = (range_T) { .from = lexer->previous_position, .to = lexer->current_position };
@@ -38,6 +37,36 @@ token_T* token_init(hb_string_T value, const token_type_T type, lexer_T* lexer)
   return token;
 }
 
+token_T* token_init(hb_string_T value, const token_type_T type, lexer_T* lexer) {
+  token_T* token = lexer->token_slot != NULL ? lexer->token_slot : hb_memory_allocate_zeroed(1, sizeof(token_T));
+
+  return token_fill(token, value, type, lexer);
+}
+
+/**
+ * Like token_init(), for a value that doesn't point into the source, like a lexer
+ * error message. The value is copied into the token's own allocation (see
+ * token_copy_owned()), or into `lexer->error_message` when the lexer reuses one
+ * token slot, so it stays valid as long as the token does. Longer values are cut
+ * off at LEXER_ERROR_MESSAGE_SIZE - 1 bytes.
+ */
+token_T* token_init_owned(hb_string_T value, const token_type_T type, lexer_T* lexer) {
+  if (value.length >= LEXER_ERROR_MESSAGE_SIZE) { value.length = LEXER_ERROR_MESSAGE_SIZE - 1; }
+
+  token_T* token = lexer->token_slot;
+  char* data = lexer->error_message;
+
+  if (token == NULL) {
+    token = hb_memory_allocate_zeroed(1, sizeof(token_T) + value.length + 1);
+    data = (char*) (token + 1);
+  }
+
+  if (!hb_string_is_empty(value)) { memmove(data, value.data, value.length); }
+  data[value.length] = '\0';
+
+  return token_fill(token, (hb_string_T) { .data = data, .length = value.length }, type, lexer);
+}
+
 const char* token_type_to_string(const token_type_T type) {
   switch (type) {
     case TOKEN_WHITESPACE: return "TOKEN_WHITESPACE";
@@ -73,6 +102,7 @@ const char* token_type_to_string(const token_type_T type) {
     case TOKEN_ERB_CONTENT: return "TOKEN_ERB_CONTENT";
     case TOKEN_ERB_END: return "TOKEN_ERB_END";
     case TOKEN_CHARACTER: return "TOKEN_CHARACTER";
+    case TOKEN_TEXT: return "TOKEN_TEXT";
     case TOKEN_ERROR: return "TOKEN_ERROR";
     case TOKEN_EOF: return "TOKEN_EOF";
   }
@@ -84,15 +114,16 @@ hb_string_T token_to_string(const token_T* token) {
   const char* type_string = token_type_to_string(token->type);
   const char* template = "#<Herb::Token type=\"%s\" value=\"%.*s\" range=[%u, %u] start=(%u:%u) end=(%u:%u)>";
 
-  char* string = calloc(strlen(type_string) + strlen(template) + strlen(token->value) + 16, sizeof(char));
   hb_string_T escaped;
 
   if (token->type == TOKEN_EOF) {
     escaped = hb_string(herb_strdup("<EOF>"));
   } else {
-    escaped = escape_newlines(hb_string(token->value));
+    escaped = escape_newlines(token->value);
   }
 
+  char* string = hb_memory_allocate_zeroed(strlen(type_string) + strlen(template) + escaped.length + 16, sizeof(char));
+
   sprintf(
     string,
     template,
@@ -107,7 +138,7 @@ hb_string_T token_to_string(const token_T* token) {
     token->location.end.column
   );
 
-  free(escaped.data);
+  hb_memory_free(escaped.data);
 
   return hb_string(string);
 }
@@ -115,36 +146,48 @@ hb_string_T token_to_string(const token_T* token) {
 token_T* token_copy(token_T* token) {
   if (!token) { return NULL; }
 
-  token_T* new_token = calloc(1, sizeof(token_T));
+  // the value of an error token may live in the token's own allocation, see token_init_owned()
+  if (token->type == TOKEN_ERROR) { return token_copy_owned(token); }
+
+  token_T* new_token = hb_memory_allocate(sizeof(token_T));
+
+  if (!new_token) { return NULL; }
+
+  *new_token = *token;
+
+  return new_token;
+}
+
+/**
+ * Copies a token together with its value, so the copy stays valid after the
+ * source it was lexed from has been freed. The value is stored in the same
+ * allocation as the token, so the copy is released with token_free() as usual.
+ */
+token_T* token_copy_owned(const token_T* token) {
+  if (!token) { return NULL; }
+
+  token_T* new_token = hb_memory_allocate(sizeof(token_T) + token->value.length + 1);
 
   if (!new_token) { return NULL; }
 
-  if (token->value) {
-    new_token->value = herb_strdup(token->value);
+  *new_token = *token;
 
-    if (!new_token->value) {
-      free(new_token);
-      return NULL;
-    }
-  } else {
-    new_token->value = NULL;
-  }
+  char* value = (char*) (new_token + 1);
+
+  if (!hb_string_is_empty(token->value)) { memcpy(value, token->value.data, token->value.length); }
 
-  new_token->type = token->type;
-  new_token->range = token->range;
-  new_token->location = token->location;
+  value[token->value.length] = '\0';
+  new_token->value = (hb_string_T) { .data = value, .length = token->value.length };
 
   return new_token;
 }
 
 bool token_value_empty(const token_T* token) {
-  return token == NULL || token->value == NULL || token->value[0] == '\0';
+  return token == NULL || hb_string_is_empty(token->value);
 }
 
 void token_free(token_T* token) {
   if (!token) { return; }
 
-  if (token->value != NULL) { free(token->value); }
-
-  free(token);
+  hb_memory_free(token);
 }
@@ -0,0 +1,164 @@
+#include "include/token_stream.h"
+#include "include/herb.h"
+#include "include/line_index.h"
+#include "include/utf8.h"
+#include "include/util/hb_memory.h"
+
+#include <string.h>
+
+#define TOKEN_STREAM_BYTES_PER_TOKEN (2 * sizeof(uint32_t) + sizeof(uint8_t))
+
+// Moves the columns into one block of `capacity` tokens. Called to grow the stream while lexing and
+// once at the end with `capacity == size`, which leaves the columns back to back.
+static void herb_token_stream_resize(herb_token_stream_T* stream, size_t capacity) {
+  char* block = hb_memory_allocate(capacity * TOKEN_STREAM_BYTES_PER_TOKEN);
+
+  uint32_t* starts = (uint32_t*) block;
+  uint32_t* ends = starts + capacity;
+  uint8_t* types = (uint8_t*) (ends + capacity);
+
+  if (stream->size > 0) {
+    memcpy(starts, stream->starts, stream->size * sizeof(uint32_t));
+    memcpy(ends, stream->ends, stream->size * sizeof(uint32_t));
+    memcpy(types, stream->types, stream->size * sizeof(uint8_t));
+  }
+
+  hb_memory_free(stream->starts);
+
+  stream->starts = starts;
+  stream->ends = ends;
+  stream->types = types;
+}
+
+/**
+ * Lexes `source` into `stream`, which must be released with herb_token_stream_free().
+ * The tokens are the same as herb_lex() returns, ending with TOKEN_EOF.
+ */
+void herb_token_stream_init(herb_token_stream_T* stream, const char* source) {
+  if (!source) { source = ""; }
+
+  herb_token_stream_init_n(stream, source, strlen(source));
+}
+
+void herb_token_stream_init_n(herb_token_stream_T* stream, const char* source, size_t length) {
+  *stream = (herb_token_stream_T) { .source = { .data = (char*) source, .length = (uint32_t) length } };
+
+  // Most tokens of a template are a few bytes long.
+  size_t capacity = stream->source.length / 4 + 16;
+  herb_token_stream_resize(stream, capacity);
+
+  herb_lexer_T lexer;
+  herb_lexer_init_n(&lexer, source, length);
+
+  const token_T* token = NULL;
+
+  while ((token = herb_lexer_next(&lexer)) != NULL) {
+    if (stream->size == capacity) {
+      capacity *= 2;
+      herb_token_stream_resize(stream, capacity);
+    }
+
+    stream->starts[stream->size] = token->range.from;
+    stream->ends[stream->size] = token->range.to;
+    stream->types[stream->size] = (uint8_t) token->type;
+    stream->size++;
+  }
+
+  herb_token_stream_resize(stream, stream->size);
+}
+
+void herb_token_stream_free(herb_token_stream_T* stream) {
+  if (!stream) { return; }
+
+  hb_memory_free(stream->starts);
+  line_index_free(&stream->line_index);
+
+  stream->starts = NULL;
+  stream->ends = NULL;
+  stream->types = NULL;
+  stream->size = 0;
+}
+
+token_type_T herb_token_stream_type(const herb_token_stream_T* stream, size_t index) {
+  return (token_type_T) stream->types[index];
+}
+
+/**
+ * @return the source bytes of token `index`. Unlike `token_T.value`, this is the
+ *         source text for TOKEN_ERROR too, not the error message.
+ */
+hb_string_T herb_token_stream_value(const herb_token_stream_T* stream, size_t index) {
+  return hb_string_range(stream->source, stream->starts[index], stream->ends[index]);
+}
+
+static const line_index_T* herb_token_stream_line_index(herb_token_stream_T* stream) {
+  if (stream->line_index == NULL) {
+    stream->line_index = line_index_init(stream->source.data, stream->source.length);
+  }
+
+  return stream->line_index;
+}
+
+// Counts the columns between `line_start` and `offset`, which lies within token `index`, the way the
+// lexer does: UTF-8 characters, but bytes inside TOKEN_ERB_CONTENT and TOKEN_ERROR (the content of an
+// unterminated ERB tag). Continues from the previous call when that one ended earlier on the same line.
+static uint32_t herb_token_stream_column(
+  herb_token_stream_T* stream,
+  size_t index,
+  uint32_t line_start,
+  uint32_t offset
+) {
+  size_t token = index;
+  uint32_t position = line_start;
+  uint32_t column = 0;
+
+  if (stream->column_offset >= line_start && stream->column_offset <= offset && stream->column_token <= index) {
+    token = stream->column_token;
+    position = stream->column_offset;
+    column = stream->column;
+  } else {
+    while (token > 0 && stream->starts[token] > line_start) {
+      token--;
+    }
+  }
+
+  while (position < offset) {
+    while (stream->ends[token] <= position) {
+      token++;
+    }
+
+    uint32_t stop = stream->ends[token] < offset ? stream->ends[token] : offset;
+
+    if (stream->types[token] == TOKEN_ERB_CONTENT || stream->types[token] == TOKEN_ERROR) {
+      column += stop - position;
+      position = stop;
+      continue;
+    }
+
+    while (position < stop) {
+      position += utf8_sequence_length(stream->source.data, position, stream->source.length);
+      column++;
+    }
+  }
+
+  stream->column_token = token;
+  stream->column_offset = position;
+  stream->column = column;
+
+  return column;
+}
+
+static position_T herb_token_stream_position(herb_token_stream_T* stream, size_t index, uint32_t offset) {
+  position_T position = line_index_position(herb_token_stream_line_index(stream), offset);
+  position.column = herb_token_stream_column(stream, index, offset - position.column, offset);
+
+  return position;
+}
+
+position_T herb_token_stream_start(herb_token_stream_T* stream, size_t index) {
+  return herb_token_stream_position(stream, index, stream->starts[index]);
+}
+
+position_T herb_token_stream_end(herb_token_stream_T* stream, size_t index) {
+  return herb_token_stream_position(stream, index, stream->ends[index]);
+}
@@ -1,5 +1,6 @@
 #include "include/util.h"
 #include "include/util/hb_buffer.h"
+#include "include/util/hb_memory.h"
 #include "include/util/hb_string.h"
 
 #include <stdio.h>
@@ -52,7 +53,7 @@ hb_string_T quoted_string(hb_string_T input) {
 
 char* herb_strdup(const char* s) {
   size_t len = strlen(s) + 1;
-  char* copy = malloc(len);
+  char* copy = hb_memory_allocate(len);
 
   if (copy) { memcpy(copy, s, len); }
 
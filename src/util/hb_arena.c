@@ -5,8 +5,11 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#define HB_ARENA_CHUNK_SHIFT 16
+
 #define hb_arena_for_each_page(allocator, page)                                                                        \
   for (hb_arena_page_T* page = (allocator)->head; page != NULL; page = page->next)
 
@@ -42,6 +45,54 @@ static inline void hb_arena_reset_pages_after(hb_arena_page_T* start_page) {
   }
 }
 
+static inline size_t hb_arena_chunk_slot(uintptr_t chunk, size_t capacity) {
+  return (size_t) (((uint64_t) chunk * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+static void hb_arena_chunks_insert(hb_arena_chunk_T* chunks, size_t capacity, uintptr_t chunk, hb_arena_page_T* page) {
+  size_t slot = hb_arena_chunk_slot(chunk, capacity);
+
+  while (chunks[slot].page != NULL) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+
+  chunks[slot] = (hb_arena_chunk_T) { .chunk = chunk, .page = page };
+}
+
+// Records every chunk `page` overlaps, growing the table to stay at most half full.
+static bool hb_arena_index_page(hb_arena_T* allocator, hb_arena_page_T* page) {
+  const uintptr_t first = (uintptr_t) page->memory >> HB_ARENA_CHUNK_SHIFT;
+  const uintptr_t last = ((uintptr_t) page->memory + page->capacity - 1) >> HB_ARENA_CHUNK_SHIFT;
+  const size_t required = allocator->chunk_count + (size_t) (last - first + 1);
+
+  if (required * 2 > allocator->chunk_capacity) {
+    size_t capacity = allocator->chunk_capacity > 0 ? allocator->chunk_capacity : 16;
+
+    while (required * 2 > capacity) {
+      capacity *= 2;
+    }
+
+    hb_arena_chunk_T* chunks = calloc(capacity, sizeof(hb_arena_chunk_T));
+    if (chunks == NULL) { return false; }
+
+    for (size_t i = 0; i < allocator->chunk_capacity; i++) {
+      const hb_arena_chunk_T* entry = &allocator->chunks[i];
+      if (entry->page != NULL) { hb_arena_chunks_insert(chunks, capacity, entry->chunk, entry->page); }
+    }
+
+    free(allocator->chunks);
+    allocator->chunks = chunks;
+    allocator->chunk_capacity = capacity;
+  }
+
+  for (uintptr_t chunk = first; chunk <= last; chunk++) {
+    hb_arena_chunks_insert(allocator->chunks, allocator->chunk_capacity, chunk, page);
+    allocator->chunk_count++;
+  }
+
+  return true;
+}
+
 static bool hb_arena_append_page(hb_arena_T* allocator, size_t minimum_size) {
   assert(minimum_size > 0);
 
@@ -55,11 +106,17 @@ static bool hb_arena_append_page(hb_arena_T* allocator, size_t minimum_size) {
 
   *page = (hb_arena_page_T) { .next = NULL, .capacity = page_size, .position = 0 };
 
+  if (!hb_arena_index_page(allocator, page)) {
+    hb_system_free_memory(page, total_size);
+    return false;
+  }
+
   if (allocator->head == NULL) {
     allocator->head = page;
     allocator->tail = page;
   } else {
-    hb_arena_page_T* last = allocator->head;
+    // Pages after the tail are empty ones kept by a reset, the last page is never before it.
+    hb_arena_page_T* last = allocator->tail;
 
     while (last->next != NULL) {
       last = last->next;
@@ -79,6 +136,9 @@ bool hb_arena_init(hb_arena_T* allocator, size_t initial_size) {
   allocator->tail = NULL;
   allocator->default_page_size = initial_size;
   allocator->allocation_count = 0;
+  allocator->chunks = NULL;
+  allocator->chunk_capacity = 0;
+  allocator->chunk_count = 0;
 
   return hb_arena_append_page(allocator, initial_size);
 }
@@ -109,6 +169,31 @@ void* hb_arena_alloc(hb_arena_T* allocator, size_t size) {
   return hb_arena_page_alloc_from(allocator->tail, required_size);
 }
 
+/**
+ * Whether `pointer` points into memory handed out by `allocator`. Looks up the
+ * pages overlapping the pointer's 64 KB chunk of address space instead of walking
+ * all of them, so hb_memory_free() stays O(1) however large the document grows.
+ */
+bool hb_arena_contains(const hb_arena_T* allocator, const void* pointer) {
+  if (allocator->chunks == NULL) { return false; }
+
+  const uintptr_t address = (uintptr_t) pointer;
+  const uintptr_t chunk = address >> HB_ARENA_CHUNK_SHIFT;
+  const size_t mask = allocator->chunk_capacity - 1;
+
+  for (size_t slot = hb_arena_chunk_slot(chunk, allocator->chunk_capacity); allocator->chunks[slot].page != NULL;
+       slot = (slot + 1) & mask) {
+    if (allocator->chunks[slot].chunk != chunk) { continue; }
+
+    const hb_arena_page_T* page = allocator->chunks[slot].page;
+    const uintptr_t start = (uintptr_t) page->memory;
+
+    if (address >= start && address < start + page->position) { return true; }
+  }
+
+  return false;
+}
+
 size_t hb_arena_position(hb_arena_T* allocator) {
   size_t total = 0;
 
@@ -173,7 +258,12 @@ void hb_arena_free(hb_arena_T* allocator) {
     current = next;
   }
 
+  free(allocator->chunks);
+
   allocator->head = NULL;
   allocator->tail = NULL;
   allocator->default_page_size = 0;
+  allocator->chunks = NULL;
+  allocator->chunk_capacity = 0;
+  allocator->chunk_count = 0;
 }
@@ -3,20 +3,21 @@
 
 #include "../include/macros.h"
 #include "../include/util/hb_array.h"
+#include "../include/util/hb_memory.h"
 
 size_t hb_array_sizeof(void) {
   return sizeof(hb_array_T);
 }
 
 hb_array_T* hb_array_init(const size_t capacity) {
-  hb_array_T* array = malloc(hb_array_sizeof());
+  hb_array_T* array = hb_memory_allocate(hb_array_sizeof());
 
   array->size = 0;
   array->capacity = capacity;
-  array->items = malloc(capacity * sizeof(void*));
+  array->items = hb_memory_allocate(capacity * sizeof(void*));
 
   if (!array->items) {
-    free(array);
+    hb_memory_free(array);
     return NULL;
   }
 
@@ -44,7 +45,7 @@ void hb_array_append(hb_array_T* array, void* item) {
     }
 
     size_t new_size_bytes = new_capacity * sizeof(void*);
-    void* new_items = realloc(array->items, new_size_bytes);
+    void* new_items = hb_memory_reallocate(array->items, array->capacity * sizeof(void*), new_size_bytes);
 
     if (unlikely(new_items == NULL)) { return; }
 
@@ -129,8 +130,8 @@ size_t hb_array_capacity(const hb_array_T* array) {
 void hb_array_free(hb_array_T** array) {
   if (!array || !*array) { return; }
 
-  free((*array)->items);
-  free(*array);
+  hb_memory_free((*array)->items);
+  hb_memory_free(*array);
 
   *array = NULL;
 }
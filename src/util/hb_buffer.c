@@ -5,6 +5,7 @@
 #include "../include/macros.h"
 #include "../include/util.h"
 #include "../include/util/hb_buffer.h"
+#include "../include/util/hb_memory.h"
 
 static bool hb_buffer_has_capacity(hb_buffer_T* buffer, const size_t required_length) {
   return (buffer->length + required_length <= buffer->capacity);
@@ -25,7 +26,7 @@ static bool hb_buffer_resize(hb_buffer_T* buffer, const size_t new_capacity) {
   char* new_value = NULL;
 
   if (buffer->allocator == NULL) {
-    new_value = realloc(buffer->value, new_capacity + 1);
+    new_value = hb_memory_reallocate(buffer->value, buffer->capacity + 1, new_capacity + 1);
   } else {
     new_value = hb_arena_alloc(buffer->allocator, new_capacity + 1);
     memcpy(new_value, buffer->value, buffer->capacity + 1);
@@ -70,7 +71,7 @@ bool hb_buffer_init(hb_buffer_T* buffer, const size_t capacity) {
   buffer->allocator = NULL;
   buffer->capacity = capacity;
   buffer->length = 0;
-  buffer->value = malloc(sizeof(char) * (buffer->capacity + 1));
+  buffer->value = hb_memory_allocate(sizeof(char) * (buffer->capacity + 1));
 
   if (!buffer->value) {
     fprintf(stderr, "Error: Failed to initialize buffer with capacity of %zu.\n", buffer->capacity);
@@ -0,0 +1,66 @@
+#include "../include/util/hb_memory.h"
+#include "../include/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The arena that new allocations on the current thread are routed to, or NULL for malloc.
+static thread_local hb_arena_T* current_arena = NULL;
+
+hb_arena_T* hb_memory_arena(void) {
+  return current_arena;
+}
+
+/**
+ * Routes new hb_memory_* allocations on the current thread to `arena` until the
+ * previous arena is restored. Passing NULL switches back to malloc.
+ *
+ * This only decides where new memory comes from. hb_memory_free() looks at the
+ * memory it is given, see there.
+ *
+ * @return The arena that was in use before, so it can be restored afterwards
+ */
+hb_arena_T* hb_memory_use_arena(hb_arena_T* arena) {
+  hb_arena_T* previous = current_arena;
+  current_arena = arena;
+
+  return previous;
+}
+
+void* hb_memory_allocate(size_t size) {
+  if (current_arena == NULL) { return malloc(size); }
+  if (size == 0) { size = 1; }
+
+  return hb_arena_alloc(current_arena, size);
+}
+
+void* hb_memory_allocate_zeroed(size_t count, size_t size) {
+  if (current_arena == NULL) { return calloc(count, size); }
+
+  void* memory = hb_memory_allocate(count * size);
+  if (memory != NULL) { memset(memory, 0, count * size); }
+
+  return memory;
+}
+
+void* hb_memory_reallocate(void* pointer, size_t old_size, size_t new_size) {
+  if (current_arena == NULL) { return realloc(pointer, new_size); }
+
+  void* memory = hb_memory_allocate(new_size);
+
+  if (memory != NULL && pointer != NULL) { memcpy(memory, pointer, MIN(old_size, new_size)); }
+
+  return memory;
+}
+
+/**
+ * Frees `pointer`, unless it was allocated from the arena in use: that memory is
+ * released together with the arena. Heap memory is freed even while an arena is
+ * in use, so objects that were allocated outside of it don't leak.
+ */
+void hb_memory_free(void* pointer) {
+  if (pointer == NULL) { return; }
+  if (current_arena != NULL && hb_arena_contains(current_arena, pointer)) { return; }
+
+  free(pointer);
+}
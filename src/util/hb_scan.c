@@ -0,0 +1,61 @@
+#include "../include/util/hb_scan.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HB_SCAN_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HB_SCAN_SSE2
+#endif
+
+static size_t hb_scan_find_first_of_scalar(const char* data, size_t length, char a, char b, char c, char d) {
+  for (size_t i = 0; i < length; i++) {
+    const char byte = data[i];
+
+    if (byte == a || byte == b || byte == c || byte == d) { return i; }
+  }
+
+  return length;
+}
+
+size_t hb_scan_find_first_of(const char* data, size_t length, char a, char b, char c, char d) {
+  size_t i = 0;
+
+#if defined(HB_SCAN_AVX2)
+  const __m256i needle_a = _mm256_set1_epi8(a);
+  const __m256i needle_b = _mm256_set1_epi8(b);
+  const __m256i needle_c = _mm256_set1_epi8(c);
+  const __m256i needle_d = _mm256_set1_epi8(d);
+
+  for (; i + 32 <= length; i += 32) {
+    const __m256i chunk = _mm256_loadu_si256((const __m256i*) (data + i));
+
+    const __m256i matches = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, needle_a), _mm256_cmpeq_epi8(chunk, needle_b)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, needle_c), _mm256_cmpeq_epi8(chunk, needle_d))
+    );
+
+    const unsigned int mask = (unsigned int) _mm256_movemask_epi8(matches);
+    if (mask != 0) { return i + (size_t) __builtin_ctz(mask); }
+  }
+#elif defined(HB_SCAN_SSE2)
+  const __m128i needle_a = _mm_set1_epi8(a);
+  const __m128i needle_b = _mm_set1_epi8(b);
+  const __m128i needle_c = _mm_set1_epi8(c);
+  const __m128i needle_d = _mm_set1_epi8(d);
+
+  for (; i + 16 <= length; i += 16) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i*) (data + i));
+
+    const __m128i matches = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, needle_a), _mm_cmpeq_epi8(chunk, needle_b)),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, needle_c), _mm_cmpeq_epi8(chunk, needle_d))
+    );
+
+    const unsigned int mask = (unsigned int) _mm_movemask_epi8(matches);
+    if (mask != 0) { return i + (size_t) __builtin_ctz(mask); }
+  }
+#endif
+
+  return i + hb_scan_find_first_of_scalar(data + i, length - i, a, b, c, d);
+}
@@ -1,5 +1,6 @@
 #include "../include/util/hb_string.h"
 #include "../include/macros.h"
+#include "../include/util/hb_memory.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -73,6 +74,21 @@ char* hb_string_to_c_string_using_malloc(hb_string_T string) {
   return buffer;
 }
 
+/**
+ * Like hb_string_to_c_string_using_malloc(), but allocates with hb_memory_allocate(), so the copy
+ * belongs to the current arena if there is one and must be released with hb_memory_free().
+ */
+char* hb_string_to_c_string_using_hb_memory(hb_string_T string) {
+  size_t string_length_in_bytes = sizeof(char) * (string.length);
+  char* buffer = hb_memory_allocate(string_length_in_bytes + sizeof(char) * 1);
+
+  if (!hb_string_is_empty(string)) { memcpy(buffer, string.data, string_length_in_bytes); }
+
+  buffer[string_length_in_bytes] = '\0';
+
+  return buffer;
+}
+
 char* hb_string_to_c_string(hb_arena_T* allocator, hb_string_T string) {
   size_t string_length_in_bytes = sizeof(char) * (string.length);
   char* buffer = hb_arena_alloc(allocator, string_length_in_bytes + sizeof(char) * 1);
@@ -1,19 +1,25 @@
 #include "../include/util/hb_system.h"
+#include "../include/macros.h"
 
 #ifdef __linux__
 #define _GNU_SOURCE
 #endif
 
-#ifdef HB_USE_MALLOC
 #include <stdlib.h>
-#else
+
+#ifndef HB_USE_MALLOC
 #include <sys/mman.h>
+
+// Smaller blocks come from malloc, so short-lived arenas reuse heap memory instead of faulting in fresh pages.
+#define HB_SYSTEM_MMAP_THRESHOLD KB(256)
 #endif
 
 void* hb_system_allocate_memory(size_t size) {
 #ifdef HB_USE_MALLOC
   return malloc(size);
 #else
+  if (size < HB_SYSTEM_MMAP_THRESHOLD) { return malloc(size); }
+
   void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   if (memory == MAP_FAILED) { return NULL; }
 
@@ -25,6 +31,11 @@ void hb_system_free_memory(void* ptr, size_t size) {
 #ifdef HB_USE_MALLOC
   free(ptr);
 #else
+  if (size < HB_SYSTEM_MMAP_THRESHOLD) {
+    free(ptr);
+    return;
+  }
+
   munmap(ptr, size);
 #endif
 }
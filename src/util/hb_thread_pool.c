@@ -0,0 +1,178 @@
+#include "../include/util/hb_thread_pool.h"
+#include "../include/macros.h"
+#include "../include/util/hb_memory.h"
+#include "../include/util/hb_mutex.h"
+
+#if defined(HB_NO_THREADS) || defined(_WIN32)
+
+// Without pthreads every task runs on the calling thread.
+
+size_t hb_thread_pool_default_size(void) {
+  return 1;
+}
+
+void hb_thread_pool_run(size_t count, size_t thread_count, hb_thread_pool_task_T task, void* data) {
+  (void) thread_count;
+
+  for (size_t index = 0; index < count; index++) {
+    task(index, data);
+  }
+}
+
+#else
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+// Parsing recurses once per nesting level, and secondary threads get as little as 512 KB on macOS.
+#define HB_THREAD_POOL_STACK_SIZE MB(8)
+
+// The tasks `next` up to `end` that haven't been started yet. The owning worker takes
+// them from the front, other workers steal the back half once their own queue is empty.
+typedef struct {
+  pthread_mutex_t lock;
+  size_t next;
+  size_t end;
+} hb_thread_pool_queue_T;
+
+typedef struct {
+  hb_thread_pool_queue_T* queues;
+  size_t thread_count;
+  hb_thread_pool_task_T task;
+  void* data;
+} hb_thread_pool_T;
+
+typedef struct {
+  hb_thread_pool_T* pool;
+  size_t id;
+} hb_thread_pool_worker_T;
+
+/**
+ * @return The number of online processors, or 1 if it can't be determined
+ */
+size_t hb_thread_pool_default_size(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return count > 0 ? (size_t) count : 1;
+}
+
+static bool hb_thread_pool_take(hb_thread_pool_queue_T* queue, size_t* index) {
+  pthread_mutex_lock(&queue->lock);
+
+  bool taken = queue->next < queue->end;
+  if (taken) { *index = queue->next++; }
+
+  pthread_mutex_unlock(&queue->lock);
+
+  return taken;
+}
+
+// Moves the back half of the first non-empty queue after `worker`'s own into it, and takes
+// the first of the stolen tasks. Only the owner refills a queue, so it is still empty here.
+static bool hb_thread_pool_steal(hb_thread_pool_T* pool, size_t worker, size_t* index) {
+  for (size_t offset = 1; offset < pool->thread_count; offset++) {
+    hb_thread_pool_queue_T* victim = &pool->queues[(worker + offset) % pool->thread_count];
+
+    pthread_mutex_lock(&victim->lock);
+
+    size_t remaining = victim->end - victim->next;
+    size_t end = victim->end;
+    victim->end -= (remaining + 1) / 2;
+    size_t start = victim->end;
+
+    pthread_mutex_unlock(&victim->lock);
+
+    if (remaining == 0) { continue; }
+
+    hb_thread_pool_queue_T* queue = &pool->queues[worker];
+
+    pthread_mutex_lock(&queue->lock);
+    queue->next = start + 1;
+    queue->end = end;
+    pthread_mutex_unlock(&queue->lock);
+
+    *index = start;
+
+    return true;
+  }
+
+  return false;
+}
+
+static void* hb_thread_pool_work(void* data) {
+  hb_thread_pool_worker_T* worker = (hb_thread_pool_worker_T*) data;
+  hb_thread_pool_T* pool = worker->pool;
+  size_t index;
+
+  while (hb_thread_pool_take(&pool->queues[worker->id], &index)
+         || hb_thread_pool_steal(pool, worker->id, &index)) {
+    pool->task(index, pool->data);
+  }
+
+  return NULL;
+}
+
+/**
+ * Calls `task` once for every index below `count` and returns when all calls are done.
+ *
+ * The calls are spread over `thread_count` threads (the processor count if 0), one of
+ * which is the calling thread. Every thread starts on its own contiguous share of the
+ * indices and steals from the others when it runs out. If threads can't be created,
+ * for example in a WebAssembly build without thread support, the remaining work is
+ * done by the threads that are running.
+ */
+void hb_thread_pool_run(size_t count, size_t thread_count, hb_thread_pool_task_T task, void* data) {
+  if (thread_count == 0) { thread_count = hb_thread_pool_default_size(); }
+  thread_count = MIN(thread_count, count);
+
+  if (thread_count <= 1) {
+    for (size_t index = 0; index < count; index++) {
+      task(index, data);
+    }
+
+    return;
+  }
+
+  hb_thread_pool_T pool = { .thread_count = thread_count, .task = task, .data = data };
+  pool.queues = hb_memory_allocate(thread_count * sizeof(hb_thread_pool_queue_T));
+
+  hb_thread_pool_worker_T* workers = hb_memory_allocate(thread_count * sizeof(hb_thread_pool_worker_T));
+  pthread_t* threads = hb_memory_allocate(thread_count * sizeof(pthread_t));
+  bool* started = hb_memory_allocate_zeroed(thread_count, sizeof(bool));
+
+  for (size_t i = 0; i < thread_count; i++) {
+    pthread_mutex_init(&pool.queues[i].lock, NULL);
+    pool.queues[i].next = count * i / thread_count;
+    pool.queues[i].end = count * (i + 1) / thread_count;
+
+    workers[i] = (hb_thread_pool_worker_T) { .pool = &pool, .id = i };
+  }
+
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  pthread_attr_setstacksize(&attributes, HB_THREAD_POOL_STACK_SIZE);
+
+  for (size_t i = 1; i < thread_count; i++) {
+    started[i] = pthread_create(&threads[i], &attributes, hb_thread_pool_work, &workers[i]) == 0;
+  }
+
+  pthread_attr_destroy(&attributes);
+
+  hb_thread_pool_work(&workers[0]);
+
+  for (size_t i = 1; i < thread_count; i++) {
+    if (started[i]) { pthread_join(threads[i], NULL); }
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    pthread_mutex_destroy(&pool.queues[i].lock);
+  }
+
+  hb_memory_free(started);
+  hb_memory_free(threads);
+  hb_memory_free(workers);
+  hb_memory_free(pool.queues);
+}
+
+#endif
@@ -0,0 +1,57 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+module AST
+  class LazyNodeTest < Minitest::Spec
+    test "nodes load their fields on first access" do
+      document = Herb.parse("<div><p>text</p></div>").value
+
+      assert_empty document.instance_variables - [:@type]
+
+      element = document.children.first
+
+      assert_equal [:@type], element.instance_variables
+      assert_equal "div", element.tag_name.value
+      assert_includes element.instance_variables, :@location
+    end
+
+    test "nodes stay valid after the source string is changed" do
+      source = +"<div class=\"a\"><%= title %></div>"
+      result = Herb.parse(source)
+
+      source.replace("<span></span>")
+      GC.start
+
+      element = result.value.children.first
+
+      assert_equal "div", element.tag_name.value
+      assert_equal " title ", element.body.first.content.value
+    end
+
+    test "nodes outlive their parse result" do
+      children = Herb.parse("<ul><li>one</li></ul>").value.children
+      GC.start
+
+      assert_equal "li", children.first.body.first.tag_name.value
+    end
+
+    test "recursive errors don't load the tree" do
+      result = Herb.parse("<div><p></div>")
+      errors = result.errors
+
+      assert_equal [:@type], result.value.instance_variables
+      assert_equal 1, errors.size
+      assert_equal errors.to_json, result.value.children.flat_map(&:recursive_errors).to_json
+    end
+
+    test "nodes created in Ruby" do
+      location = Herb::Location.from(1, 0, 1, 4)
+      node = Herb::AST::LiteralNode.new("AST_LITERAL_NODE", location, [], +"text")
+
+      assert_equal "text", node.content
+      assert_same location, node.location
+      assert_empty node.recursive_errors
+    end
+  end
+end
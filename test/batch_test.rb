@@ -0,0 +1,43 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+class BatchTest < Minitest::Spec
+  SOURCES = [
+    %(<div class="a"><%= title %></div>),
+    %(<% if x %><p>yes</p><% else %><p>no</p><% end %>),
+    %(<span>unclosed),
+    "",
+  ].freeze
+
+  test "parse_batch returns the same results as parse" do
+    results = Herb.parse_batch(SOURCES, threads: 2)
+
+    assert_equal SOURCES.size, results.size
+
+    SOURCES.zip(results).each do |source, result|
+      assert_equal Herb.parse(source).value.inspect, result.value.inspect
+      assert_equal source, result.source
+    end
+  end
+
+  test "parse_batch passes parser options" do
+    source = "<div   class='a'  ></div>"
+    result = Herb.parse_batch([source], track_whitespace: true).first
+
+    assert_equal Herb.parse(source, track_whitespace: true).value.inspect, result.value.inspect
+  end
+
+  test "lex_batch returns the same tokens as lex" do
+    results = Herb.lex_batch(SOURCES)
+
+    SOURCES.zip(results).each do |source, result|
+      assert_equal Herb.lex(source).value.map(&:inspect), result.value.map(&:inspect)
+    end
+  end
+
+  test "batch methods only accept strings" do
+    assert_raises(TypeError) { Herb.parse_batch(["<div>", nil]) }
+    assert_raises(TypeError) { Herb.lex_batch("<div>") }
+  end
+end
@@ -1,30 +1,44 @@
 #include <check.h>
 #include <stdlib.h>
 
+TCase *analyzed_ruby_tests(void);
 TCase *hb_arena_tests(void);
 TCase *hb_array_tests(void);
 TCase *hb_buffer_tests(void);
+TCase *hb_scan_tests(void);
 TCase *hb_string_tests(void);
+TCase *hb_thread_pool_tests(void);
 TCase *herb_tests(void);
 TCase *html_util_tests(void);
 TCase *io_tests(void);
 TCase *lex_tests(void);
+TCase *line_index_tests(void);
+TCase *reparse_tests(void);
+TCase *serialize_tests(void);
 TCase *token_tests(void);
+TCase *token_stream_tests(void);
 TCase *util_tests(void);
 TCase *extract_tests(void);
 
 Suite *herb_suite(void) {
   Suite *suite = suite_create("Herb Suite");
 
+  suite_add_tcase(suite, analyzed_ruby_tests());
   suite_add_tcase(suite, hb_arena_tests());
   suite_add_tcase(suite, hb_array_tests());
   suite_add_tcase(suite, hb_buffer_tests());
+  suite_add_tcase(suite, hb_scan_tests());
   suite_add_tcase(suite, hb_string_tests());
+  suite_add_tcase(suite, hb_thread_pool_tests());
   suite_add_tcase(suite, herb_tests());
   suite_add_tcase(suite, html_util_tests());
   suite_add_tcase(suite, io_tests());
   suite_add_tcase(suite, lex_tests());
+  suite_add_tcase(suite, line_index_tests());
+  suite_add_tcase(suite, reparse_tests());
+  suite_add_tcase(suite, serialize_tests());
   suite_add_tcase(suite, token_tests());
+  suite_add_tcase(suite, token_stream_tests());
   suite_add_tcase(suite, util_tests());
   suite_add_tcase(suite, extract_tests());
 
@@ -0,0 +1,265 @@
+#include "include/test.h"
+#include "../../src/include/analyze.h"
+#include "../../src/include/analyze_helpers.h"
+#include "../../src/include/analyzed_ruby.h"
+#include "../../src/include/herb.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+TEST(test_analyzed_ruby_cache_hits_and_misses)
+  analyzed_ruby_cache_T cache;
+  analyzed_ruby_cache_init(&cache, 0, false);
+
+  analyzed_ruby_T* end = init_analyzed_ruby();
+  end->valid = false;
+  end->has_end = true;
+
+  ck_assert_ptr_null(analyzed_ruby_cache_lookup(&cache, hb_string(" end ")));
+  analyzed_ruby_cache_store(&cache, hb_string(" end "), end);
+
+  const analyzed_ruby_T* cached = analyzed_ruby_cache_lookup(&cache, hb_string(" end "));
+  ck_assert_ptr_nonnull(cached);
+  ck_assert(cached->has_end);
+  ck_assert(!cached->valid);
+
+  ck_assert_ptr_null(analyzed_ruby_cache_lookup(&cache, hb_string(" end")));
+
+  ck_assert_int_eq(cache.hits, 1);
+  ck_assert_int_eq(cache.misses, 2);
+
+  free_analyzed_ruby(end);
+  analyzed_ruby_cache_free(&cache);
+END
+
+TEST(test_analyzed_ruby_cache_grows)
+  analyzed_ruby_cache_T cache;
+  analyzed_ruby_cache_init(&cache, 0, false);
+
+  analyzed_ruby_T* analyzed = init_analyzed_ruby();
+  char sources[200][8];
+
+  for (int i = 0; i < 200; i++) {
+    snprintf(sources[i], sizeof(sources[i]), "x%d", i);
+    analyzed_ruby_cache_store(&cache, hb_string(sources[i]), analyzed);
+  }
+
+  ck_assert_int_eq(cache.size, 200);
+
+  for (int i = 0; i < 200; i++) {
+    ck_assert_ptr_nonnull(analyzed_ruby_cache_lookup(&cache, hb_string(sources[i])));
+  }
+
+  free_analyzed_ruby(analyzed);
+  analyzed_ruby_cache_free(&cache);
+END
+
+TEST(test_analyzed_ruby_cache_bounded_owns_keys)
+  analyzed_ruby_cache_T cache;
+  analyzed_ruby_cache_init(&cache, 2, true);
+
+  analyzed_ruby_T* analyzed = init_analyzed_ruby();
+  char source[] = " else ";
+
+  analyzed_ruby_cache_store(&cache, hb_string(source), analyzed);
+  source[1] = 'E';
+
+  ck_assert_ptr_nonnull(analyzed_ruby_cache_lookup(&cache, hb_string(" else ")));
+
+  analyzed_ruby_cache_store(&cache, hb_string(" end "), analyzed);
+  analyzed_ruby_cache_store(&cache, hb_string(" } "), analyzed);
+
+  ck_assert_int_eq(cache.size, 1);
+  ck_assert_ptr_null(analyzed_ruby_cache_lookup(&cache, hb_string(" else ")));
+  ck_assert_ptr_nonnull(analyzed_ruby_cache_lookup(&cache, hb_string(" } ")));
+
+  free_analyzed_ruby(analyzed);
+  analyzed_ruby_cache_free(&cache);
+END
+
+TEST(test_analyze_cache_reuses_repeated_snippets)
+  const char* source = "<% if a %>a<% end %><% if b %>b<% end %><% if a %>c<% end %>";
+
+  herb_analyze_cache_reset_stats();
+
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+  herb_analyze_parse_tree(document, source);
+  ast_node_free((AST_NODE_T*) document);
+
+  analyze_cache_stats_T stats = herb_analyze_cache_stats();
+  ck_assert_int_eq(stats.misses, 2);
+  ck_assert_int_eq(stats.hits, 1);
+END
+
+TEST(test_analyze_process_cache_spans_documents)
+  const char* source = "<% if a %>a<% end %>";
+
+  herb_analyze_cache_configure(16);
+  herb_analyze_cache_reset_stats();
+
+  for (int i = 0; i < 2; i++) {
+    AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+    herb_analyze_parse_tree(document, source);
+    ast_node_free((AST_NODE_T*) document);
+  }
+
+  analyze_cache_stats_T stats = herb_analyze_cache_stats();
+  ck_assert_int_eq(stats.misses, 1);
+  ck_assert_int_eq(stats.hits, 1);
+
+  herb_analyze_cache_configure(0);
+END
+
+static void* parse_on_thread(void* data) {
+  const char* source = "<% if a %>a<% end %>";
+
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+  herb_analyze_parse_tree(document, source);
+  ast_node_free((AST_NODE_T*) document);
+
+  *(analyze_cache_stats_T*) data = herb_analyze_cache_stats();
+
+  return NULL;
+}
+
+TEST(test_analyze_process_cache_is_shared_across_threads)
+  const char* source = "<% if a %>a<% end %>";
+
+  herb_analyze_cache_configure(16);
+
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+  herb_analyze_parse_tree(document, source);
+  ast_node_free((AST_NODE_T*) document);
+
+  analyze_cache_stats_T stats = { 0 };
+  pthread_t thread;
+
+  ck_assert_int_eq(pthread_create(&thread, NULL, parse_on_thread, &stats), 0);
+  pthread_join(thread, NULL);
+
+  ck_assert_int_eq(stats.misses, 0);
+  ck_assert_int_eq(stats.hits, 1);
+
+  herb_analyze_cache_configure(0);
+END
+
+static analyzed_ruby_T* classify(const char* source, bool* trivial) {
+  analyzed_ruby_T* analyzed = init_analyzed_ruby();
+  *trivial = classify_trivial_ruby(hb_string(source), analyzed);
+
+  return analyzed;
+}
+
+TEST(test_classify_trivial_ruby_keywords)
+  bool trivial;
+
+  analyzed_ruby_T* end = classify(" end ", &trivial);
+  ck_assert(trivial);
+  ck_assert(end->has_end);
+  ck_assert(!end->valid);
+  free_analyzed_ruby(end);
+
+  analyzed_ruby_T* else_node = classify("\n  else\n", &trivial);
+  ck_assert(trivial);
+  ck_assert(else_node->has_else_node);
+  ck_assert(!else_node->has_end);
+  free_analyzed_ruby(else_node);
+
+  analyzed_ruby_T* ensure = classify(" ensure ", &trivial);
+  ck_assert(trivial);
+  ck_assert(ensure->has_ensure_node);
+  free_analyzed_ruby(ensure);
+
+  analyzed_ruby_T* block_closing = classify(" } ", &trivial);
+  ck_assert(trivial);
+  ck_assert(block_closing->has_block_closing);
+  free_analyzed_ruby(block_closing);
+END
+
+TEST(test_classify_trivial_ruby_clauses)
+  bool trivial;
+
+  analyzed_ruby_T* elsif = classify(" elsif user.admin? && items[0] != nil ", &trivial);
+  ck_assert(trivial);
+  ck_assert(elsif->has_elsif_node);
+  ck_assert_int_eq(elsif->earliest_control_type, CONTROL_TYPE_UNKNOWN);
+  free_analyzed_ruby(elsif);
+
+  analyzed_ruby_T* when = classify(" when :draft, \"pending\" ", &trivial);
+  ck_assert(trivial);
+  ck_assert(when->has_when_node);
+  free_analyzed_ruby(when);
+END
+
+TEST(test_classify_trivial_ruby_falls_back)
+  const char* sources[] = { " end.each do |item| ",     " end if admin? ",      " elsif ",
+                            " elsif items.any? { |i| i } ", " when 1 then ",      " when 1; break ",
+                            " else # comment ",          " elsif \"#{value}\" ", " if admin? ",
+                            " endless ",                 " elsif items.map(&:id) ", " when value & mask ",
+                            "" };
+
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    bool trivial;
+    analyzed_ruby_T* analyzed = classify(sources[i], &trivial);
+
+    ck_assert_msg(!trivial, "expected %s to need Prism", sources[i]);
+    ck_assert(analyzed->valid);
+
+    free_analyzed_ruby(analyzed);
+  }
+END
+
+TEST(test_classify_trivial_ruby_matches_prism)
+  const char* sources[] = { "end",
+                            " end ",
+                            "\r\n  end\r\n",
+                            "else",
+                            " else ",
+                            "\telse\r\n",
+                            "ensure",
+                            " ensure\r\n",
+                            "}",
+                            " } ",
+                            "elsif admin?",
+                            " elsif user.admin? && !banned ",
+                            "\r\nelsif user&.admin?\r\n",
+                            " elsif\r\n  count > 1 ",
+                            "when 1",
+                            " when :a, :b ",
+                            "\r\nwhen \"value\"\r\n" };
+
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    bool trivial;
+    analyzed_ruby_T* classified = classify(sources[i], &trivial);
+    ck_assert_msg(trivial, "expected %s to be trivial", sources[i]);
+
+    analyzed_ruby_T* parsed = init_analyzed_ruby();
+    analyze_ruby_with_prism(hb_string(sources[i]), parsed);
+
+    ck_assert_msg(classified->valid == parsed->valid, "valid differs for %s", sources[i]);
+    ck_assert_msg(classified->earliest_control_type == parsed->earliest_control_type,
+                  "earliest_control_type differs for %s", sources[i]);
+    ck_assert_msg(memcmp(classified, parsed, sizeof(analyzed_ruby_T)) == 0, "flags differ for %s", sources[i]);
+
+    free_analyzed_ruby(classified);
+    free_analyzed_ruby(parsed);
+  }
+END
+
+TCase *analyzed_ruby_tests(void) {
+  TCase *analyzed_ruby = tcase_create("Analyzed Ruby");
+
+  tcase_add_test(analyzed_ruby, test_analyzed_ruby_cache_hits_and_misses);
+  tcase_add_test(analyzed_ruby, test_analyzed_ruby_cache_grows);
+  tcase_add_test(analyzed_ruby, test_analyzed_ruby_cache_bounded_owns_keys);
+  tcase_add_test(analyzed_ruby, test_classify_trivial_ruby_keywords);
+  tcase_add_test(analyzed_ruby, test_classify_trivial_ruby_clauses);
+  tcase_add_test(analyzed_ruby, test_classify_trivial_ruby_falls_back);
+  tcase_add_test(analyzed_ruby, test_classify_trivial_ruby_matches_prism);
+  tcase_add_test(analyzed_ruby, test_analyze_cache_reuses_repeated_snippets);
+  tcase_add_test(analyzed_ruby, test_analyze_process_cache_spans_documents);
+  tcase_add_test(analyzed_ruby, test_analyze_process_cache_is_shared_across_threads);
+
+  return analyzed_ruby;
+}
@@ -2,6 +2,10 @@
 
 #include "../../src/include/herb.h"
 #include "../../src/include/extract.h"
+#include "../../src/include/ast_nodes.h"
+#include "../../src/include/lexer.h"
+#include "../../src/include/lexer_peek_helpers.h"
+#include "../../src/include/token.h"
 #include "../../src/include/util/hb_buffer.h"
 
 TEST(extract_ruby_single_erb_with_semicolons)
@@ -145,6 +149,64 @@ TEST(extract_ruby_inline_comment_complex)
   free(result);
 END
 
+TEST(extract_ruby_while_parsing)
+  const char* sources[] = {
+    "<% if %>\n<% end %>",
+    "<div class=\"a\\\"<%= b %>\"><%# comment %>\r\n<%%= raw %></div>",
+    "<script>console.log(\"<%= 1 %>\")</script><% unclosed",
+    "<div a = \"b\"><%= a %></div>",
+    "<div class\n  =\n  \"hello\"><%= a %></div>",
+  };
+
+  parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+  options.track_whitespace = true;
+
+  for (size_t i = 0; i < 2 * sizeof(sources) / sizeof(sources[0]); i++) {
+    const char* source = sources[i / 2];
+    AST_DOCUMENT_NODE_T* document = herb_parse(source, i % 2 ? &options : NULL);
+    char* expected = herb_extract_ruby_with_semicolons(source);
+
+    ck_assert_ptr_nonnull(document->extracted_ruby);
+    ck_assert_str_eq(document->extracted_ruby, expected);
+
+    free(expected);
+    ast_node_free((AST_NODE_T*) document);
+  }
+END
+
+TEST(extract_ruby_extractor_ignores_rewound_tokens)
+  lexer_T lexer = { 0 };
+  lexer_init(&lexer, "<% a %>b");
+
+  hb_buffer_T output;
+  hb_buffer_init(&output, 16);
+
+  herb_ruby_extractor_T extractor;
+  herb_ruby_extractor_init(&extractor, &output);
+  lexer.ruby_extractor = &extractor;
+
+  token_T* tokens[8];
+  size_t count = 0;
+
+  tokens[count++] = lexer_next_token(&lexer);
+  tokens[count++] = lexer_next_token(&lexer);
+
+  lexer_state_snapshot_T snapshot = lexer_save_state(&lexer);
+  tokens[count++] = lexer_next_token(&lexer);
+  lexer_restore_state(&lexer, snapshot);
+
+  while ((tokens[count++] = lexer_next_token(&lexer))->type != TOKEN_EOF) {}
+
+  ck_assert(extractor.complete);
+  ck_assert_str_eq(output.value, "   a  ; ");
+
+  for (size_t i = 0; i < count; i++) {
+    token_free(tokens[i]);
+  }
+
+  free(output.value);
+END
+
 TCase *extract_tests(void) {
   TCase *extract = tcase_create("Extract");
 
@@ -163,6 +225,8 @@ TCase *extract_tests(void) {
   tcase_add_test(extract, extract_ruby_inline_comment_multiline);
   tcase_add_test(extract, extract_ruby_inline_comment_between_code);
   tcase_add_test(extract, extract_ruby_inline_comment_complex);
+  tcase_add_test(extract, extract_ruby_while_parsing);
+  tcase_add_test(extract, extract_ruby_extractor_ignores_rewound_tokens);
 
   return extract;
 }
@@ -1,6 +1,7 @@
 #include "include/test.h"
 #include "../../src/include/util/hb_arena.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 // Test basic allocation
@@ -30,6 +31,60 @@ TEST(test_arena_alloc)
   hb_arena_free(&allocator);
 END
 
+// Test which pointers belong to the arena
+TEST(test_arena_contains)
+  hb_arena_T allocator;
+  hb_arena_init(&allocator, 64);
+
+  char *memory1 = hb_arena_alloc(&allocator, 32);
+  char *memory2 = hb_arena_alloc(&allocator, 64);
+  char *heap = malloc(16);
+
+  ck_assert(hb_arena_contains(&allocator, memory1));
+  ck_assert(hb_arena_contains(&allocator, memory1 + 31));
+  ck_assert(hb_arena_contains(&allocator, memory2));
+  ck_assert(!hb_arena_contains(&allocator, heap));
+  ck_assert(!hb_arena_contains(&allocator, NULL));
+
+  free(heap);
+  hb_arena_free(&allocator);
+END
+
+TEST(test_arena_contains_across_pages)
+  hb_arena_T allocator;
+  hb_arena_init(&allocator, 1024);
+
+  char *pointers[512];
+
+  for (size_t i = 0; i < 512; i++) {
+    pointers[i] = hb_arena_alloc(&allocator, 200);
+  }
+
+  char *large = hb_arena_alloc(&allocator, 300 * 1024);
+  char *heap = malloc(16);
+
+  for (size_t i = 0; i < 512; i++) {
+    ck_assert(hb_arena_contains(&allocator, pointers[i]));
+  }
+
+  ck_assert(hb_arena_contains(&allocator, large));
+  ck_assert(hb_arena_contains(&allocator, large + 300 * 1024 - 1));
+  ck_assert(!hb_arena_contains(&allocator, heap));
+
+  // Reset memory isn't handed out anymore, until it is allocated again.
+  hb_arena_reset(&allocator);
+  ck_assert(!hb_arena_contains(&allocator, pointers[0]));
+  ck_assert(!hb_arena_contains(&allocator, large));
+
+  ck_assert_ptr_eq(hb_arena_alloc(&allocator, 200), pointers[0]);
+  ck_assert(hb_arena_contains(&allocator, pointers[0]));
+
+  free(heap);
+  hb_arena_free(&allocator);
+
+  ck_assert_ptr_null(allocator.chunks);
+END
+
 // Test page growth when allocation exceeds current page
 TEST(test_arena_page_growth)
   hb_arena_T allocator;
@@ -354,6 +409,8 @@ TCase *hb_arena_tests(void) {
   TCase *arena = tcase_create("arena");
 
   tcase_add_test(arena, test_arena_alloc);
+  tcase_add_test(arena, test_arena_contains);
+  tcase_add_test(arena, test_arena_contains_across_pages);
   tcase_add_test(arena, test_arena_page_growth);
   tcase_add_test(arena, test_arena_large_allocation);
   tcase_add_test(arena, test_arena_reset);
@@ -0,0 +1,48 @@
+#include "include/test.h"
+#include "../../src/include/util/hb_scan.h"
+
+#include <string.h>
+
+TEST(hb_scan_find_first_of_without_match)
+  ck_assert_uint_eq(hb_scan_find_first_of("", 0, '%', '<', '>', '\n'), 0);
+  ck_assert_uint_eq(hb_scan_find_first_of("hello world", 11, '%', '<', '>', '\n'), 11);
+END
+
+TEST(hb_scan_find_first_of_every_offset)
+  char buffer[100];
+
+  // Covers matches in the vector loop, on chunk boundaries and in the scalar tail.
+  for (size_t length = 1; length <= sizeof(buffer); length++) {
+    for (size_t position = 0; position < length; position++) {
+      memset(buffer, 'a', sizeof(buffer));
+      buffer[position] = '>';
+
+      ck_assert_uint_eq(hb_scan_find_first_of(buffer, length, '%', '<', '>', '\n'), position);
+    }
+  }
+END
+
+TEST(hb_scan_find_first_of_returns_earliest_match)
+  const char* source = "<%= aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa %>\n";
+
+  ck_assert_uint_eq(hb_scan_find_first_of(source, strlen(source), '\n', '\n', '%', '\n'), 1);
+  ck_assert_uint_eq(hb_scan_find_first_of(source + 2, strlen(source) - 2, '%', '\n', '\n', '\n'), 42);
+  ck_assert_uint_eq(hb_scan_find_first_of(source, strlen(source), '\n', '\n', '\n', '\n'), 46);
+END
+
+TEST(hb_scan_find_first_of_high_bytes)
+  const char* source = "ééééééééééééééééééé😀";
+
+  ck_assert_uint_eq(hb_scan_find_first_of(source, strlen(source), '\xF0', '<', '<', '<'), 38);
+END
+
+TCase *hb_scan_tests(void) {
+  TCase *scan = tcase_create("Herb Scan");
+
+  tcase_add_test(scan, hb_scan_find_first_of_without_match);
+  tcase_add_test(scan, hb_scan_find_first_of_every_offset);
+  tcase_add_test(scan, hb_scan_find_first_of_returns_earliest_match);
+  tcase_add_test(scan, hb_scan_find_first_of_high_bytes);
+
+  return scan;
+}
@@ -1,5 +1,7 @@
 #include "include/test.h"
+#include "../../src/include/util/hb_memory.h"
 #include "../../src/include/util/hb_string.h"
+#include <stdlib.h>
 #include <string.h>
 
 TEST(hb_string_equals_tests)
@@ -230,6 +232,32 @@ TEST(hb_string_range_tests)
   }
 END
 
+TEST(hb_string_to_c_string_allocator_tests)
+  hb_arena_T arena;
+  hb_arena_init(&arena, 1024);
+  hb_arena_T* previous = hb_memory_use_arena(&arena);
+
+  {
+    // Bindings free() this, so it must not come from the arena.
+    char* copy = hb_string_to_c_string_using_malloc(hb_string_range(hb_string("Test String"), 5, 11));
+
+    ck_assert_str_eq(copy, "String");
+    ck_assert_int_eq(hb_arena_position(&arena), 0);
+
+    free(copy);
+  }
+
+  {
+    char* copy = hb_string_to_c_string_using_hb_memory(hb_string("Test"));
+
+    ck_assert_str_eq(copy, "Test");
+    ck_assert_int_gt(hb_arena_position(&arena), 0);
+  }
+
+  hb_memory_use_arena(previous);
+  hb_arena_free(&arena);
+END
+
 TCase *hb_string_tests(void) {
   TCase *tags = tcase_create("Herb String");
 
@@ -240,6 +268,7 @@ TCase *hb_string_tests(void) {
   tcase_add_test(tags, hb_string_starts_with_tests);
   tcase_add_test(tags, hb_string_truncate_tests);
   tcase_add_test(tags, hb_string_range_tests);
+  tcase_add_test(tags, hb_string_to_c_string_allocator_tests);
 
   return tags;
 }
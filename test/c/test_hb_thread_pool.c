@@ -0,0 +1,50 @@
+#include "include/test.h"
+#include "../../src/include/util/hb_thread_pool.h"
+
+#include <string.h>
+
+static void count_call(size_t index, void* data) {
+  int* calls = (int*) data;
+  calls[index]++;
+}
+
+TEST(test_thread_pool_runs_every_task_once)
+  int calls[1000];
+  size_t thread_counts[] = { 0, 1, 2, 7, 64 };
+
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+    memset(calls, 0, sizeof(calls));
+
+    hb_thread_pool_run(1000, thread_counts[i], count_call, calls);
+
+    for (size_t index = 0; index < 1000; index++) {
+      ck_assert_int_eq(calls[index], 1);
+    }
+  }
+END
+
+TEST(test_thread_pool_more_threads_than_tasks)
+  int calls[3] = { 0 };
+
+  hb_thread_pool_run(3, 16, count_call, calls);
+
+  ck_assert_int_eq(calls[0], 1);
+  ck_assert_int_eq(calls[1], 1);
+  ck_assert_int_eq(calls[2], 1);
+
+  hb_thread_pool_run(0, 4, count_call, NULL);
+END
+
+TEST(test_thread_pool_default_size)
+  ck_assert_int_ge(hb_thread_pool_default_size(), 1);
+END
+
+TCase *hb_thread_pool_tests(void) {
+  TCase *thread_pool = tcase_create("Thread Pool");
+
+  tcase_add_test(thread_pool, test_thread_pool_runs_every_task_once);
+  tcase_add_test(thread_pool, test_thread_pool_more_threads_than_tasks);
+  tcase_add_test(thread_pool, test_thread_pool_default_size);
+
+  return thread_pool;
+}
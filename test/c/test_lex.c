@@ -34,11 +34,63 @@ TEST(herb_lex_to_buffer_basic_tag)
   free(output.value);
 END
 
+TEST(herb_lex_to_buffer_erb_content)
+  char* html = "<%= items.map { |item|\n  item.name } -%><% a %%><% unclosed";
+  hb_buffer_T output;
+  hb_buffer_init(&output, 1024);
+
+  herb_lex_to_buffer(html, &output);
+
+  ck_assert_str_eq(
+    output.value,
+    "#<Herb::Token type=\"TOKEN_ERB_START\" value=\"<%=\" range=[0, 3] start=(1:0) end=(1:3)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_CONTENT\" value=\" items.map { |item|\\n  item.name } \" range=[3, 37] start=(1:3) end=(2:14)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_END\" value=\"-%>\" range=[37, 40] start=(2:14) end=(2:17)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_START\" value=\"<%\" range=[40, 42] start=(2:17) end=(2:19)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_CONTENT\" value=\" a \" range=[42, 45] start=(2:19) end=(2:22)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_END\" value=\"%%>\" range=[45, 48] start=(2:22) end=(2:25)>\n"
+    "#<Herb::Token type=\"TOKEN_ERB_START\" value=\"<%\" range=[48, 50] start=(2:25) end=(2:27)>\n"
+    "#<Herb::Token type=\"TOKEN_ERROR\" value=\" unclosed\" range=[50, 59] start=(2:27) end=(2:36)>\n"
+    "#<Herb::Token type=\"TOKEN_EOF\" value=\"<EOF>\" range=[59, 59] start=(2:36) end=(2:36)>\n"
+  );
+
+  free(output.value);
+END
+
+TEST(herb_lexer_next_matches_herb_lex)
+  const char* source = "<div class=\"a\">\r\n  <%= title %> text</div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  herb_lexer_T lexer;
+  herb_lexer_init(&lexer, source);
+
+  const token_T* token = NULL;
+  size_t count = 0;
+
+  while ((token = herb_lexer_next(&lexer)) != NULL) {
+    const token_T* expected = hb_array_get(tokens, count++);
+
+    ck_assert_ptr_eq(token, &lexer.token);
+    ck_assert_int_eq(token->type, expected->type);
+    ck_assert_int_eq(token->range.from, expected->range.from);
+    ck_assert_int_eq(token->range.to, expected->range.to);
+    ck_assert_int_eq(token->location.end.line, expected->location.end.line);
+    ck_assert_int_eq(token->location.end.column, expected->location.end.column);
+  }
+
+  ck_assert_int_eq(count, hb_array_size(tokens));
+  ck_assert_ptr_null(herb_lexer_next(&lexer));
+
+  herb_free_tokens(&tokens);
+END
+
 TCase *lex_tests(void) {
   TCase *tags = tcase_create("Lex");
 
   tcase_add_test(tags, herb_lex_to_buffer_empty_file);
   tcase_add_test(tags, herb_lex_to_buffer_basic_tag);
+  tcase_add_test(tags, herb_lex_to_buffer_erb_content);
+  tcase_add_test(tags, herb_lexer_next_matches_herb_lex);
 
   return tags;
 }
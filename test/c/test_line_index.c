@@ -0,0 +1,112 @@
+#include "include/test.h"
+#include "../../src/include/herb.h"
+#include "../../src/include/line_index.h"
+#include "../../src/include/token_struct.h"
+
+#include <string.h>
+
+static line_index_T* index_for(const char* source) {
+  return line_index_init(source, strlen(source));
+}
+
+TEST(test_line_index_line_starts)
+  line_index_T* index = index_for("ab\ncd\n\nef");
+
+  ck_assert_int_eq(line_index_line_count(index), 4);
+  ck_assert_int_eq(line_index_line_start(index, 1), 0);
+  ck_assert_int_eq(line_index_line_start(index, 2), 3);
+  ck_assert_int_eq(line_index_line_start(index, 3), 6);
+  ck_assert_int_eq(line_index_line_start(index, 4), 7);
+  ck_assert_int_eq(line_index_line_start(index, 9), 7);
+
+  line_index_free(&index);
+  ck_assert_ptr_null(index);
+END
+
+TEST(test_line_index_carriage_returns)
+  line_index_T* index = index_for("a\r\nb\rc\n");
+
+  ck_assert_int_eq(line_index_line_count(index), 4);
+  ck_assert_int_eq(line_index_line_start(index, 2), 3);
+  ck_assert_int_eq(line_index_line_start(index, 3), 5);
+  ck_assert_int_eq(line_index_line_start(index, 4), 7);
+
+  position_T position = line_index_position(index, 1);
+  ck_assert_int_eq(position.line, 1);
+  ck_assert_int_eq(position.column, 1);
+
+  ck_assert_int_eq(line_index_offset(index, (position_T) { .line = 1, .column = 10 }), 1);
+
+  line_index_free(&index);
+END
+
+TEST(test_line_index_position_and_offset)
+  const char* source = "<div>\n  <%= title %>\n</div>";
+  line_index_T* index = index_for(source);
+
+  position_T position = line_index_position(index, 10);
+  ck_assert_int_eq(position.line, 2);
+  ck_assert_int_eq(position.column, 4);
+  ck_assert_int_eq(line_index_offset(index, position), 10);
+
+  position_T end = line_index_position(index, 1000);
+  ck_assert_int_eq(end.line, 3);
+  ck_assert_int_eq(end.column, 6);
+
+  for (uint32_t offset = 0; offset <= strlen(source); offset++) {
+    ck_assert_int_eq(line_index_offset(index, line_index_position(index, offset)), offset);
+  }
+
+  line_index_free(&index);
+END
+
+TEST(test_line_index_utf16_columns)
+  // "é" is 2 bytes and 1 UTF-16 unit, "😀" is 4 bytes and 2 UTF-16 units
+  const char* source = "x\né😀y";
+  line_index_T* index = index_for(source);
+
+  position_T position = line_index_utf16_position(index, 8);
+  ck_assert_int_eq(position.line, 2);
+  ck_assert_int_eq(position.column, 3);
+
+  ck_assert_int_eq(line_index_offset_from_utf16(index, (position_T) { .line = 2, .column = 1 }), 4);
+  ck_assert_int_eq(line_index_offset_from_utf16(index, (position_T) { .line = 2, .column = 2 }), 4);
+  ck_assert_int_eq(line_index_offset_from_utf16(index, (position_T) { .line = 2, .column = 3 }), 8);
+  ck_assert_int_eq(line_index_offset_from_utf16(index, (position_T) { .line = 2, .column = 99 }), 9);
+
+  line_index_free(&index);
+END
+
+TEST(test_line_index_matches_token_locations)
+  const char* source = "<div>\r\n<% if true\r\n  x = 1\r\n%>\r\n<%= y\r %>\r\n</div>\r\n<% z";
+
+  line_index_T* index = index_for(source);
+  hb_array_T* tokens = herb_lex(source);
+
+  for (size_t i = 0; i < hb_array_size(tokens); i++) {
+    token_T* token = hb_array_get(tokens, i);
+
+    position_T start = line_index_position(index, token->range.from);
+    position_T end = line_index_position(index, token->range.to);
+
+    ck_assert_int_eq(start.line, token->location.start.line);
+    ck_assert_int_eq(start.column, token->location.start.column);
+    ck_assert_int_eq(end.line, token->location.end.line);
+    ck_assert_int_eq(end.column, token->location.end.column);
+  }
+
+  herb_free_tokens(&tokens);
+  line_index_free(&index);
+END
+
+TCase *line_index_tests(void) {
+  TCase *line_index = tcase_create("Line Index");
+
+  tcase_add_test(line_index, test_line_index_line_starts);
+  tcase_add_test(line_index, test_line_index_carriage_returns);
+  tcase_add_test(line_index, test_line_index_position_and_offset);
+  tcase_add_test(line_index, test_line_index_utf16_columns);
+  tcase_add_test(line_index, test_line_index_matches_token_locations);
+
+  return line_index;
+}
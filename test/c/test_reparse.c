@@ -0,0 +1,117 @@
+#include "include/test.h"
+#include "../../src/include/analyze.h"
+#include "../../src/include/ast_pretty_print.h"
+#include "../../src/include/herb.h"
+#include "../../src/include/reparse.h"
+
+#include <string.h>
+
+static char* pretty_print(AST_DOCUMENT_NODE_T* document) {
+  hb_buffer_T output;
+  hb_buffer_init(&output, 1024);
+  ast_pretty_print_node((AST_NODE_T*) document, 0, 0, &output);
+
+  return output.value;
+}
+
+static AST_DOCUMENT_NODE_T* parse_and_analyze(const char* source) {
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+  herb_analyze_parse_tree(document, source);
+
+  return document;
+}
+
+static void assert_reparse_matches_full_parse(AST_DOCUMENT_NODE_T* reparsed, const char* source) {
+  AST_DOCUMENT_NODE_T* expected = parse_and_analyze(source);
+
+  char* expected_output = pretty_print(expected);
+  char* actual_output = pretty_print(reparsed);
+
+  ck_assert_str_eq(actual_output, expected_output);
+
+  free(expected_output);
+  free(actual_output);
+  ast_node_free((AST_NODE_T*) expected);
+}
+
+TEST(test_edit_from_sources)
+  herb_edit_T edit = herb_edit_from_sources("<p>abc</p>", 10, "<p>aXYc</p>", 11);
+
+  ck_assert_int_eq(edit.start, 4);
+  ck_assert_int_eq(edit.old_end, 5);
+  ck_assert_int_eq(edit.new_end, 6);
+
+  edit = herb_edit_from_sources("aaa", 3, "aaaa", 4);
+
+  ck_assert_int_eq(edit.start, 3);
+  ck_assert_int_eq(edit.old_end, 3);
+  ck_assert_int_eq(edit.new_end, 4);
+END
+
+TEST(test_reparse_reuses_untouched_nodes)
+  char* old_source = strdup("<div>a</div>\n<p><%= b %></p>\n<span>\n  c\n</span>");
+  const char* source = "<div>a</div>\n<p><%= long_name %>\nx</p>\n<span>\n  c\n</span>";
+
+  AST_DOCUMENT_NODE_T* document = parse_and_analyze(old_source);
+  AST_NODE_T* div = hb_array_get(document->children, 0);
+  AST_NODE_T* span = hb_array_get(document->children, 4);
+
+  herb_edit_T edit = herb_edit_from_sources(old_source, strlen(old_source), source, strlen(source));
+  AST_DOCUMENT_NODE_T* reparsed =
+    herb_reparse_n(document, old_source, strlen(old_source), source, strlen(source), edit, NULL);
+
+  // The tokens of reused nodes must point into the new source.
+  free(old_source);
+
+  ck_assert_ptr_eq(reparsed, document);
+  ck_assert_ptr_eq(hb_array_get(reparsed->children, 0), div);
+  ck_assert_ptr_eq(hb_array_get(reparsed->children, 4), span);
+  ck_assert_int_eq(span->location.start.line, 4);
+
+  assert_reparse_matches_full_parse(reparsed, source);
+
+  ast_node_free((AST_NODE_T*) reparsed);
+END
+
+TEST(test_reparse_falls_back_on_errors)
+  const char* old_source = "<div>a</div><p>b</p>";
+  const char* source = "<div>a</div><span><p>b</p>";
+
+  AST_DOCUMENT_NODE_T* document = parse_and_analyze(old_source);
+
+  herb_edit_T edit = herb_edit_from_sources(old_source, strlen(old_source), source, strlen(source));
+  AST_DOCUMENT_NODE_T* reparsed =
+    herb_reparse_n(document, old_source, strlen(old_source), source, strlen(source), edit, NULL);
+
+  ck_assert_int_gt(ast_node_errors_count(hb_array_get(reparsed->children, 1)), 0);
+  assert_reparse_matches_full_parse(reparsed, source);
+
+  ast_node_free((AST_NODE_T*) reparsed);
+END
+
+TEST(test_reparse_merges_text)
+  const char* old_source = "one <b>two</b> three";
+  const char* source = "one two three";
+
+  AST_DOCUMENT_NODE_T* document = parse_and_analyze(old_source);
+
+  herb_edit_T edit = herb_edit_from_sources(old_source, strlen(old_source), source, strlen(source));
+  AST_DOCUMENT_NODE_T* reparsed =
+    herb_reparse_n(document, old_source, strlen(old_source), source, strlen(source), edit, NULL);
+
+  ck_assert_int_eq(hb_array_size(reparsed->children), 1);
+  assert_reparse_matches_full_parse(reparsed, source);
+
+  ast_node_free((AST_NODE_T*) reparsed);
+END
+
+TCase *reparse_tests(void) {
+  TCase *reparse = tcase_create("Reparse");
+
+  tcase_add_test(reparse, test_edit_from_sources);
+  tcase_add_test(reparse, test_reparse_reuses_untouched_nodes);
+  tcase_add_test(reparse, test_reparse_falls_back_on_errors);
+  tcase_add_test(reparse, test_reparse_merges_text);
+
+  return reparse;
+}
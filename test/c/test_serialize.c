@@ -0,0 +1,112 @@
+#include "include/test.h"
+#include "../../src/include/herb.h"
+#include "../../src/include/ast_serialize.h"
+#include "../../src/include/token.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+  const uint8_t* data;
+  size_t position;
+} reader_T;
+
+static uint64_t read_varint(reader_T* reader) {
+  uint64_t value = 0;
+  int shift = 0;
+
+  while (reader->data[reader->position] & 0x80) {
+    value |= (uint64_t) (reader->data[reader->position++] & 0x7F) << shift;
+    shift += 7;
+  }
+
+  return value | ((uint64_t) reader->data[reader->position++] << shift);
+}
+
+static void assert_string(reader_T* reader, const char* expected) {
+  uint64_t length = read_varint(reader);
+
+  ck_assert_uint_eq(length, strlen(expected) + 1);
+  ck_assert(memcmp(reader->data + reader->position, expected, length - 1) == 0);
+
+  reader->position += length - 1;
+}
+
+static void assert_location(reader_T* reader, uint64_t start_line, uint64_t start_column, uint64_t end_line, uint64_t end_column) {
+  ck_assert_uint_eq(read_varint(reader), start_line);
+  ck_assert_uint_eq(read_varint(reader), start_column);
+  ck_assert_uint_eq(read_varint(reader), end_line);
+  ck_assert_uint_eq(read_varint(reader), end_column);
+}
+
+TEST(test_serialize_header)
+  hb_buffer_T output;
+  hb_buffer_init(&output, 1024);
+
+  AST_DOCUMENT_NODE_T* document = herb_parse("", NULL);
+  herb_serialize(document, &output);
+
+  reader_T reader = { .data = (const uint8_t*) output.value, .position = 0 };
+
+  ck_assert(memcmp(output.value, "HERB", 4) == 0);
+  reader.position = 4;
+
+  ck_assert_uint_eq(reader.data[reader.position++], HERB_SERIALIZATION_VERSION);
+  ck_assert_uint_eq(reader.data[reader.position++], 0);
+
+  ck_assert_uint_eq(read_varint(&reader), TOKEN_EOF + 1);
+
+  for (int type = 0; type <= TOKEN_EOF; type++) {
+    assert_string(&reader, token_type_to_string((token_type_T) type));
+  }
+
+  ck_assert_uint_eq(read_varint(&reader), AST_DOCUMENT_NODE + 1);
+  assert_location(&reader, 1, 0, 1, 0);
+  ck_assert_uint_eq(read_varint(&reader), 0);
+  ck_assert_uint_eq(read_varint(&reader), 0);
+
+  ck_assert_uint_eq(reader.position, hb_buffer_length(&output));
+
+  ast_node_free((AST_NODE_T*) document);
+  free(output.value);
+END
+
+TEST(test_serialize_nodes)
+  hb_buffer_T output;
+  hb_buffer_init(&output, 1024);
+
+  AST_DOCUMENT_NODE_T* document = herb_parse("hello", NULL);
+  herb_serialize(document, &output);
+
+  reader_T reader = { .data = (const uint8_t*) output.value, .position = 6 };
+
+  uint64_t token_type_count = read_varint(&reader);
+
+  for (uint64_t i = 0; i < token_type_count; i++) {
+    reader.position += read_varint(&reader) - 1;
+  }
+
+  ck_assert_uint_eq(read_varint(&reader), AST_DOCUMENT_NODE + 1);
+  assert_location(&reader, 1, 0, 1, 5);
+  ck_assert_uint_eq(read_varint(&reader), 0);
+  ck_assert_uint_eq(read_varint(&reader), 1);
+
+  ck_assert_uint_eq(read_varint(&reader), AST_HTML_TEXT_NODE + 1);
+  assert_location(&reader, 1, 0, 1, 5);
+  ck_assert_uint_eq(read_varint(&reader), 0);
+  assert_string(&reader, "hello");
+
+  ck_assert_uint_eq(reader.position, hb_buffer_length(&output));
+
+  ast_node_free((AST_NODE_T*) document);
+  free(output.value);
+END
+
+TCase *serialize_tests(void) {
+  TCase *serialize = tcase_create("Serialize");
+
+  tcase_add_test(serialize, test_serialize_header);
+  tcase_add_test(serialize, test_serialize_nodes);
+
+  return serialize;
+}
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include "include/test.h"
 #include "../../src/include/herb.h"
+#include "../../src/include/lexer.h"
 #include "../../src/include/token.h"
+#include "../../src/include/util.h"
 
 TEST(test_token)
   ck_assert_str_eq(token_type_to_string(TOKEN_IDENTIFIER), "TOKEN_IDENTIFIER");
@@ -21,11 +23,69 @@ TEST(test_token_to_string)
   free(output.value);
 END
 
+TEST(test_token_value_is_view_into_source)
+  const char* source = "<div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  token_T* tag_name = hb_array_get(tokens, 1);
+  ck_assert_ptr_eq(tag_name->value.data, source + 1);
+  ck_assert_uint_eq(tag_name->value.length, 3);
+
+  herb_free_tokens(&tokens);
+END
+
+TEST(test_token_copy_owned)
+  char* source = herb_strdup("<div>");
+  hb_array_T* tokens = herb_lex(source);
+
+  token_T* owned = token_copy_owned(hb_array_get(tokens, 1));
+
+  herb_free_tokens(&tokens);
+  free(source);
+
+  ck_assert(hb_string_equals(owned->value, hb_string("div")));
+  ck_assert_int_eq(owned->value.data[owned->value.length], '\0');
+
+  token_free(owned);
+END
+
+TEST(test_token_lexer_error_message)
+  lexer_T lexer = { 0 };
+  lexer_init(&lexer, "<div>");
+
+  token_T* error = lexer_error(&lexer, "Something went wrong");
+
+  ck_assert_int_eq(error->type, TOKEN_ERROR);
+  ck_assert(hb_string_equals(error->value, hb_string("[Lexer] Error: Something went wrong (character '<', line 1, col 0)\n")));
+
+  token_T* copy = token_copy(error);
+  token_free(error);
+
+  ck_assert(hb_string_equals(copy->value, hb_string("[Lexer] Error: Something went wrong (character '<', line 1, col 0)\n")));
+
+  token_free(copy);
+END
+
+TEST(test_token_lexer_error_message_in_token_slot)
+  herb_lexer_T lexer;
+  herb_lexer_init(&lexer, "<div>");
+
+  token_T* error = lexer_error(&lexer.lexer, "Something went wrong");
+
+  ck_assert_ptr_eq(error, &lexer.token);
+  ck_assert_ptr_eq(error->value.data, lexer.lexer.error_message);
+  ck_assert(hb_string_equals(error->value, hb_string("[Lexer] Error: Something went wrong (character '<', line 1, col 0)\n")));
+END
+
 TCase *token_tests(void) {
   TCase *token = tcase_create("Token");
 
   tcase_add_test(token, test_token);
   tcase_add_test(token, test_token_to_string);
+  tcase_add_test(token, test_token_value_is_view_into_source);
+  tcase_add_test(token, test_token_copy_owned);
+  tcase_add_test(token, test_token_lexer_error_message);
+  tcase_add_test(token, test_token_lexer_error_message_in_token_slot);
 
   return token;
 }
@@ -0,0 +1,156 @@
+#include "include/test.h"
+#include "../../src/include/herb.h"
+#include "../../src/include/token_stream.h"
+
+TEST(test_token_stream_matches_herb_lex)
+  const char* source = "<div class=\"a\">\n  <%= title %> é</div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  herb_token_stream_T stream;
+  herb_token_stream_init(&stream, source);
+
+  ck_assert_int_eq(stream.size, hb_array_size(tokens));
+
+  for (size_t i = 0; i < stream.size; i++) {
+    const token_T* token = hb_array_get(tokens, i);
+
+    ck_assert_int_eq(herb_token_stream_type(&stream, i), token->type);
+    ck_assert_int_eq(stream.starts[i], token->range.from);
+    ck_assert_int_eq(stream.ends[i], token->range.to);
+    ck_assert(hb_string_equals(herb_token_stream_value(&stream, i), token->value));
+  }
+
+  ck_assert_int_eq(herb_token_stream_type(&stream, stream.size - 1), TOKEN_EOF);
+
+  herb_free_tokens(&tokens);
+  herb_token_stream_free(&stream);
+END
+
+TEST(test_token_stream_columns_are_contiguous)
+  herb_token_stream_T stream;
+  herb_token_stream_init(&stream, "<p>hello</p>");
+
+  ck_assert_ptr_eq(stream.ends, stream.starts + stream.size);
+  ck_assert_ptr_eq(stream.types, (uint8_t*) (stream.ends + stream.size));
+
+  herb_token_stream_free(&stream);
+  ck_assert_ptr_null(stream.starts);
+END
+
+TEST(test_token_stream_positions)
+  herb_token_stream_T stream;
+  herb_token_stream_init(&stream, "<p>\r\n<% x %></p>");
+
+  ck_assert_ptr_null(stream.line_index);
+
+  // TOKEN_ERB_START after the newline
+  ck_assert_int_eq(herb_token_stream_type(&stream, 4), TOKEN_ERB_START);
+
+  position_T start = herb_token_stream_start(&stream, 4);
+  position_T end = herb_token_stream_end(&stream, 4);
+
+  ck_assert_ptr_nonnull(stream.line_index);
+  ck_assert_int_eq(start.line, 2);
+  ck_assert_int_eq(start.column, 0);
+  ck_assert_int_eq(end.line, 2);
+  ck_assert_int_eq(end.column, 2);
+
+  herb_token_stream_free(&stream);
+  ck_assert_ptr_null(stream.line_index);
+END
+
+TEST(test_token_stream_positions_match_herb_lex)
+  const char* sources[] = {
+    "é<div>",
+    "<div title=\"é\" id=\"x\">",
+    "<!-- é --><b>",
+    "<% é %><b>é</b>",
+    "é\r\n  é<br>",
+    "<script>é</script><b>",
+  };
+
+  for (size_t s = 0; s < sizeof(sources) / sizeof(sources[0]); s++) {
+    hb_array_T* tokens = herb_lex(sources[s]);
+
+    herb_token_stream_T stream;
+    herb_token_stream_init(&stream, sources[s]);
+
+    for (size_t i = 0; i < stream.size; i++) {
+      const token_T* token = hb_array_get(tokens, i);
+      position_T start = herb_token_stream_start(&stream, i);
+      position_T end = herb_token_stream_end(&stream, i);
+
+      ck_assert_int_eq(start.line, token->location.start.line);
+      ck_assert_int_eq(start.column, token->location.start.column);
+      ck_assert_int_eq(end.line, token->location.end.line);
+      ck_assert_int_eq(end.column, token->location.end.column);
+    }
+
+    // Out of order, which can't continue from the previous position.
+    position_T first = herb_token_stream_end(&stream, 0);
+    const token_T* token = hb_array_get(tokens, 0);
+    ck_assert_int_eq(first.column, token->location.end.column);
+
+    herb_free_tokens(&tokens);
+    herb_token_stream_free(&stream);
+  }
+END
+
+TEST(test_token_stream_matches_herb_lex_on_crlf_and_multibyte_input)
+  const char* sources[] = {
+    "<p>é</p>\r\n<% if é\r\n  x = 1\r\n%>\r\n<b>é</b>",
+    "<div title=\"é\r\né\">\r\n  é<%= é %>é\r\n</div>",
+    "<b>é</b>\r\n<% é\r\n é",
+    "é<% é",
+    "\r\né\ré\n<%# é\r %>",
+  };
+
+  for (size_t s = 0; s < sizeof(sources) / sizeof(sources[0]); s++) {
+    hb_array_T* tokens = herb_lex(sources[s]);
+
+    herb_token_stream_T stream;
+    herb_token_stream_init(&stream, sources[s]);
+
+    ck_assert_int_eq(stream.size, hb_array_size(tokens));
+
+    for (size_t i = 0; i < stream.size; i++) {
+      const token_T* token = hb_array_get(tokens, i);
+      position_T start = herb_token_stream_start(&stream, i);
+      position_T end = herb_token_stream_end(&stream, i);
+
+      ck_assert_int_eq(herb_token_stream_type(&stream, i), token->type);
+      ck_assert_int_eq(stream.starts[i], token->range.from);
+      ck_assert_int_eq(stream.ends[i], token->range.to);
+      ck_assert_int_eq(start.line, token->location.start.line);
+      ck_assert_int_eq(start.column, token->location.start.column);
+      ck_assert_int_eq(end.line, token->location.end.line);
+      ck_assert_int_eq(end.column, token->location.end.column);
+    }
+
+    herb_free_tokens(&tokens);
+    herb_token_stream_free(&stream);
+  }
+END
+
+TEST(test_token_stream_empty_source)
+  herb_token_stream_T stream;
+  herb_token_stream_init(&stream, NULL);
+
+  ck_assert_int_eq(stream.size, 1);
+  ck_assert_int_eq(herb_token_stream_type(&stream, 0), TOKEN_EOF);
+
+  herb_token_stream_free(&stream);
+END
+
+TCase *token_stream_tests(void) {
+  TCase *token_stream = tcase_create("Token Stream");
+
+  tcase_add_test(token_stream, test_token_stream_matches_herb_lex);
+  tcase_add_test(token_stream, test_token_stream_columns_are_contiguous);
+  tcase_add_test(token_stream, test_token_stream_positions);
+  tcase_add_test(token_stream, test_token_stream_positions_match_herb_lex);
+  tcase_add_test(token_stream, test_token_stream_matches_herb_lex_on_crlf_and_multibyte_input);
+  tcase_add_test(token_stream, test_token_stream_empty_source);
+
+  return token_stream;
+}
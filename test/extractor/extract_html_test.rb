@@ -42,5 +42,11 @@ module Extractor
         actual
       )
     end
+
+    test "NUL bytes" do
+      actual = Herb.extract_html("<p>a\0b</p><%= x %>")
+
+      assert_equal "<p>a\0b</p>        ", actual
+    end
   end
 end
@@ -105,6 +105,12 @@ module Extractor
       assert_equal expected, actual
     end
 
+    test "NUL bytes" do
+      actual = Herb.extract_ruby("<p>a\0b</p><%= x\0 %>")
+
+      assert_equal "              x\0  ;", actual
+    end
+
     xtest "erb if/end and Ruby comment on same line" do
       actual = Herb.extract_ruby(<<~HTML)
         <% if %><% # comment %><% end %>
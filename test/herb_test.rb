@@ -6,4 +6,20 @@ class HerbTest < Minitest::Spec
   test "version" do
     assert_equal "herb gem v0.8.2, libprism v1.6.0, libherb v0.8.2 (Ruby C native extension)", Herb.version
   end
+
+  test "type names are shared frozen strings" do
+    document = Herb.parse("<div></div>").value
+    element = document.children.first
+    error = Herb.parse("<div>").value.children.first.errors.first
+    tokens = Herb.lex("<p>").value
+
+    assert_equal "AST_HTML_ELEMENT_NODE", element.type
+    assert_same element.type, Herb.parse("<p></p>").value.children.first.type
+    assert_same error.type, Herb.parse("<p>").value.children.first.errors.first.type
+    assert_same tokens[0].type, Herb.lex("<a>").value[0].type
+
+    assert_predicate document.type, :frozen?
+    assert_predicate tokens.last.type, :frozen?
+    assert_equal Encoding::UTF_8, tokens.last.type.encoding
+  end
 end
@@ -0,0 +1,39 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+class LineIndexTest < Minitest::Spec
+  test "counts lines for every line ending" do
+    index = Herb::LineIndex.new("a\nb\r\nc\rd")
+
+    assert_equal 4, index.line_count
+    assert_equal 0, index.line_start(1)
+    assert_equal 2, index.line_start(2)
+    assert_equal 5, index.line_start(3)
+    assert_equal 7, index.line_start(4)
+  end
+
+  test "converts between offsets and positions" do
+    index = Herb::LineIndex.new("<div>\n  <%= foo %>\n</div>")
+
+    position = index.position_at(10)
+
+    assert_equal 2, position.line
+    assert_equal 4, position.column
+    assert_equal 10, index.offset_at(2, 4)
+  end
+
+  test "converts between offsets and UTF-16 positions" do
+    index = Herb::LineIndex.new("é\n😀x")
+
+    position = index.utf16_position_at(7)
+
+    assert_equal 2, position.line
+    assert_equal 2, position.column
+    assert_equal 7, index.offset_at_utf16(2, 2)
+  end
+
+  test "requires a string" do
+    assert_raises(TypeError) { Herb::LineIndex.new(nil) }
+  end
+end
@@ -0,0 +1,38 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+require "timeout"
+
+class ThreadTest < Minitest::Spec
+  SOURCE = %(<div class="a"><% if x %><p><%= y %></p><% end %></div>\n) * 10
+
+  test "parsing from several threads returns the same results" do
+    expected = Herb.parse(SOURCE).value.inspect
+
+    results = Array.new(4) do
+      Thread.new { Array.new(5) { Herb.parse(SOURCE).value.inspect } }
+    end.flat_map(&:value)
+
+    assert(results.all? { |result| result == expected })
+  end
+
+  test "lexing from several threads returns the same tokens" do
+    expected = Herb.lex(SOURCE).value.map(&:inspect)
+
+    results = Array.new(4) do
+      Thread.new { Herb.lex(SOURCE).value.map(&:inspect) }
+    end.map(&:value)
+
+    assert(results.all? { |result| result == expected })
+  end
+
+  test "a long parse can be interrupted" do
+    source = SOURCE * 10_000
+
+    assert_raises(Timeout::Error) do
+      Timeout.timeout(0.01) { Herb.parse(source) }
+    end
+
+    assert_equal 1, Herb.parse("<p></p>").value.children.size
+  end
+end
@@ -0,0 +1,47 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+class TokenStreamTest < Minitest::Spec
+  test "matches Herb.lex on CRLF and multibyte input" do
+    [
+      "<p>é</p>\r\n<% if é\r\n  x = 1\r\n%>\r\n<b>é</b>",
+      "<div title=\"é\r\né\">\r\n  é<%= é %>é\r\n</div>",
+      "<b>é</b>\r\n<% é\r\n é",
+    ].each do |source|
+      tokens = Herb.lex(source).value
+      stream = Herb::TokenStream.new(source)
+
+      assert_equal tokens.size, stream.size
+
+      tokens.each_with_index do |token, index|
+        assert_equal token.type, stream.type(index)
+        assert_equal token.range.to_a, stream.range(index).to_a
+        location = stream.location(index)
+
+        assert_equal [token.location.start.line, token.location.start.column], [location.start.line, location.start.column]
+        assert_equal [token.location.end.line, token.location.end.column], [location.end.line, location.end.column]
+      end
+    end
+  end
+
+  test "returns the source bytes of a token" do
+    stream = Herb::TokenStream.new("<p>é</p>")
+
+    assert_equal "TOKEN_HTML_TAG_START", stream.type(0)
+    assert_equal "<", stream.value(0)
+    assert_equal "é", stream.value(3)
+    assert_equal "TOKEN_EOF", stream.type(stream.size - 1)
+  end
+
+  test "raises for an index outside of the stream" do
+    stream = Herb::TokenStream.new("<p>")
+
+    assert_raises(IndexError) { stream.type(stream.size) }
+    assert_raises(IndexError) { stream.range(-1) }
+  end
+
+  test "requires a string" do
+    assert_raises(TypeError) { Herb::TokenStream.new(nil) }
+  end
+end
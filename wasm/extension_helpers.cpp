@@ -76,8 +76,8 @@ val CreateToken(token_T* token) {
   val Object = val::global("Object");
   val result = Object.new_();
 
-  if (token->value) {
-    result.set("value", std::string(token->value));
+  if (token->value.data) {
+    result.set("value", std::string(token->value.data, token->value.length));
   } else {
     result.set("value", val::null());
   }
@@ -128,6 +128,7 @@ val CreateParseResult(AST_DOCUMENT_NODE_T *root, const std::string& source){
   result.set("source", val(source));
   result.set("warnings", warningsArray);
   result.set("errors", errorsArray);
+  result.set("cancelled", val(root->cancelled));
 
   return result;
 }
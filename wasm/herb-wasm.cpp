@@ -1,8 +1,10 @@
+#include <chrono>
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #include "extension_helpers.h"
 
@@ -15,17 +17,20 @@ extern "C" {
 #include "../src/include/util/hb_buffer.h"
 #include "../src/include/extract.h"
 #include "../src/include/herb.h"
+#include "../src/include/line_index.h"
 #include "../src/include/location.h"
 #include "../src/include/position.h"
 #include "../src/include/pretty_print.h"
 #include "../src/include/range.h"
+#include "../src/include/reparse.h"
+#include "../src/include/ast_serialize.h"
 #include "../src/include/token.h"
 }
 
 using namespace emscripten;
 
 val Herb_lex(const std::string& source) {
-  hb_array_T* tokens = herb_lex(source.c_str());
+  hb_array_T* tokens = herb_lex_n(source.data(), source.length());
 
   val result = CreateLexResult(tokens, source);
 
@@ -34,23 +39,66 @@ val Herb_lex(const std::string& source) {
   return result;
 }
 
+// Cancel callback for the `timeout` option, `data` is the deadline.
+static bool ParseDeadlinePassed(void* data) {
+  return std::chrono::steady_clock::now() >= *static_cast<std::chrono::steady_clock::time_point*>(data);
+}
+
+// Reads the `ParserOptions` object `options` into `parser_options`. `timeout_ms` is negative without a `timeout`.
+// Returns whether an option differs from the defaults.
+static bool ReadParserOptions(val options, parser_options_T* parser_options, double* timeout_ms) {
+  *timeout_ms = -1;
+
+  if (options.isUndefined() || options.isNull() || options.typeOf().as<std::string>() != "object") { return false; }
+
+  bool changed = false;
+
+  if (options.hasOwnProperty("track_whitespace")) {
+    bool track_whitespace = options["track_whitespace"].as<bool>();
+    if (track_whitespace) {
+      parser_options->track_whitespace = true;
+      changed = true;
+    }
+  }
+
+  if (options.hasOwnProperty("timeout") && options["timeout"].isNumber() && options["timeout"].as<double>() >= 0) {
+    *timeout_ms = options["timeout"].as<double>();
+    changed = true;
+  }
+
+  return changed;
+}
+
+// Points `parser_options` at `deadline`, `timeout_ms` from now.
+static void StartParseDeadline(
+  parser_options_T* parser_options,
+  double timeout_ms,
+  std::chrono::steady_clock::time_point* deadline
+) {
+  *deadline = std::chrono::steady_clock::now()
+    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double, std::milli>(timeout_ms)
+    );
+
+  parser_options->cancel = ParseDeadlinePassed;
+  parser_options->cancel_data = deadline;
+}
+
 val Herb_parse(const std::string& source, val options) {
   parser_options_T* parser_options = nullptr;
   parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
 
-  if (!options.isUndefined() && !options.isNull() && options.typeOf().as<std::string>() == "object") {
-    if (options.hasOwnProperty("track_whitespace")) {
-      bool track_whitespace = options["track_whitespace"].as<bool>();
-      if (track_whitespace) {
-        opts.track_whitespace = true;
-        parser_options = &opts;
-      }
-    }
+  if (ReadParserOptions(options, &opts, &timeout_ms)) {
+    if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+    parser_options = &opts;
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(source.c_str(), parser_options);
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(source.data(), source.length(), parser_options);
 
-  herb_analyze_parse_tree(root, source.c_str());
+  herb_analyze_parse_tree_cancellable_n(root, source.data(), source.length(), opts.cancel, opts.cancel_data);
 
   val result = CreateParseResult(root, source);
 
@@ -59,12 +107,110 @@ val Herb_parse(const std::string& source, val options) {
   return result;
 }
 
+// Like Herb_parse, but returns the document as a Uint8Array in the format of herb_serialize(),
+// which is decoded on the JavaScript side instead of creating every object through embind.
+val Herb_parse_serialized(const std::string& source, val options) {
+  parser_options_T* parser_options = nullptr;
+  parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
+
+  if (ReadParserOptions(options, &opts, &timeout_ms)) {
+    if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+    parser_options = &opts;
+  }
+
+  AST_DOCUMENT_NODE_T* root = herb_parse_n(source.data(), source.length(), parser_options);
+
+  herb_analyze_parse_tree_cancellable_n(root, source.data(), source.length(), opts.cancel, opts.cancel_data);
+
+  hb_buffer_T output;
+  hb_buffer_init(&output, source.length());
+
+  herb_serialize(root, &output);
+
+  // Copies the bytes out of the WebAssembly memory, which the buffer is freed from below.
+  val result = val::global("Uint8Array").new_(
+    typed_memory_view(hb_buffer_length(&output), reinterpret_cast<const uint8_t*>(hb_buffer_value(&output)))
+  );
+
+  free(output.value);
+  ast_node_free((AST_NODE_T *) root);
+
+  return result;
+}
+
+// Without thread support in the WebAssembly build herb_*_batch() does its work on the calling thread.
+static std::vector<herb_source_T> BatchSources(const std::vector<std::string>& strings) {
+  std::vector<herb_source_T> sources;
+  sources.reserve(strings.size());
+
+  for (const std::string& string : strings) {
+    sources.push_back({ string.data(), string.length() });
+  }
+
+  return sources;
+}
+
+static size_t ReadThreadCount(val options) {
+  if (options.isUndefined() || options.isNull() || options.typeOf().as<std::string>() != "object") { return 0; }
+  if (!options.hasOwnProperty("threads") || !options["threads"].isNumber()) { return 0; }
+
+  return options["threads"].as<size_t>();
+}
+
+val Herb_lex_batch(val sources, val options) {
+  std::vector<std::string> strings = vecFromJSArray<std::string>(sources);
+  std::vector<herb_source_T> batch = BatchSources(strings);
+  std::vector<hb_array_T*> tokens(batch.size());
+
+  herb_lex_batch(batch.data(), batch.size(), ReadThreadCount(options), tokens.data());
+
+  val results = val::array();
+
+  for (size_t i = 0; i < batch.size(); i++) {
+    results.call<void>("push", CreateLexResult(tokens[i], strings[i]));
+    herb_free_tokens(&tokens[i]);
+  }
+
+  return results;
+}
+
+val Herb_parse_batch(val sources, val options) {
+  std::vector<std::string> strings = vecFromJSArray<std::string>(sources);
+  std::vector<herb_source_T> batch = BatchSources(strings);
+  std::vector<AST_DOCUMENT_NODE_T*> documents(batch.size());
+
+  parser_options_T* parser_options = nullptr;
+  parser_options_T opts = {0};
+  std::chrono::steady_clock::time_point deadline;
+  double timeout_ms = -1;
+
+  if (ReadParserOptions(options, &opts, &timeout_ms)) {
+    if (timeout_ms >= 0) { StartParseDeadline(&opts, timeout_ms, &deadline); }
+
+    parser_options = &opts;
+  }
+
+  herb_parse_batch(batch.data(), batch.size(), parser_options, ReadThreadCount(options), documents.data());
+
+  val results = val::array();
+
+  for (size_t i = 0; i < batch.size(); i++) {
+    results.call<void>("push", CreateParseResult(documents[i], strings[i]));
+    ast_node_free((AST_NODE_T *) documents[i]);
+  }
+
+  return results;
+}
+
 std::string Herb_extract_ruby(const std::string& source) {
   hb_buffer_T output;
   hb_buffer_init(&output, source.length());
 
-  herb_extract_ruby_to_buffer(source.c_str(), &output);
-  std::string result(hb_buffer_value(&output));
+  herb_extract_ruby_to_buffer_n(source.data(), source.length(), &output);
+  std::string result(hb_buffer_value(&output), hb_buffer_length(&output));
   free(output.value);
   return result;
 }
@@ -73,8 +219,8 @@ std::string Herb_extract_html(const std::string& source) {
   hb_buffer_T output;
   hb_buffer_init(&output, source.length());
 
-  herb_extract_html_to_buffer(source.c_str(), &output);
-  std::string result(hb_buffer_value(&output));
+  herb_extract_html_to_buffer_n(source.data(), source.length(), &output);
+  std::string result(hb_buffer_value(&output), hb_buffer_length(&output));
   free(output.value);
   return result;
 }
@@ -87,10 +233,150 @@ std::string Herb_version() {
   return version;
 }
 
+// Owns a copy of the source, since the index points into its bytes.
+class LineIndex {
+public:
+  explicit LineIndex(const std::string& source) : source(source), index(line_index_init(this->source.c_str(), this->source.length())) {}
+
+  ~LineIndex() { line_index_free(&index); }
+
+  LineIndex(const LineIndex&) = delete;
+  LineIndex& operator=(const LineIndex&) = delete;
+
+  uint32_t lineCount() const { return line_index_line_count(ensureIndex()); }
+
+  uint32_t lineStart(uint32_t line) const { return line_index_line_start(ensureIndex(), line); }
+
+  val positionAt(uint32_t offset) const { return CreatePosition(line_index_position(ensureIndex(), offset)); }
+
+  uint32_t offsetAt(uint32_t line, uint32_t column) const {
+    position_T position = { line, column };
+    return line_index_offset(ensureIndex(), position);
+  }
+
+  val utf16PositionAt(uint32_t offset) const {
+    return CreatePosition(line_index_utf16_position(ensureIndex(), offset));
+  }
+
+  uint32_t offsetAtUtf16(uint32_t line, uint32_t column) const {
+    position_T position = { line, column };
+    return line_index_offset_from_utf16(ensureIndex(), position);
+  }
+
+  void free() {
+    line_index_free(&index);
+    source.clear();
+    source.shrink_to_fit();
+  }
+
+private:
+  std::string source;
+  line_index_T* index;
+
+  const line_index_T* ensureIndex() const {
+    if (!index) { val::global("Error").new_(std::string("LineIndex has been freed")).throw_(); }
+
+    return index;
+  }
+};
+
+LineIndex* Herb_line_index(const std::string& source) {
+  return new LineIndex(source);
+}
+
+// Parses successive versions of a document, reusing what each edit left intact, see herb_reparse_n().
+// Owns a copy of the current source, since the document's tokens point into its bytes.
+class IncrementalParser {
+public:
+  explicit IncrementalParser(val options) { ReadParserOptions(options, &parser_options, &timeout_ms); }
+
+  ~IncrementalParser() { free(); }
+
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+  val parse(const std::string& next_source) {
+    parser_options_T options = parser_options;
+    std::chrono::steady_clock::time_point deadline;
+
+    if (timeout_ms >= 0) { StartParseDeadline(&options, timeout_ms, &deadline); }
+
+    std::string previous_source = std::move(source);
+    source = next_source;
+
+    if (document == nullptr) {
+      document = herb_parse_n(source.data(), source.length(), &options);
+      herb_analyze_parse_tree_cancellable_n(
+        document,
+        source.data(),
+        source.length(),
+        options.cancel,
+        options.cancel_data
+      );
+    } else {
+      herb_edit_T edit = herb_edit_from_sources(
+        previous_source.data(),
+        previous_source.length(),
+        source.data(),
+        source.length()
+      );
+
+      document = herb_reparse_n(
+        document,
+        previous_source.data(),
+        previous_source.length(),
+        source.data(),
+        source.length(),
+        edit,
+        &options
+      );
+    }
+
+    return CreateParseResult(document, source);
+  }
+
+  void free() {
+    ast_node_free((AST_NODE_T*) document);
+    document = nullptr;
+
+    source.clear();
+    source.shrink_to_fit();
+  }
+
+private:
+  std::string source;
+  AST_DOCUMENT_NODE_T* document = nullptr;
+  parser_options_T parser_options = {0};
+  double timeout_ms = -1;
+};
+
+IncrementalParser* Herb_incremental_parser(val options) {
+  return new IncrementalParser(options);
+}
+
 EMSCRIPTEN_BINDINGS(herb_module) {
+  class_<LineIndex>("LineIndex")
+    .function("lineCount", &LineIndex::lineCount)
+    .function("lineStart", &LineIndex::lineStart)
+    .function("positionAt", &LineIndex::positionAt)
+    .function("offsetAt", &LineIndex::offsetAt)
+    .function("utf16PositionAt", &LineIndex::utf16PositionAt)
+    .function("offsetAtUtf16", &LineIndex::offsetAtUtf16)
+    .function("free", &LineIndex::free);
+
+  class_<IncrementalParser>("IncrementalParser")
+    .function("parse", &IncrementalParser::parse)
+    .function("free", &IncrementalParser::free);
+
+
   function("lex", &Herb_lex);
   function("parse", &Herb_parse);
+  function("parseSerialized", &Herb_parse_serialized);
+  function("lexBatch", &Herb_lex_batch);
+  function("parseBatch", &Herb_parse_batch);
   function("extractRuby", &Herb_extract_ruby);
   function("extractHTML", &Herb_extract_html);
+  function("lineIndex", &Herb_line_index, allow_raw_pointers());
+  function("incrementalParser", &Herb_incremental_parser, allow_raw_pointers());
   function("version", &Herb_version);
 }